@@ -1026,6 +1026,19 @@ const Path &GetExeDirectory() {
 	return ExePath;
 }
 
+Path GetTempDir() {
+#ifdef _WIN32
+	wchar_t temp_path[MAX_PATH + 1];
+	DWORD len = GetTempPathW(MAX_PATH + 1, temp_path);
+	if (len != 0 && len <= MAX_PATH)
+		return Path(std::wstring(temp_path, len));
+	return Path(".");
+#else
+	const char *tmpdir = getenv("TMPDIR");
+	return Path(tmpdir && *tmpdir ? tmpdir : "/tmp");
+#endif
+}
+
 
 IOFile::IOFile(const Path &filename, const char openmode[]) {
 	Open(filename, openmode);
@@ -123,6 +123,9 @@ bool OpenFileInEditor(const Path &fileName);
 // TODO: Belongs in System or something.
 const Path &GetExeDirectory();
 
+// Where to put short-lived scratch files, like the ones tests write.
+Path GetTempDir();
+
 // simple wrapper for cstdlib file functions to
 // hopefully will make error checking easier
 // and make forgetting an fclose() harder
@@ -15,7 +15,15 @@
 #include "Common/File/VFS/ZipFileReader.h"
 #include "Common/StringUtils.h"
 
-ZipFileReader *ZipFileReader::Create(const Path &zipFile, const char *inZipPath, bool logErrors) {
+// ZIP_FL_NOCASE only folds ASCII, so this matches it.
+static std::string LowerCaseName(const char *name) {
+	std::string lower = name;
+	for (char &c : lower)
+		c = tolower((unsigned char)c);
+	return lower;
+}
+
+zip *ZipFileReader::OpenZip(const Path &zipFile, bool logErrors) {
 	int error = 0;
 	zip *zip_file;
 	if (zipFile.Type() == PathType::CONTENT_URI) {
@@ -37,18 +45,62 @@ ZipFileReader *ZipFileReader::Create(const Path &zipFile, const char *inZipPath,
 		}
 		return nullptr;
 	}
+	return zip_file;
+}
+
+ZipFileReader *ZipFileReader::Create(const Path &zipFile, const char *inZipPath, bool logErrors) {
+	zip *zip_file = OpenZip(zipFile, logErrors);
+	if (!zip_file)
+		return nullptr;
 
 	ZipFileReader *reader = new ZipFileReader();
+	reader->zipPath_ = zipFile;
 	reader->zip_file_ = zip_file;
 	truncate_cpy(reader->inZipPath_, inZipPath);
+	reader->BuildIndex();
 	return reader;
 }
 
 ZipFileReader::~ZipFileReader() {
 	std::lock_guard<std::mutex> guard(lock_);
+	for (zip *handle : readHandles_)
+		zip_discard(handle);
+	readHandles_.clear();
 	zip_close(zip_file_);
 }
 
+void ZipFileReader::BuildIndex() {
+	// zip_name_locate() with ZIP_FL_NOCASE is a linear search, which adds up with large texture packs.
+	zip_int64_t numFiles = zip_get_num_entries(zip_file_, 0);
+	index_.reserve((size_t)std::max(numFiles, (zip_int64_t)0));
+	for (zip_int64_t i = 0; i < numFiles; i++) {
+		const char *name = zip_get_name(zip_file_, i, 0);
+		if (!name)
+			continue;
+		// Like zip_name_locate(), the first match wins.
+		index_.emplace(LowerCaseName(name), (int)i);
+	}
+}
+
+zip *ZipFileReader::AcquireReadHandle() {
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		if (!readHandles_.empty()) {
+			zip *handle = readHandles_.back();
+			readHandles_.pop_back();
+			return handle;
+		}
+	}
+
+	// Entry indices are the same, since it's the same file.
+	return OpenZip(zipPath_, false);
+}
+
+void ZipFileReader::ReleaseReadHandle(zip *handle) {
+	std::lock_guard<std::mutex> guard(lock_);
+	readHandles_.push_back(handle);
+}
+
 uint8_t *ZipFileReader::ReadFile(const char *path, size_t *size) {
 	char temp_path[2048];
 	snprintf(temp_path, sizeof(temp_path), "%s%s", inZipPath_, path);
@@ -202,17 +254,19 @@ class ZipFileReaderOpenFile : public VFSOpenFile {
 	}
 	ZipFileReaderFileReference *reference;
 	zip_file_t *zf = nullptr;
+	// The handle zf was opened from.  If this is the shared zip_file_, lock_ is held until close.
+	zip *handle = nullptr;
+	bool holdsLock = false;
 };
 
 VFSFileReference *ZipFileReader::GetFile(const char *path) {
-	std::lock_guard<std::mutex> guard(lock_);
-	int zi = zip_name_locate(zip_file_, path, ZIP_FL_NOCASE);
-	if (zi < 0) {
+	auto it = index_.find(LowerCaseName(path));
+	if (it == index_.end()) {
 		// Not found.
 		return nullptr;
 	}
 	ZipFileReaderFileReference *ref = new ZipFileReaderFileReference();
-	ref->zi = zi;
+	ref->zi = it->second;
 	return ref;
 }
 
@@ -239,27 +293,45 @@ void ZipFileReader::ReleaseFile(VFSFileReference *vfsReference) {
 
 VFSOpenFile *ZipFileReader::OpenFileForRead(VFSFileReference *vfsReference, size_t *size) {
 	ZipFileReaderFileReference *reference = (ZipFileReaderFileReference *)vfsReference;
-	ZipFileReaderOpenFile *openFile = new ZipFileReaderOpenFile();
-	openFile->reference = reference;
 	*size = 0;
-	// We only allow one file to be open for read concurrently. It's possible that this can be improved,
-	// especially if we only access by index like this.
-	lock_.lock();
+
+	// Each open file gets its own handle if possible, so reads can happen in parallel.
+	zip *handle = AcquireReadHandle();
+	bool holdsLock = false;
+	if (!handle) {
+		// Probably out of file descriptors.  Fall back to the shared handle, one file at a time.
+		lock_.lock();
+		handle = zip_file_;
+		holdsLock = true;
+	}
+
+	auto release = [&]() {
+		if (holdsLock)
+			lock_.unlock();
+		else
+			ReleaseReadHandle(handle);
+	};
+
 	zip_stat_t zstat;
-	if (zip_stat_index(zip_file_, reference->zi, 0, &zstat) != 0) {
-		lock_.unlock();
+	if (zip_stat_index(handle, reference->zi, 0, &zstat) != 0) {
+		release();
 		return nullptr;
 	}
 
-	openFile->zf = zip_fopen_index(zip_file_, reference->zi, 0);
-	if (!openFile->zf) {
+	zip_file_t *zf = zip_fopen_index(handle, reference->zi, 0);
+	if (!zf) {
 		WARN_LOG(G3D, "File with index %d not found in zip", reference->zi);
-		lock_.unlock();
+		release();
 		return nullptr;
 	}
 
+	ZipFileReaderOpenFile *openFile = new ZipFileReaderOpenFile();
+	openFile->reference = reference;
+	openFile->zf = zf;
+	openFile->handle = handle;
+	openFile->holdsLock = holdsLock;
 	*size = zstat.size;
-	// Intentionally leaving the mutex locked, will be closed in CloseFile.
+	// If holdsLock, intentionally leaving the mutex locked, will be unlocked in CloseFile.
 	return openFile;
 }
 
@@ -267,7 +339,7 @@ void ZipFileReader::Rewind(VFSOpenFile *vfsOpenFile) {
 	ZipFileReaderOpenFile *openFile = (ZipFileReaderOpenFile *)vfsOpenFile;
 	// Close and re-open.
 	zip_fclose(openFile->zf);
-	openFile->zf = zip_fopen_index(zip_file_, openFile->reference->zi, 0);
+	openFile->zf = zip_fopen_index(openFile->handle, openFile->reference->zi, 0);
 }
 
 size_t ZipFileReader::Read(VFSOpenFile *vfsOpenFile, void *buffer, size_t length) {
@@ -280,6 +352,9 @@ void ZipFileReader::CloseFile(VFSOpenFile *vfsOpenFile) {
 	_dbg_assert_(file->zf != nullptr);
 	zip_fclose(file->zf);
 	file->zf = nullptr;
-	lock_.unlock();
+	if (file->holdsLock)
+		lock_.unlock();
+	else
+		ReleaseReadHandle(file->handle);
 	delete file;
 }
@@ -9,6 +9,8 @@
 #include <mutex>
 #include <set>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "Common/File/VFS/VFS.h"
 #include "Common/File/FileUtil.h"
@@ -40,9 +42,21 @@ class ZipFileReader : public VFSBackend {
 	}
 
 private:
+	static zip *OpenZip(const Path &zipFile, bool logErrors);
 	void GetZipListings(const char *path, std::set<std::string> &files, std::set<std::string> &directories);
+	void BuildIndex();
 
+	zip *AcquireReadHandle();
+	void ReleaseReadHandle(zip *handle);
+
+	Path zipPath_;
+	// Used for listings and stats.  Protected by lock_.
 	zip *zip_file_ = nullptr;
 	std::mutex lock_;
+	// Extra handles to the same zip, each with its own file position and inflate state,
+	// so different files can be read at the same time.  Idle ones kept here, protected by lock_.
+	std::vector<zip *> readHandles_;
+	// Lowercase name -> index, built once on open.  Immutable after that, so no lock needed.
+	std::unordered_map<std::string, int> index_;
 	char inZipPath_[256];
 };
@@ -1568,6 +1568,13 @@ bool GLSLtoSPV(const VkShaderStageFlagBits shader_type, const char *sourceCode,
 	return true;
 }
 
+std::string GLSLtoSPVVersion() {
+	std::string version;
+	glslang::GetSpirvVersion(version);
+	// Bump the last number when changing the options above.
+	return StringFromFormat("%s, generator %d, options 1", version.c_str(), glslang::GetSpirvGeneratorVersion());
+}
+
 void init_glslang() {
 	glslang::InitializeProcess();
 }
@@ -484,6 +484,8 @@ enum class GLSLVariant {
 };
 
 bool GLSLtoSPV(const VkShaderStageFlagBits shader_type, const char *sourceCode, GLSLVariant variant, std::vector<uint32_t> &spirv, std::string *errorMessage);
+// Identifies the compiler and options behind GLSLtoSPV's output, for caching it.
+std::string GLSLtoSPVVersion();
 
 const char *VulkanColorSpaceToString(VkColorSpaceKHR colorSpace);
 const char *VulkanFormatToString(VkFormat format);
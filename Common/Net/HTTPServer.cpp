@@ -24,11 +24,19 @@
 
 #endif
 
+#if PPSSPP_PLATFORM(LINUX) || PPSSPP_PLATFORM(ANDROID)
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
+#define HTTP_USE_EPOLL 1
+#endif
+
 #if PPSSPP_PLATFORM(UWP)
 #define in6addr_any IN6ADDR_ANY_INIT
 #endif
 
 #include <algorithm>
+#include <cerrno>
+#include <cmath>
 #include <functional>
 
 #include <cstdio>
@@ -41,8 +49,13 @@
 #include "Common/File/FileDescriptor.h"
 
 #include "Common/Buffer.h"
+#include "Common/Common.h"
 #include "Common/Log.h"
+#include "Common/Thread/ThreadUtil.h"
 
+// How long a connection may sit without sending a request before it's dropped.
+static const double PENDING_TIMEOUT = 10.0;
+static const size_t MAX_PENDING = 256;
 
 void NewThreadExecutor::Run(std::function<void()> func) {
 	threads_.push_back(std::thread(func));
@@ -55,6 +68,63 @@ NewThreadExecutor::~NewThreadExecutor() {
 	threads_.clear();
 }
 
+void PooledExecutor::Run(std::function<void()> func) {
+	std::lock_guard<std::mutex> guard(lock_);
+	for (std::thread::id id : exited_) {
+		auto it = std::find_if(threads_.begin(), threads_.end(), [&](const std::thread &t) {
+			return t.get_id() == id;
+		});
+		if (it != threads_.end()) {
+			it->join();
+			threads_.erase(it);
+		}
+	}
+	exited_.clear();
+
+	queue_.push_back(func);
+	if (idle_ >= (int)queue_.size()) {
+		cond_.notify_one();
+	} else {
+		threads_.push_back(std::thread(&PooledExecutor::WorkerLoop, this));
+	}
+}
+
+PooledExecutor::~PooledExecutor() {
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		stopping_ = true;
+		cond_.notify_all();
+	}
+	for (auto &thread : threads_)
+		thread.join();
+	threads_.clear();
+}
+
+void PooledExecutor::WorkerLoop() {
+	SetCurrentThreadName("HTTPWorker");
+
+	std::unique_lock<std::mutex> guard(lock_);
+	while (true) {
+		if (queue_.empty()) {
+			if (stopping_ || idle_ >= maxIdle_)
+				break;
+			idle_++;
+			cond_.wait(guard);
+			idle_--;
+			continue;
+		}
+
+		std::function<void()> func = std::move(queue_.front());
+		queue_.pop_front();
+		guard.unlock();
+		func();
+		guard.lock();
+	}
+
+	if (!stopping_)
+		exited_.push_back(std::this_thread::get_id());
+}
+
 namespace http {
 
 // Note: charset here helps prevent XSS.
@@ -123,6 +193,52 @@ void Request::WriteHttpResponseHeader(const char *ver, int status, int64_t size,
 	buffer->Push("\r\n");
 }
 
+bool Request::WriteFileRange(FILE *fp, int64_t offset, int64_t len) const {
+	if (!out_->Flush())
+		return false;
+
+	int64_t left = len;
+#if HTTP_USE_EPOLL
+	// Without a 64-bit off_t, only the start of large files can be reached this way.
+	if (sizeof(off_t) >= 8 || offset + len <= 0x7FFFFFFF) {
+		off_t pos = (off_t)offset;
+		while (left > 0) {
+			ssize_t sent = sendfile(fd_, fileno(fp), &pos, (size_t)std::min(left, (int64_t)0x40000000));
+			if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+				if (!fd_util::WaitUntilReady(fd_, 5.0, true))
+					return false;
+				continue;
+			} else if (sent < 0 && errno == EINTR) {
+				continue;
+			} else if (sent < 0 && left == len && (errno == EINVAL || errno == ENOSYS)) {
+				// Not supported for this kind of file, do it the slow way.
+				break;
+			} else if (sent <= 0) {
+				ERROR_LOG(IO, "sendfile failed: %d", errno);
+				return false;
+			}
+			left -= sent;
+		}
+		if (left == 0)
+			return true;
+	}
+#endif
+
+	if (fseek(fp, offset, SEEK_SET) != 0)
+		return false;
+
+	const size_t CHUNK_SIZE = 16 * 1024;
+	char *buf = new char[CHUNK_SIZE];
+	bool success = true;
+	while (left > 0 && success) {
+		size_t chunklen = (size_t)std::min(left, (int64_t)CHUNK_SIZE);
+		success = fread(buf, chunklen, 1, fp) == 1 && out_->Push(buf, chunklen);
+		left -= chunklen;
+	}
+	delete[] buf;
+	return out_->Flush() && success;
+}
+
 void Request::WritePartial() const {
 	_assert_(fd_);
 	out_->Flush();
@@ -141,7 +257,7 @@ void Request::Close() {
 	}
 }
 
-Server::Server(NewThreadExecutor *executor)
+Server::Server(Executor *executor)
 	: port_(0), executor_(executor) {
 	RegisterHandler("/", std::bind(&Server::HandleListing, this, std::placeholders::_1));
 	SetFallbackHandler(std::bind(&Server::Handle404, this, std::placeholders::_1));
@@ -276,10 +392,94 @@ bool Server::RunSlice(double timeout) {
 	if (timeout <= 0.0) {
 		timeout = 86400.0;
 	}
-	if (!fd_util::WaitUntilReady(listener_, timeout, false)) {
-		return false;
+	return DispatchReady(timeout);
+}
+
+bool Server::DispatchReady(double timeout) {
+	double now = time_now_d();
+	// Don't sleep past the first deadline.
+	for (const PendingConnection &conn : pending_) {
+		timeout = std::min(timeout, std::max(conn.deadline - now, 0.0));
+	}
+
+	bool listenerReady = false;
+	std::vector<int> ready;
+	bool waited = false;
+#if HTTP_USE_EPOLL
+	if (epoll_ < 0) {
+		epoll_ = epoll_create1(EPOLL_CLOEXEC);
+		epoll_event ev{};
+		ev.events = EPOLLIN;
+		ev.data.fd = listener_;
+		if (epoll_ >= 0 && epoll_ctl(epoll_, EPOLL_CTL_ADD, listener_, &ev) != 0) {
+			close(epoll_);
+			epoll_ = -1;
+		}
+	}
+	if (epoll_ >= 0) {
+		epoll_event events[64];
+		int count = epoll_wait(epoll_, events, ARRAY_SIZE(events), (int)(timeout * 1000.0));
+		for (int i = 0; i < count; ++i) {
+			if (events[i].data.fd == listener_)
+				listenerReady = true;
+			else
+				ready.push_back(events[i].data.fd);
+		}
+		waited = true;
+	}
+#endif
+	if (!waited) {
+		struct timeval tv;
+		tv.tv_sec = (long)floor(timeout);
+		tv.tv_usec = (long)((timeout - floor(timeout)) * 1000000.0);
+
+		fd_set fds;
+		FD_ZERO(&fds);
+		FD_SET(listener_, &fds);
+		int maxfd = listener_;
+		for (const PendingConnection &conn : pending_) {
+			FD_SET(conn.fd, &fds);
+			maxfd = std::max(maxfd, conn.fd);
+		}
+		if (select(maxfd + 1, &fds, nullptr, nullptr, &tv) > 0) {
+			listenerReady = FD_ISSET(listener_, &fds) != 0;
+			for (const PendingConnection &conn : pending_) {
+				if (FD_ISSET(conn.fd, &fds))
+					ready.push_back(conn.fd);
+			}
+		}
 	}
 
+	bool handled = false;
+	now = time_now_d();
+	for (size_t i = 0; i < pending_.size(); ) {
+		const PendingConnection conn = pending_[i];
+		bool isReady = std::find(ready.begin(), ready.end(), conn.fd) != ready.end();
+		if (!isReady && conn.deadline > now) {
+			++i;
+			continue;
+		}
+
+		pending_.erase(pending_.begin() + i);
+#if HTTP_USE_EPOLL
+		if (epoll_ >= 0)
+			epoll_ctl(epoll_, EPOLL_CTL_DEL, conn.fd, nullptr);
+#endif
+		if (isReady) {
+			executor_->Run(std::bind(&Server::HandleConnection, this, conn.fd));
+			handled = true;
+		} else {
+			VERBOSE_LOG(IO, "Dropping connection without a request");
+			closesocket(conn.fd);
+		}
+	}
+
+	if (listenerReady && AcceptConnection())
+		handled = true;
+	return handled;
+}
+
+bool Server::AcceptConnection() {
 	union {
 		struct sockaddr sa;
 		struct sockaddr_in ipv4;
@@ -289,14 +489,36 @@ bool Server::RunSlice(double timeout) {
 	} client_addr;
 	socklen_t client_addr_size = sizeof(client_addr);
 	int conn_fd = accept(listener_, &client_addr.sa, &client_addr_size);
-	if (conn_fd >= 0) {
-		executor_->Run(std::bind(&Server::HandleConnection, this, conn_fd));
-		return true;
-	}
-	else {
+	if (conn_fd < 0) {
 		ERROR_LOG(IO, "socket accept failed: %i", conn_fd);
 		return false;
 	}
+
+	// Wait for the request here rather than on a thread, unless there's no room to.
+	bool canWait = pending_.size() < MAX_PENDING;
+#if HTTP_USE_EPOLL
+	if (canWait && epoll_ >= 0) {
+		epoll_event ev{};
+		ev.events = EPOLLIN;
+		ev.data.fd = conn_fd;
+		canWait = epoll_ctl(epoll_, EPOLL_CTL_ADD, conn_fd, &ev) == 0;
+	} else
+#endif
+	{
+#if PPSSPP_PLATFORM(WINDOWS)
+		// On Windows, FD_SETSIZE is a count of sockets.
+		canWait = canWait && pending_.size() + 1 < FD_SETSIZE;
+#else
+		canWait = canWait && conn_fd < FD_SETSIZE;
+#endif
+	}
+
+	if (canWait) {
+		pending_.push_back({ conn_fd, time_now_d() + PENDING_TIMEOUT });
+	} else {
+		executor_->Run(std::bind(&Server::HandleConnection, this, conn_fd));
+	}
+	return true;
 }
 
 bool Server::Run(int port) {
@@ -314,6 +536,16 @@ bool Server::Run(int port) {
 
 void Server::Stop() {
 	closesocket(listener_);
+	for (const PendingConnection &conn : pending_) {
+		closesocket(conn.fd);
+	}
+	pending_.clear();
+#if HTTP_USE_EPOLL
+	if (epoll_ >= 0) {
+		close(epoll_);
+		epoll_ = -1;
+	}
+#endif
 }
 
 void Server::HandleConnection(int conn_fd) {
@@ -1,19 +1,53 @@
 #pragma once
 
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
 #include <functional>
 #include <map>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 #include "Common/Net/HTTPHeaders.h"
 #include "Common/Net/Resolve.h"
 
-class NewThreadExecutor {
+class Executor {
+public:
+	virtual ~Executor() {}
+	virtual void Run(std::function<void()> func) = 0;
+};
+
+class NewThreadExecutor : public Executor {
 public:
 	~NewThreadExecutor();
-	void Run(std::function<void()> func);
+	void Run(std::function<void()> func) override;
+
+private:
+	std::vector<std::thread> threads_;
+};
+
+// Reuses threads between connections.  Most requests (like remote ISO range reads) are short,
+// so a few threads serve any number of clients.  Long lived ones (like WebSockets) occupy a
+// thread each, so more are started when all are busy, and idle ones beyond maxIdle exit.
+class PooledExecutor : public Executor {
+public:
+	PooledExecutor(int maxIdle = 4) : maxIdle_(maxIdle) {}
+	~PooledExecutor();
+	void Run(std::function<void()> func) override;
 
 private:
+	void WorkerLoop();
+
+	std::mutex lock_;
+	std::condition_variable cond_;
+	std::deque<std::function<void()>> queue_;
 	std::vector<std::thread> threads_;
+	// Ids of workers that exited, so their threads can be joined.
+	std::vector<std::thread::id> exited_;
+	int maxIdle_;
+	int idle_ = 0;
+	bool stopping_ = false;
 };
 
 namespace net {
@@ -58,6 +92,10 @@ class Request {
 
 	bool IsOK() const { return fd_ > 0; }
 
+	// Sends len bytes of fp starting at offset, after whatever was already pushed to Out().
+	// Uses sendfile() where available, so the data doesn't pass through userspace.
+	bool WriteFileRange(FILE *fp, int64_t offset, int64_t len) const;
+
 	// If size is negative, no Content-Length: line is written.
 	void WriteHttpResponseHeader(const char *ver, int status, int64_t size = -1, const char *mimeType = nullptr, const char *otherHeaders = nullptr) const;
 
@@ -72,7 +110,7 @@ class Request {
 class Server {
 public:
 	// Takes ownership.
-	Server(NewThreadExecutor *executor);
+	Server(Executor *executor);
 	virtual ~Server();
 
 	typedef std::function<void(const Request &)> UrlHandlerFunc;
@@ -105,6 +143,15 @@ class Server {
 	bool Listen4(int port);
 
 	void HandleConnection(int conn_fd);
+	bool AcceptConnection();
+	// Waits for new connections and requests, and hands connections that have sent something
+	// to the executor.  Returns true if any were.
+	bool DispatchReady(double timeout);
+
+	struct PendingConnection {
+		int fd;
+		double deadline;
+	};
 
 	// Things like default 404, etc.
 	void HandleRequestDefault(const Request &request);
@@ -115,11 +162,15 @@ class Server {
 
 	int listener_;
 	int port_ = 0;
+	// Accepted, but no request yet.  Waited on here so idle clients don't hold a thread.
+	std::vector<PendingConnection> pending_;
+	// Only used where epoll is available.
+	int epoll_ = -1;
 
 	UrlHandlerMap handlers_;
 	UrlHandlerFunc fallback_;
 
-	NewThreadExecutor *executor_;
+	Executor *executor_;
 };
 
 }  // namespace http
@@ -63,6 +63,11 @@ class WebSocketServer {
 	bool IsOpen() {
 		return open_;
 	}
+	// True when more is queued than the socket buffer holds, i.e. the client isn't keeping up.
+	// Streaming senders should skip updates rather than queue more.
+	bool IsBackedUp() const {
+		return !outBuf_.empty();
+	}
 	WebSocketClose CloseReason() {
 		return closeReason_;
 	}
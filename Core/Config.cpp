@@ -882,6 +882,8 @@ static const ConfigSetting graphicsSettings[] = {
 	ReportedConfigSetting("TexScalingType", &g_Config.iTexScalingType, 0, true, true),
 	ReportedConfigSetting("TexDeposterize", &g_Config.bTexDeposterize, false, true, true),
 	ReportedConfigSetting("TexHardwareScaling", &g_Config.bTexHardwareScaling, false, true, true),
+	ConfigSetting("TexScalingDiskCache", &g_Config.bTexScalingDiskCache, false, true, true),
+	ConfigSetting("TexScalingCacheSizeMB", &g_Config.iTexScalingCacheSizeMB, 512, true, true),
 	ConfigSetting("VSyncInterval", &g_Config.bVSync, false, true, true),
 	ReportedConfigSetting("BloomHack", &g_Config.iBloomHack, 0, true, true),
 
@@ -217,6 +217,8 @@ struct Config {
 	int iTexScalingType; // 0 = xBRZ, 1 = Hybrid
 	bool bTexDeposterize;
 	bool bTexHardwareScaling;
+	bool bTexScalingDiskCache;
+	int iTexScalingCacheSizeMB;
 	int iFpsLimit1;
 	int iFpsLimit2;
 	int iAnalogFpsLimit;
@@ -366,6 +366,10 @@ CWCheatEngine::CWCheatEngine(const std::string &gameID) : gameID_(gameID) {
 	filename_ = GetSysDirectory(DIRECTORY_CHEATS) / (gameID_ + ".ini");
 }
 
+// Out of line, since CompiledCheatOp is only defined below.
+CWCheatEngine::~CWCheatEngine() {
+}
+
 void CWCheatEngine::CreateCheatFile() {
 	File::CreateFullPath(GetSysDirectory(DIRECTORY_CHEATS));
 
@@ -393,6 +397,7 @@ void CWCheatEngine::ParseCheats() {
 	// TODO: Report errors.
 
 	cheats_ = parser.GetCheats();
+	CompileCheats();
 }
 
 u32 CWCheatEngine::GetAddress(u32 value) {
@@ -499,6 +504,14 @@ struct CheatOperation {
 	};
 };
 
+// Skips are counted in lines and could land inside a multi-line op, so we decode
+// an op starting at every line, which matches what interpreting on the fly would do.
+struct CompiledCheatOp {
+	CheatOperation op;
+	// Line after the lines the op was decoded from.
+	size_t next;
+};
+
 CheatOperation CWCheatEngine::InterpretNextCwCheat(const CheatCode &cheat, size_t &i) {
 	const CheatLine &line1 = cheat.lines[i++];
 	const uint32_t &arg = line1.part2;
@@ -802,6 +815,35 @@ CheatOperation CWCheatEngine::InterpretNextOp(const CheatCode &cheat, size_t &i)
 	}
 }
 
+void CWCheatEngine::CompileCheats() {
+	compiled_.clear();
+	compiled_.resize(cheats_.size());
+	for (size_t c = 0; c < cheats_.size(); ++c) {
+		const CheatCode &cheat = cheats_[c];
+		std::vector<CompiledCheatOp> &ops = compiled_[c];
+		ops.reserve(cheat.lines.size());
+		for (size_t line = 0; line < cheat.lines.size(); ++line) {
+			size_t i = line;
+			CheatOperation op = InterpretNextOp(cheat, i);
+			ops.push_back({ op, i });
+		}
+	}
+}
+
+static bool MemoryEquals(uint32_t addr, int sz, uint32_t val) {
+	// Jit blocks replace their first op in memory, so what we read there isn't the real value.
+	if (MIPS_IS_EMUHACK(Memory::Read_U32(addr & ~3)) || MIPS_IS_EMUHACK(Memory::Read_U32((addr + sz - 1) & ~3)))
+		return false;
+
+	if (sz == 1)
+		return Memory::Read_U8(addr) == (u8)val;
+	else if (sz == 2)
+		return Memory::Read_U16(addr) == (u16)val;
+	else if (sz == 4)
+		return Memory::Read_U32(addr) == val;
+	return false;
+}
+
 void CWCheatEngine::ApplyMemoryOperator(const CheatOperation &op, uint32_t(*oper)(uint32_t, uint32_t)) {
 	if (Memory::IsValidRange(op.addr, op.sz)) {
 		InvalidateICache(op.addr, op.sz);
@@ -864,7 +906,8 @@ void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat,
 		break;
 
 	case CheatOp::Write:
-		if (Memory::IsValidRange(op.addr, op.sz)) {
+		// Most cheats keep writing the same value, which doesn't need an invalidate each time.
+		if (Memory::IsValidRange(op.addr, op.sz) && !MemoryEquals(op.addr, op.sz, op.val)) {
 			InvalidateICache(op.addr, op.sz);
 			if (op.sz == 1)
 				Memory::Write_U8((u8)op.val, op.addr);
@@ -1192,11 +1235,17 @@ void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat,
 }
 
 void CWCheatEngine::Run() {
-	for (CheatCode cheat : cheats_) {
-		// InterpretNextOp and ExecuteOp move i.
+	// Every cheat runs on each cheat event. Guest stores can't be watched without memchecks, which
+	// would push the jit onto its slow path. Re-checking the memory a cheat touches would cost about
+	// as much as running it, since most cheats are constant writes that already skip equal values.
+	for (size_t c = 0; c < cheats_.size(); ++c) {
+		const CheatCode &cheat = cheats_[c];
+		const std::vector<CompiledCheatOp> &ops = compiled_[c];
+		// ExecuteOp may move i further.
 		for (size_t i = 0; i < cheat.lines.size(); ) {
-			CheatOperation op = InterpretNextOp(cheat, i);
-			ExecuteOp(op, cheat, i);
+			const CompiledCheatOp &compiled = ops[i];
+			i = compiled.next;
+			ExecuteOp(compiled.op, cheat, i);
 		}
 	}
 }
@@ -83,17 +83,42 @@ struct PendingNotifyMem {
 	char tag[128];
 };
 
+struct PendingNotifyBuffer {
+	// Only contended while flushing, each thread has its own buffer.
+	std::mutex lock;
+	std::vector<PendingNotifyMem> notifies;
+};
+
+// Registers a buffer for each thread that notifies, so threads don't fight over a shared one.
+class PendingNotifyThreadBuffer {
+public:
+	PendingNotifyThreadBuffer();
+	~PendingNotifyThreadBuffer();
+
+	PendingNotifyBuffer *Get() {
+		return buffer_;
+	}
+
+private:
+	PendingNotifyBuffer *buffer_;
+};
+
 static constexpr size_t MAX_PENDING_NOTIFIES = 512;
 static MemSlabMap allocMap;
 static MemSlabMap suballocMap;
 static MemSlabMap writeMap;
 static MemSlabMap textureMap;
-static std::vector<PendingNotifyMem> pendingNotifies;
 static std::atomic<uint32_t> pendingNotifyMinAddr1;
 static std::atomic<uint32_t> pendingNotifyMaxAddr1;
 static std::atomic<uint32_t> pendingNotifyMinAddr2;
 static std::atomic<uint32_t> pendingNotifyMaxAddr2;
+// Protects the buffer list and the maps.
 static std::mutex pendingMutex;
+static std::vector<PendingNotifyBuffer *> pendingBuffers;
+// Left behind by threads that exited before a flush.
+static std::vector<PendingNotifyMem> pendingOrphanNotifies;
+static std::vector<PendingNotifyMem> pendingFlushNotifies;
+static thread_local PendingNotifyThreadBuffer pendingThreadBuffer;
 static int detailedOverride;
 
 MemSlabMap::MemSlabMap() {
@@ -369,9 +394,49 @@ void MemSlabMap::FillHeads(Slab *slab) {
 	}
 }
 
+PendingNotifyThreadBuffer::PendingNotifyThreadBuffer() {
+	buffer_ = new PendingNotifyBuffer();
+	buffer_->notifies.reserve(MAX_PENDING_NOTIFIES + 1);
+
+	std::lock_guard<std::mutex> guard(pendingMutex);
+	pendingBuffers.push_back(buffer_);
+}
+
+PendingNotifyThreadBuffer::~PendingNotifyThreadBuffer() {
+	std::lock_guard<std::mutex> guard(pendingMutex);
+	pendingOrphanNotifies.insert(pendingOrphanNotifies.end(), buffer_->notifies.begin(), buffer_->notifies.end());
+	pendingBuffers.erase(std::remove(pendingBuffers.begin(), pendingBuffers.end(), buffer_), pendingBuffers.end());
+	delete buffer_;
+}
+
 void FlushPendingMemInfo() {
 	std::lock_guard<std::mutex> guard(pendingMutex);
-	for (auto info : pendingNotifies) {
+
+	// Reset first, so anything notified while we're gathering still triggers the next flush.
+	pendingNotifyMinAddr1 = 0xFFFFFFFF;
+	pendingNotifyMaxAddr1 = 0;
+	pendingNotifyMinAddr2 = 0xFFFFFFFF;
+	pendingNotifyMaxAddr2 = 0;
+
+	pendingFlushNotifies.swap(pendingOrphanNotifies);
+	int sources = pendingFlushNotifies.empty() ? 0 : 1;
+	for (PendingNotifyBuffer *buffer : pendingBuffers) {
+		std::lock_guard<std::mutex> bufferGuard(buffer->lock);
+		if (buffer->notifies.empty())
+			continue;
+		pendingFlushNotifies.insert(pendingFlushNotifies.end(), buffer->notifies.begin(), buffer->notifies.end());
+		buffer->notifies.clear();
+		sources++;
+	}
+
+	// Each buffer is in order, but we need to interleave them so later info wins.
+	if (sources > 1) {
+		std::stable_sort(pendingFlushNotifies.begin(), pendingFlushNotifies.end(), [](const PendingNotifyMem &a, const PendingNotifyMem &b) {
+			return a.ticks < b.ticks;
+		});
+	}
+
+	for (const auto &info : pendingFlushNotifies) {
 		if (info.flags & MemBlockFlags::ALLOC) {
 			allocMap.Mark(info.start, info.size, info.ticks, info.pc, true, info.tag);
 		} else if (info.flags & MemBlockFlags::FREE) {
@@ -392,11 +457,7 @@ void FlushPendingMemInfo() {
 			writeMap.Mark(info.start, info.size, info.ticks, info.pc, true, info.tag);
 		}
 	}
-	pendingNotifies.clear();
-	pendingNotifyMinAddr1 = 0xFFFFFFFF;
-	pendingNotifyMaxAddr1 = 0;
-	pendingNotifyMinAddr2 = 0xFFFFFFFF;
-	pendingNotifyMaxAddr2 = 0;
+	pendingFlushNotifies.clear();
 }
 
 static inline uint32_t NormalizeAddress(uint32_t addr) {
@@ -405,7 +466,7 @@ static inline uint32_t NormalizeAddress(uint32_t addr) {
 	return addr & 0x3FFFFFFF;
 }
 
-static inline bool MergeRecentMemInfo(const PendingNotifyMem &info, size_t copyLength) {
+static inline bool MergeRecentMemInfo(std::vector<PendingNotifyMem> &pendingNotifies, const PendingNotifyMem &info, size_t copyLength) {
 	if (pendingNotifies.size() < 4)
 		return false;
 
@@ -428,6 +489,18 @@ static inline bool MergeRecentMemInfo(const PendingNotifyMem &info, size_t copyL
 	return false;
 }
 
+static inline void ExpandPendingRange(std::atomic<uint32_t> &minAddr, std::atomic<uint32_t> &maxAddr, uint32_t start, uint32_t end) {
+	// Usually already covered, in which case we avoid writing to the shared values at all.
+	uint32_t prev = minAddr.load(std::memory_order_relaxed);
+	while (start < prev && !minAddr.compare_exchange_weak(prev, start)) {
+		continue;
+	}
+	prev = maxAddr.load(std::memory_order_relaxed);
+	while (end > prev && !maxAddr.compare_exchange_weak(prev, end)) {
+		continue;
+	}
+}
+
 void NotifyMemInfoPC(MemBlockFlags flags, uint32_t start, uint32_t size, uint32_t pc, const char *tagStr, size_t strLength) {
 	if (size == 0) {
 		return;
@@ -449,19 +522,18 @@ void NotifyMemInfoPC(MemBlockFlags flags, uint32_t start, uint32_t size, uint32_
 		memcpy(info.tag, tagStr, copyLength);
 		info.tag[copyLength] = 0;
 
-		std::lock_guard<std::mutex> guard(pendingMutex);
+		PendingNotifyBuffer *buffer = pendingThreadBuffer.Get();
+		std::lock_guard<std::mutex> guard(buffer->lock);
 		// Sometimes we get duplicates, quickly check.
-		if (!MergeRecentMemInfo(info, copyLength)) {
+		if (!MergeRecentMemInfo(buffer->notifies, info, copyLength)) {
 			if (start < 0x08000000) {
-				pendingNotifyMinAddr1 = std::min(pendingNotifyMinAddr1.load(), start);
-				pendingNotifyMaxAddr1 = std::max(pendingNotifyMaxAddr1.load(), start + size);
+				ExpandPendingRange(pendingNotifyMinAddr1, pendingNotifyMaxAddr1, start, start + size);
 			} else {
-				pendingNotifyMinAddr2 = std::min(pendingNotifyMinAddr2.load(), start);
-				pendingNotifyMaxAddr2 = std::max(pendingNotifyMaxAddr2.load(), start + size);
+				ExpandPendingRange(pendingNotifyMinAddr2, pendingNotifyMaxAddr2, start, start + size);
 			}
-			pendingNotifies.push_back(info);
+			buffer->notifies.push_back(info);
 		}
-		needFlush = pendingNotifies.size() > MAX_PENDING_NOTIFIES;
+		needFlush = buffer->notifies.size() > MAX_PENDING_NOTIFIES;
 	}
 
 	if (needFlush) {
@@ -563,7 +635,7 @@ size_t FormatMemWriteTagAt(char *buf, size_t sz, const char *prefix, uint32_t st
 
 void MemBlockInfoInit() {
 	std::lock_guard<std::mutex> guard(pendingMutex);
-	pendingNotifies.reserve(MAX_PENDING_NOTIFIES);
+	pendingFlushNotifies.reserve(MAX_PENDING_NOTIFIES * 2);
 	pendingNotifyMinAddr1 = 0xFFFFFFFF;
 	pendingNotifyMaxAddr1 = 0;
 	pendingNotifyMinAddr2 = 0xFFFFFFFF;
@@ -576,7 +648,11 @@ void MemBlockInfoShutdown() {
 	suballocMap.Reset();
 	writeMap.Reset();
 	textureMap.Reset();
-	pendingNotifies.clear();
+	for (PendingNotifyBuffer *buffer : pendingBuffers) {
+		std::lock_guard<std::mutex> bufferGuard(buffer->lock);
+		buffer->notifies.clear();
+	}
+	pendingOrphanNotifies.clear();
 }
 
 void MemBlockInfoDoState(PointerWrap &p) {
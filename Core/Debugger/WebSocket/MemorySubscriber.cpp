@@ -16,32 +16,131 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <mutex>
+#include "ext/xxhash.h"
 #include "Common/Data/Encoding/Base64.h"
 #include "Common/StringUtils.h"
+#include "Common/Swap.h"
 #include "Core/Core.h"
 #include "Core/Debugger/WebSocket/MemorySubscriber.h"
 #include "Core/Debugger/WebSocket/WebSocketUtils.h"
 #include "Core/HLE/ReplaceTables.h"
+#include "Core/HW/Display.h"
 #include "Core/MemMap.h"
 #include "Core/MIPS/MIPSDebugInterface.h"
 #include "Core/Reporting.h"
 #include "Core/System.h"
 
+// Binary frames, used by memory.read with binary set and by memory.watch.add, all little endian:
+//  - type: u32, 1 for memory.read, 2 for memory.watch.
+//  - id: u32, watch id or 0 for memory.read.
+//  - count: u32, number of ranges that follow.
+//  - Each range: u32 address, u32 size, then size bytes of data.
+enum class MemoryBinaryType : uint32_t {
+	READ = 1,
+	WATCH = 2,
+};
+
+static const uint32_t WATCH_DEFAULT_GRANULARITY = 1024;
+
+struct MemoryWatch {
+	uint32_t id;
+	uint32_t address;
+	uint32_t size;
+	uint32_t granularity;
+	// One hash per granularity sized chunk, as of the last send.  Empty until the first send.
+	std::vector<uint64_t> hashes;
+};
+
+struct WebSocketMemoryState : public DebuggerSubscriber {
+	WebSocketMemoryState();
+	~WebSocketMemoryState();
+
+	void WatchAdd(DebuggerRequest &req);
+	void WatchRemove(DebuggerRequest &req);
+	void NoteWrite() {
+		forceScan_ = true;
+	}
+
+	void Broadcast(net::WebSocketServer *ws) override;
+
+	static void FlipForwarder(void *thiz);
+
+protected:
+	void SendWatchDelta(net::WebSocketServer *ws, MemoryWatch &watch);
+
+	std::vector<MemoryWatch> watches_;
+	uint32_t nextId_ = 1;
+	// Memory is only rescanned once something could have changed it.
+	std::atomic<bool> flipped_{};
+	bool forceScan_ = false;
+	int lastSteppingCounter_ = -1;
+};
+
 DebuggerSubscriber *WebSocketMemoryInit(DebuggerEventHandlerMap &map) {
-	// No need to bind or alloc state, these are all global.
+	auto p = new WebSocketMemoryState();
 	map["memory.read_u8"] = &WebSocketMemoryReadU8;
 	map["memory.read_u16"] = &WebSocketMemoryReadU16;
 	map["memory.read_u32"] = &WebSocketMemoryReadU32;
 	map["memory.read"] = &WebSocketMemoryRead;
 	map["memory.readString"] = &WebSocketMemoryReadString;
-	map["memory.write_u8"] = &WebSocketMemoryWriteU8;
-	map["memory.write_u16"] = &WebSocketMemoryWriteU16;
-	map["memory.write_u32"] = &WebSocketMemoryWriteU32;
-	map["memory.write"] = &WebSocketMemoryWrite;
+	// Writes while stepping don't flip, so they have to trigger a watch scan themselves.
+	auto noteWrite = [p](void (*func)(DebuggerRequest &req)) {
+		return [p, func](DebuggerRequest &req) {
+			func(req);
+			p->NoteWrite();
+		};
+	};
+	map["memory.write_u8"] = noteWrite(&WebSocketMemoryWriteU8);
+	map["memory.write_u16"] = noteWrite(&WebSocketMemoryWriteU16);
+	map["memory.write_u32"] = noteWrite(&WebSocketMemoryWriteU32);
+	map["memory.write"] = noteWrite(&WebSocketMemoryWrite);
+	map["memory.watch.add"] = std::bind(&WebSocketMemoryState::WatchAdd, p, std::placeholders::_1);
+	map["memory.watch.remove"] = std::bind(&WebSocketMemoryState::WatchRemove, p, std::placeholders::_1);
+
+	return p;
+}
+
+WebSocketMemoryState::WebSocketMemoryState() {
+	__DisplayListenFlip(&WebSocketMemoryState::FlipForwarder, this);
+}
+
+WebSocketMemoryState::~WebSocketMemoryState() {
+	__DisplayForgetFlip(&WebSocketMemoryState::FlipForwarder, this);
+}
+
+void WebSocketMemoryState::FlipForwarder(void *thiz) {
+	WebSocketMemoryState *p = (WebSocketMemoryState *)thiz;
+	p->flipped_ = true;
+}
+
+static void AppendU32(std::vector<uint8_t> &frame, uint32_t value) {
+	u32_le le = value;
+	size_t pos = frame.size();
+	frame.resize(pos + sizeof(le));
+	memcpy(&frame[pos], &le, sizeof(le));
+}
+
+static void AppendRange(std::vector<uint8_t> &frame, uint32_t addr, uint32_t size) {
+	AppendU32(frame, addr);
+	AppendU32(frame, size);
+	size_t pos = frame.size();
+	frame.resize(pos + size);
+	memcpy(&frame[pos], Memory::GetPointerUnchecked(addr), size);
+}
 
-	return nullptr;
+static void BeginBinaryFrame(std::vector<uint8_t> &frame, MemoryBinaryType type, uint32_t id) {
+	AppendU32(frame, (uint32_t)type);
+	AppendU32(frame, id);
+	// Count, filled in by FinishBinaryFrame().
+	AppendU32(frame, 0);
+}
+
+static void FinishBinaryFrame(std::vector<uint8_t> &frame, uint32_t count) {
+	u32_le le = count;
+	memcpy(&frame[8], &le, sizeof(le));
 }
 
 struct AutoDisabledReplacements {
@@ -187,9 +286,13 @@ void WebSocketMemoryReadU32(DebuggerRequest &req) {
 //  - address: unsigned integer address for the start of the memory range.
 //  - size: unsigned integer specifying size of memory range.
 //  - replacements: optional, false to ignore PPSSPP replacements in MIPS code.
+//  - binary: optional, true to receive the data in a binary frame instead of as base64.
 //
 // Response (same event name):
 //  - base64: base64 encode of binary data.
+//
+// Response (same event name) for binary:
+//  - size: number of bytes, sent in a binary frame (type 1, one range) right after this.
 void WebSocketMemoryRead(DebuggerRequest &req) {
 	uint32_t addr;
 	if (!req.ParamU32("address", &addr))
@@ -200,6 +303,9 @@ void WebSocketMemoryRead(DebuggerRequest &req) {
 	bool replacements = true;
 	if (!req.ParamBool("replacements", &replacements, DebuggerParamType::OPTIONAL))
 		return;
+	bool binary = false;
+	if (!req.ParamBool("binary", &binary, DebuggerParamType::OPTIONAL))
+		return;
 
 	auto memLock = LockMemoryAndCPU(addr, replacements);
 	if (!currentDebugMIPS->isAlive() || !Memory::IsActive())
@@ -210,6 +316,21 @@ void WebSocketMemoryRead(DebuggerRequest &req) {
 	else if (!Memory::IsValidRange(addr, size))
 		return req.Fail("Invalid size");
 
+	if (binary) {
+		JsonWriter &json = req.Respond();
+		json.writeUint("size", size);
+		// Must be complete before the binary frame, fragments can't interleave.
+		req.Finish();
+
+		std::vector<uint8_t> frame;
+		frame.reserve(5 * sizeof(uint32_t) + size);
+		BeginBinaryFrame(frame, MemoryBinaryType::READ, 0);
+		AppendRange(frame, addr, size);
+		FinishBinaryFrame(frame, 1);
+		req.ws->Send(frame);
+		return;
+	}
+
 	JsonWriter &json = req.Respond();
 	// Start a value without any actual data yet...
 	json.writeRaw("base64", "");
@@ -399,3 +520,127 @@ void WebSocketMemoryWrite(DebuggerRequest &req) {
 	Reporting::NotifyDebugger();
 	req.Respond();
 }
+
+// Watch a memory range for changes (memory.watch.add)
+//
+// Parameters:
+//  - address: unsigned integer address for the start of the memory range.
+//  - size: unsigned integer specifying size of memory range.
+//  - granularity: optional power of two from 16 to 65536, size of the chunks compared (default 1024.)
+//
+// Response (same event name):
+//  - id: unsigned integer, identifies the watch in binary frames and for memory.watch.remove.
+//
+// Afterward, binary frames (type 2) are sent whenever something in the range may have changed,
+// each frame or after stepping or writes.  The first has the whole range, the rest only the
+// chunks that changed since, merged into ranges.  Memory is read without stopping the CPU.
+void WebSocketMemoryState::WatchAdd(DebuggerRequest &req) {
+	uint32_t addr;
+	if (!req.ParamU32("address", &addr))
+		return;
+	uint32_t size;
+	if (!req.ParamU32("size", &size))
+		return;
+	uint32_t granularity = WATCH_DEFAULT_GRANULARITY;
+	if (!req.ParamU32("granularity", &granularity, false, DebuggerParamType::OPTIONAL))
+		return;
+
+	if (!PSP_IsInited() || !Memory::IsActive())
+		return req.Fail("CPU not started");
+	if (!Memory::IsValidAddress(addr))
+		return req.Fail("Invalid address");
+	else if (size == 0 || !Memory::IsValidRange(addr, size))
+		return req.Fail("Invalid size");
+	if (granularity < 16 || granularity > 65536 || (granularity & (granularity - 1)) != 0)
+		return req.Fail("Invalid granularity");
+
+	MemoryWatch watch{ nextId_++, addr, size, granularity };
+	watches_.push_back(watch);
+	forceScan_ = true;
+
+	JsonWriter &json = req.Respond();
+	json.writeUint("id", watch.id);
+}
+
+// Stop watching a memory range (memory.watch.remove)
+//
+// Parameters:
+//  - id: unsigned integer, from memory.watch.add.
+//
+// Response (same event name) with no extra data.
+void WebSocketMemoryState::WatchRemove(DebuggerRequest &req) {
+	uint32_t id;
+	if (!req.ParamU32("id", &id))
+		return;
+
+	auto it = std::find_if(watches_.begin(), watches_.end(), [&](const MemoryWatch &watch) {
+		return watch.id == id;
+	});
+	if (it == watches_.end())
+		return req.Fail("Invalid id");
+	watches_.erase(it);
+
+	req.Respond();
+}
+
+void WebSocketMemoryState::Broadcast(net::WebSocketServer *ws) {
+	// Deltas are against what was last sent, so skipping now just makes the next one bigger.
+	if (ws->IsBackedUp())
+		return;
+
+	int steppingCounter = Core_GetSteppingCounter();
+	bool scan = flipped_.exchange(false) || forceScan_ || steppingCounter != lastSteppingCounter_;
+	lastSteppingCounter_ = steppingCounter;
+	forceScan_ = false;
+	if (!scan || watches_.empty() || !PSP_IsInited())
+		return;
+
+	Memory::MemoryInitedLock memLock;
+	if (!Memory::IsActive())
+		return;
+	for (MemoryWatch &watch : watches_) {
+		// Memory size can change with the game, e.g. for extra memory.
+		if (Memory::IsValidRange(watch.address, watch.size))
+			SendWatchDelta(ws, watch);
+	}
+}
+
+void WebSocketMemoryState::SendWatchDelta(net::WebSocketServer *ws, MemoryWatch &watch) {
+	const uint8_t *base = Memory::GetPointerUnchecked(watch.address);
+	size_t chunks = (watch.size + watch.granularity - 1) / watch.granularity;
+	bool initial = watch.hashes.empty();
+	if (initial)
+		watch.hashes.resize(chunks);
+
+	std::vector<uint8_t> frame;
+	BeginBinaryFrame(frame, MemoryBinaryType::WATCH, watch.id);
+	uint32_t count = 0;
+	uint32_t runStart = 0;
+	bool inRun = false;
+	for (size_t i = 0; i <= chunks; ++i) {
+		bool dirty = false;
+		uint32_t offset = (uint32_t)(i * watch.granularity);
+		if (i < chunks) {
+			uint32_t len = std::min(watch.granularity, watch.size - offset);
+			uint64_t hash = XXH3_64bits(base + offset, len);
+			dirty = initial || hash != watch.hashes[i];
+			watch.hashes[i] = hash;
+		}
+
+		// Neighboring dirty chunks go out as one range.
+		if (dirty && !inRun) {
+			runStart = offset;
+			inRun = true;
+		} else if (!dirty && inRun) {
+			uint32_t runEnd = std::min(offset, watch.size);
+			AppendRange(frame, watch.address + runStart, runEnd - runStart);
+			count++;
+			inRun = false;
+		}
+	}
+
+	if (count != 0) {
+		FinishBinaryFrame(frame, count);
+		ws->Send(frame);
+	}
+}
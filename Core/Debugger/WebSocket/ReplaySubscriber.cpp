@@ -45,7 +45,8 @@ DebuggerSubscriber *WebSocketReplayInit(DebuggerEventHandlerMap &map) {
 //
 // Empty response.
 void WebSocketReplayBegin(DebuggerRequest &req) {
-	ReplayBeginSave();
+	if (!ReplayBeginSave())
+		return req.Fail("Could not read executed replay data");
 	req.Respond();
 }
 
@@ -23,6 +23,8 @@
 #include <mutex>
 #include <cstring>
 
+#include <zstd.h>
+
 #include "Common/Data/Encoding/Utf8.h"
 #include "Common/File/DiskFree.h"
 #include "Common/File/DirListing.h"
@@ -46,6 +48,8 @@ static const char *CACHEFILE_MAGIC = "ppssppDC";
 static const s64 SAFETY_FREE_DISK_SPACE = 768 * 1024 * 1024; // 768 MB
 // Aim to allow this many files cached at once.
 static const u32 CACHE_SPACE_FLEX = 4;
+// Favor speed, this is on the read path.
+static const int CACHE_COMPRESSION_LEVEL = 1;
 
 Path DiskCachingFileLoaderCache::cacheDir_;
 
@@ -170,9 +174,13 @@ DiskCachingFileLoaderCache::~DiskCachingFileLoaderCache() {
 
 void DiskCachingFileLoaderCache::InitCache(const Path &filename) {
 	cacheSize_ = 0;
+	firstFreeSlot_ = 0;
+	decompressedBlock_ = INVALID_BLOCK;
 	indexCount_ = 0;
 	oldestGeneration_ = 0;
 	maxBlocks_ = MAX_BLOCKS_LOWER_BOUND;
+	blockSize_ = DEFAULT_BLOCK_SIZE;
+	slotSize_ = DEFAULT_BLOCK_SIZE / SLOTS_PER_BLOCK;
 	flags_ = 0;
 	generation_ = 0;
 
@@ -220,7 +228,11 @@ void DiskCachingFileLoaderCache::ShutdownCache() {
 
 	index_.clear();
 	blockIndexLookup_.clear();
+	compressBuf_.clear();
+	decompressBuf_.clear();
 	cacheSize_ = 0;
+	firstFreeSlot_ = 0;
+	decompressedBlock_ = INVALID_BLOCK;
 }
 
 size_t DiskCachingFileLoaderCache::ReadFromCache(s64 pos, size_t bytes, void *data) {
@@ -296,9 +308,7 @@ size_t DiskCachingFileLoaderCache::SaveIntoCache(FileLoader *backend, s64 pos, s
 
 		// Check if it was written while we were busy.  Might happen if we thread.
 		if (info.block == INVALID_BLOCK && readBytes != 0) {
-			info.block = AllocateBlock((u32)cacheStartPos);
-			WriteBlockData(info, buf);
-			WriteIndexData((u32)cacheStartPos, info);
+			StoreBlock((u32)cacheStartPos, buf);
 		}
 
 		size_t toRead = std::min(bytes - readSize, (size_t)blockSize_ - offset);
@@ -314,10 +324,8 @@ size_t DiskCachingFileLoaderCache::SaveIntoCache(FileLoader *backend, s64 pos, s
 			auto &info = index_[cacheStartPos + i];
 			// Check if it was written while we were busy.  Might happen if we thread.
 			if (info.block == INVALID_BLOCK && readBytes != 0) {
-				info.block = AllocateBlock((u32)cacheStartPos + (u32)i);
-				WriteBlockData(info, wholeRead + (i * blockSize_));
 				// TODO: Doing each index together would probably be better.
-				WriteIndexData((u32)cacheStartPos + (u32)i, info);
+				StoreBlock((u32)cacheStartPos + (u32)i, wholeRead + (i * blockSize_));
 			}
 
 			size_t toRead = std::min(bytes - readSize, (size_t)blockSize_ - offset);
@@ -327,7 +335,6 @@ size_t DiskCachingFileLoaderCache::SaveIntoCache(FileLoader *backend, s64 pos, s
 		delete[] wholeRead;
 	}
 
-	cacheSize_ += blocksToRead;
 	++generation_;
 
 	if (generation_ == std::numeric_limits<u16>::max()) {
@@ -338,7 +345,8 @@ size_t DiskCachingFileLoaderCache::SaveIntoCache(FileLoader *backend, s64 pos, s
 }
 
 bool DiskCachingFileLoaderCache::MakeCacheSpaceFor(size_t blocks) {
-	size_t goal = (size_t)maxBlocks_ - blocks;
+	// Assume the worst case, that none of them compress.
+	size_t goal = blockIndexLookup_.size() - blocks * SLOTS_PER_BLOCK;
 
 	while (cacheSize_ > goal) {
 		u16 minGeneration = generation_;
@@ -348,7 +356,8 @@ bool DiskCachingFileLoaderCache::MakeCacheSpaceFor(size_t blocks) {
 			if (blockIndexLookup_[i] == INVALID_INDEX) {
 				continue;
 			}
-			auto &info = index_[blockIndexLookup_[i]];
+			u32 indexPos = blockIndexLookup_[i];
+			auto &info = index_[indexPos];
 
 			// Check for the minimum seen generation.
 			// TODO: Do this smarter?
@@ -358,14 +367,8 @@ bool DiskCachingFileLoaderCache::MakeCacheSpaceFor(size_t blocks) {
 
 			// 0 means it was never used yet or was the first read (e.g. block descriptor.)
 			if (info.generation == oldestGeneration_ || info.generation == 0) {
-				info.block = INVALID_BLOCK;
-				info.generation = 0;
-				info.hits = 0;
-				--cacheSize_;
-
 				// TODO: Doing this in chunks might be a lot better.
-				WriteIndexData(blockIndexLookup_[i], info);
-				blockIndexLookup_[i] = INVALID_INDEX;
+				EvictBlock(indexPos);
 
 				// Keep going?
 				if (cacheSize_ <= goal) {
@@ -401,16 +404,101 @@ void DiskCachingFileLoaderCache::RebalanceGenerations() {
 	oldestGeneration_ = 0;
 }
 
-u32 DiskCachingFileLoaderCache::AllocateBlock(u32 indexPos) {
-	for (size_t i = 0; i < blockIndexLookup_.size(); ++i) {
-		if (blockIndexLookup_[i] == INVALID_INDEX) {
-			blockIndexLookup_[i] = indexPos;
-			return (u32)i;
+u32 DiskCachingFileLoaderCache::AllocateSlots(u32 indexPos, u32 count) {
+	const u32 totalSlots = (u32)blockIndexLookup_.size();
+	_dbg_assert_msg_(count <= totalSlots, "Block larger than the cache");
+
+	// Everything before firstFreeSlot_ is in use, so first-fit can start there.
+	u32 start = INVALID_BLOCK;
+	u32 runStart = firstFreeSlot_;
+	for (u32 i = firstFreeSlot_; i < totalSlots; ++i) {
+		if (blockIndexLookup_[i] != INVALID_INDEX) {
+			runStart = i + 1;
+		} else if (i + 1 - runStart == count) {
+			start = runStart;
+			break;
+		}
+	}
+
+	if (start == INVALID_BLOCK) {
+		// Too fragmented.  Take the first free slot and evict whatever is in the way after it.
+		start = std::min(firstFreeSlot_, totalSlots - count);
+		for (u32 i = start; i < start + count; ++i) {
+			if (blockIndexLookup_[i] != INVALID_INDEX) {
+				EvictBlock(blockIndexLookup_[i]);
+			}
 		}
 	}
 
-	_dbg_assert_msg_(false, "Not enough free blocks");
-	return INVALID_BLOCK;
+	for (u32 i = start; i < start + count; ++i) {
+		blockIndexLookup_[i] = indexPos;
+	}
+	cacheSize_ += count;
+	while (firstFreeSlot_ < totalSlots && blockIndexLookup_[firstFreeSlot_] != INVALID_INDEX) {
+		++firstFreeSlot_;
+	}
+	return start;
+}
+
+void DiskCachingFileLoaderCache::EvictBlock(u32 indexPos) {
+	auto &info = index_[indexPos];
+	if (info.block == INVALID_BLOCK) {
+		return;
+	}
+
+	const u32 slots = SlotsForBlock(info);
+	for (u32 i = 0; i < slots; ++i) {
+		blockIndexLookup_[info.block + i] = INVALID_INDEX;
+	}
+	cacheSize_ -= slots;
+	if (slots != 0) {
+		firstFreeSlot_ = std::min(firstFreeSlot_, info.block);
+	}
+	if (info.block == decompressedBlock_) {
+		decompressedBlock_ = INVALID_BLOCK;
+	}
+
+	info.block = INVALID_BLOCK;
+	info.generation = 0;
+	info.hits = 0;
+	info.size = 0;
+	WriteIndexData(indexPos, info);
+}
+
+u32 DiskCachingFileLoaderCache::SlotsForBlock(const BlockInfo &info) const {
+	if (info.block == FILL_BLOCK) {
+		return 0;
+	}
+	return (info.size + slotSize_ - 1) / slotSize_;
+}
+
+void DiskCachingFileLoaderCache::StoreBlock(u32 indexPos, const u8 *src) {
+	auto &info = index_[indexPos];
+	// The last block may run past the end of the file, the rest of src is garbage then.
+	const size_t validSize = (size_t)std::min((s64)blockSize_, filesize_ - (s64)indexPos * (s64)blockSize_);
+
+	// ISOs are full of padding, which doesn't need any space at all.
+	if (std::all_of(src + 1, src + validSize, [src](u8 c) { return c == src[0]; })) {
+		info.block = FILL_BLOCK;
+		info.size = src[0];
+		WriteIndexData(indexPos, info);
+		return;
+	}
+
+	compressBuf_.resize(ZSTD_compressBound(validSize));
+	size_t compressedSize = ZSTD_compress(&compressBuf_[0], compressBuf_.size(), src, validSize, CACHE_COMPRESSION_LEVEL);
+
+	// Only worth it if it saves at least a slot.  This also keeps raw blocks distinguishable by size.
+	const u8 *data = src;
+	info.size = blockSize_;
+	if (!ZSTD_isError(compressedSize) && compressedSize <= blockSize_ - slotSize_) {
+		data = &compressBuf_[0];
+		info.size = (u32)compressedSize;
+	}
+
+	info.block = AllocateSlots(indexPos, SlotsForBlock(info));
+	WriteBlockData(info, data);
+	WriteIndexData(indexPos, info);
 }
 
 std::string DiskCachingFileLoaderCache::MakeCacheFilename(const Path &path) {
@@ -438,11 +526,11 @@ ::Path DiskCachingFileLoaderCache::MakeCacheFilePath(const Path &filename) {
 	return dir / MakeCacheFilename(filename);
 }
 
-s64 DiskCachingFileLoaderCache::GetBlockOffset(u32 block) {
-	// This is where the blocks start.
+s64 DiskCachingFileLoaderCache::GetBlockOffset(u32 slot) {
+	// This is where the slots start.
 	s64 blockOffset = (s64)sizeof(FileHeader) + (s64)indexCount_ * (s64)sizeof(BlockInfo);
-	// Now to the actual block.
-	return blockOffset + (s64)block * (s64)blockSize_;
+	// Now to the first slot of the block.
+	return blockOffset + (s64)slot * (s64)slotSize_;
 }
 
 bool DiskCachingFileLoaderCache::ReadBlockData(u8 *dest, BlockInfo &info, size_t offset, size_t size) {
@@ -452,7 +540,28 @@ bool DiskCachingFileLoaderCache::ReadBlockData(u8 *dest, BlockInfo &info, size_t
 	if (size == 0) {
 		return true;
 	}
+	if (info.block == FILL_BLOCK) {
+		memset(dest, (u8)info.size, size);
+		return true;
+	}
+
+	// Compressed blocks have to be read whole, raw blocks can be read directly.
+	const bool compressed = info.size != blockSize_;
+	if (compressed && info.block == decompressedBlock_ && offset + size <= decompressBuf_.size()) {
+		// Sector reads tend to walk through a block, so this saves decompressing it again each time.
+		memcpy(dest, &decompressBuf_[offset], size);
+		return true;
+	}
 	s64 blockOffset = GetBlockOffset(info.block);
+	u8 *readDest = dest;
+	size_t readSize = size;
+	if (compressed) {
+		compressBuf_.resize(info.size);
+		readDest = &compressBuf_[0];
+		readSize = info.size;
+	} else {
+		blockOffset += offset;
+	}
 
 	// Before we read, make sure the buffers are flushed.
 	// We might be trying to read an area we've recently written.
@@ -462,17 +571,30 @@ bool DiskCachingFileLoaderCache::ReadBlockData(u8 *dest, BlockInfo &info, size_t
 #ifdef __ANDROID__
 	if (lseek64(fd_, blockOffset, SEEK_SET) != blockOffset) {
 		failed = true;
-	} else if (read(fd_, dest + offset, size) != (ssize_t)size) {
+	} else if (read(fd_, readDest, readSize) != (ssize_t)readSize) {
 		failed = true;
 	}
 #else
 	if (fseeko(f_, blockOffset, SEEK_SET) != 0) {
 		failed = true;
-	} else if (fread(dest + offset, size, 1, f_) != 1) {
+	} else if (fread(readDest, readSize, 1, f_) != 1) {
 		failed = true;
 	}
 #endif
 
+	if (!failed && compressed) {
+		decompressBuf_.resize(blockSize_);
+		decompressedBlock_ = INVALID_BLOCK;
+		size_t decompressedSize = ZSTD_decompress(&decompressBuf_[0], blockSize_, &compressBuf_[0], info.size);
+		if (ZSTD_isError(decompressedSize) || decompressedSize < offset + size) {
+			failed = true;
+		} else {
+			memcpy(dest, &decompressBuf_[offset], size);
+			decompressBuf_.resize(decompressedSize);
+			decompressedBlock_ = info.block;
+		}
+	}
+
 	if (failed) {
 		ERROR_LOG(LOADER, "Unable to read disk cache data entry.");
 		CloseFileHandle();
@@ -490,13 +612,13 @@ void DiskCachingFileLoaderCache::WriteBlockData(BlockInfo &info, const u8 *src)
 #ifdef __ANDROID__
 	if (lseek64(fd_, blockOffset, SEEK_SET) != blockOffset) {
 		failed = true;
-	} else if (write(fd_, src, blockSize_) != (ssize_t)blockSize_) {
+	} else if (write(fd_, src, info.size) != (ssize_t)info.size) {
 		failed = true;
 	}
 #else
 	if (fseeko(f_, blockOffset, SEEK_SET) != 0) {
 		failed = true;
-	} else if (fwrite(src, blockSize_, 1, f_) != 1) {
+	} else if (fwrite(src, info.size, 1, f_) != 1) {
 		failed = true;
 	}
 #endif
@@ -543,6 +665,8 @@ bool DiskCachingFileLoaderCache::LoadCacheFile(const Path &path) {
 		valid = false;
 	} else if (header.filesize != filesize_) {
 		valid = false;
+	} else if (header.blockSize == 0 || (header.blockSize % SLOTS_PER_BLOCK) != 0) {
+		valid = false;
 	} else if (header.maxBlocks < MAX_BLOCKS_LOWER_BOUND || header.maxBlocks > MAX_BLOCKS_UPPER_BOUND) {
 		// This means it's not in our safety bounds, reject.
 		valid = false;
@@ -578,8 +702,10 @@ void DiskCachingFileLoaderCache::LoadCacheIndex() {
 
 	indexCount_ = (size_t)((filesize_ + blockSize_ - 1) / blockSize_);
 	index_.resize(indexCount_);
-	blockIndexLookup_.resize(maxBlocks_);
-	memset(&blockIndexLookup_[0], INVALID_INDEX, maxBlocks_ * sizeof(blockIndexLookup_[0]));
+	slotSize_ = blockSize_ / SLOTS_PER_BLOCK;
+	const u32 totalSlots = maxBlocks_ * SLOTS_PER_BLOCK;
+	blockIndexLookup_.resize(totalSlots);
+	memset(&blockIndexLookup_[0], INVALID_INDEX, totalSlots * sizeof(blockIndexLookup_[0]));
 
 	if (fread(&index_[0], sizeof(BlockInfo), indexCount_, f_) != indexCount_) {
 		CloseFileHandle();
@@ -592,22 +718,28 @@ void DiskCachingFileLoaderCache::LoadCacheIndex() {
 	cacheSize_ = 0;
 
 	for (size_t i = 0; i < index_.size(); ++i) {
-		if (index_[i].block > maxBlocks_) {
-			index_[i].block = INVALID_BLOCK;
+		auto &info = index_[i];
+		if (info.block != INVALID_BLOCK && info.block != FILL_BLOCK) {
+			if (info.size == 0 || info.size > blockSize_ || (u64)info.block + SlotsForBlock(info) > totalSlots) {
+				info.block = INVALID_BLOCK;
+			}
 		}
-		if (index_[i].block == INVALID_BLOCK) {
+		if (info.block == INVALID_BLOCK) {
 			continue;
 		}
 
-		if (index_[i].generation < oldestGeneration_) {
-			oldestGeneration_ = index_[i].generation;
+		if (info.generation < oldestGeneration_) {
+			oldestGeneration_ = info.generation;
 		}
-		if (index_[i].generation > generation_) {
-			generation_ = index_[i].generation;
+		if (info.generation > generation_) {
+			generation_ = info.generation;
 		}
-		++cacheSize_;
 
-		blockIndexLookup_[index_[i].block] = (u32)i;
+		const u32 slots = SlotsForBlock(info);
+		for (u32 j = 0; j < slots; ++j) {
+			blockIndexLookup_[info.block + j] = (u32)i;
+		}
+		cacheSize_ += slots;
 	}
 }
 
@@ -653,8 +785,10 @@ void DiskCachingFileLoaderCache::CreateCacheFile(const Path &path) {
 	indexCount_ = (size_t)((filesize_ + blockSize_ - 1) / blockSize_);
 	index_.clear();
 	index_.resize(indexCount_);
-	blockIndexLookup_.resize(maxBlocks_);
-	memset(&blockIndexLookup_[0], INVALID_INDEX, maxBlocks_ * sizeof(blockIndexLookup_[0]));
+	slotSize_ = blockSize_ / SLOTS_PER_BLOCK;
+	const u32 totalSlots = maxBlocks_ * SLOTS_PER_BLOCK;
+	blockIndexLookup_.resize(totalSlots);
+	memset(&blockIndexLookup_[0], INVALID_INDEX, totalSlots * sizeof(blockIndexLookup_[0]));
 
 	if (fwrite(&index_[0], sizeof(BlockInfo), indexCount_, f_) != indexCount_) {
 		CloseFileHandle();
@@ -744,8 +878,8 @@ bool DiskCachingFileLoaderCache::HasData() const {
 		return false;
 	}
 
-	for (size_t i = 0; i < blockIndexLookup_.size(); ++i) {
-		if (blockIndexLookup_[i] != INVALID_INDEX) {
+	for (size_t i = 0; i < index_.size(); ++i) {
+		if (index_[i].block != INVALID_BLOCK) {
 			return true;
 		}
 	}
@@ -91,13 +91,16 @@ class DiskCachingFileLoaderCache {
 	void ShutdownCache();
 	bool MakeCacheSpaceFor(size_t blocks);
 	void RebalanceGenerations();
-	u32 AllocateBlock(u32 indexPos);
+	u32 AllocateSlots(u32 indexPos, u32 count);
+	void EvictBlock(u32 indexPos);
 
 	struct BlockInfo;
 	bool ReadBlockData(u8 *dest, BlockInfo &info, size_t offset, size_t size);
+	void StoreBlock(u32 indexPos, const u8 *src);
 	void WriteBlockData(BlockInfo &info, const u8 *src);
 	void WriteIndexData(u32 indexPos, BlockInfo &info);
-	s64 GetBlockOffset(u32 block);
+	s64 GetBlockOffset(u32 slot);
+	u32 SlotsForBlock(const BlockInfo &info) const;
 
 	Path MakeCacheFilePath(const Path &filename);
 	std::string MakeCacheFilename(const Path &path);
@@ -120,20 +123,26 @@ class DiskCachingFileLoaderCache {
 	// 64 filesize
 	// 32 maxBlocks
 	// 32 flags
-	// index[filesize / blockSize] <-- ~500 KB for 4GB
-	//   32 (fileoffset - headersize) / blockSize -> -1=not present
+	// index[filesize / blockSize] <-- ~750 KB for 4GB
+	//   32 first slot -> -1=not present, -2=uniform fill
 	//   16 generation?
 	//   16 hits?
-	// blocks[up to maxBlocks]
-	//   8 * blockSize
+	//   32 stored size (== blockSize for raw, fill byte for uniform, otherwise zstd)
+	// slots[up to maxBlocks * SLOTS_PER_BLOCK]
+	//   8 * (blockSize / SLOTS_PER_BLOCK)
+	//
+	// Each block is stored in a contiguous run of slots, so compressed blocks
+	// take less of the budget.  Blocks of a single repeated byte (padding) take none.
 
 	enum {
-		CACHE_VERSION = 3,
+		CACHE_VERSION = 4,
 		DEFAULT_BLOCK_SIZE = 65536,
+		SLOTS_PER_BLOCK = 4,
 		MAX_BLOCKS_PER_READ = 16,
 		MAX_BLOCKS_LOWER_BOUND = 256, // 16 MB
 		MAX_BLOCKS_UPPER_BOUND = 8192, // 512 MB
 		INVALID_BLOCK = 0xFFFFFFFF,
+		FILL_BLOCK = 0xFFFFFFFE,
 		INVALID_INDEX = 0xFFFFFFFF,
 	};
 
@@ -143,8 +152,14 @@ class DiskCachingFileLoaderCache {
 	u16 generation_;
 	u16 oldestGeneration_;
 	u32 maxBlocks_;
+	u32 slotSize_;
 	u32 flags_;
+	// In slots, not blocks.
 	size_t cacheSize_;
+	// Lowest slot that might be free, all slots before it are in use.
+	u32 firstFreeSlot_ = 0;
+	// Slot of the block currently held in decompressBuf_.
+	u32 decompressedBlock_ = INVALID_BLOCK;
 	size_t indexCount_;
 	std::mutex lock_;
 	Path origPath_;
@@ -166,13 +181,17 @@ class DiskCachingFileLoaderCache {
 		u32 block;
 		u16 generation;
 		u16 hits;
+		u32 size;
 
-		BlockInfo() : block(-1), generation(0), hits(0) {
+		BlockInfo() : block(-1), generation(0), hits(0), size(0) {
 		}
 	};
 
 	std::vector<BlockInfo> index_;
+	// Maps each slot to the index entry that owns it.
 	std::vector<u32> blockIndexLookup_;
+	std::vector<u8> compressBuf_;
+	std::vector<u8> decompressBuf_;
 
 	FILE *f_ = nullptr;
 	int fd_ = 0;
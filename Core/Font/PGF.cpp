@@ -142,6 +142,7 @@ void PGF::DoState(PointerWrap &p) {
 		if (fontData) {
 			delete [] fontData;
 		}
+		decodedGlyphCache.clear();
 		if (fontDataSize) {
 			fontData = new u8[fontDataSize];
 			DoArray(p, fontData, (int)fontDataSize);
@@ -275,6 +276,7 @@ bool PGF::ReadPtr(const u8 *ptr, size_t dataSize) {
 	fontDataSize = dataSize - fontDataOffset;
 	fontData = new u8[fontDataSize];
 	memcpy(fontData, uptr, fontDataSize);
+	decodedGlyphCache.clear();
 
 	// charmap.resize();
 	charmap.resize(header.charMapLength);
@@ -536,7 +538,7 @@ bool PGF::ReadCharGlyph(const u8 *fontdata, size_t charPtr, Glyph &glyph) {
 	return true;
 }
 
-bool PGF::GetCharGlyph(int charCode, int glyphType, Glyph &glyph) const {
+bool PGF::GetCharGlyph(int charCode, int glyphType, Glyph &glyph, int *glyphIndex) const {
 	if (charCode < firstGlyph)
 		return false;
 	charCode -= firstGlyph;
@@ -552,58 +554,32 @@ bool PGF::GetCharGlyph(int charCode, int glyphType, Glyph &glyph) const {
 			return false;
 		glyph = shadowGlyphs[charCode];
 	}
+	if (glyphIndex)
+		*glyphIndex = charCode;
 	return true;
 }
 
-void PGF::DrawCharacter(const GlyphImage *image, int clipX, int clipY, int clipWidth, int clipHeight, int charCode, int altCharCode, int glyphType) const {
-	Glyph glyph;
-	if (!GetCharGlyph(charCode, glyphType, glyph)) {
-		if (charCode < firstGlyph) {
-			// Don't draw anything if the character is before the first available glyph.
-			return;
-		}
-		// No Glyph available for this charCode, try to use the alternate char.
-		charCode = altCharCode;
-		if (!GetCharGlyph(charCode, glyphType, glyph)) {
-			return;
-		}
-	}
+const std::vector<u8> &PGF::GetDecodedGlyph(const Glyph &glyph, int glyphIndex, int glyphType) const {
+	u32 key = ((u32)glyphIndex << 1) | (glyphType == FONT_PGF_CHARGLYPH ? 0 : 1);
+	auto it = decodedGlyphCache.find(key);
+	if (it != decodedGlyphCache.end())
+		return it->second;
 
-	if (glyph.w <= 0 || glyph.h <= 0) {
-		DEBUG_LOG(SCEFONT, "Glyph with negative size, not rendering");
-		return;
-	}
+	// Glyphs are small, but a game could walk through a whole CJK font.
+	if (decodedGlyphCache.size() >= MAX_DECODED_GLYPHS)
+		decodedGlyphCache.clear();
 
-	if (((glyph.flags & FONT_PGF_BMP_OVERLAY) != FONT_PGF_BMP_H_ROWS) &&
-		((glyph.flags & FONT_PGF_BMP_OVERLAY) != FONT_PGF_BMP_V_ROWS)) {
-		ERROR_LOG_REPORT(SCEFONT, "Nonsense glyph bitmap direction flag");
-		return;
-	}
+	// Stored row major with a border of zero pixels all around, so the subpixel
+	// blending can read one pixel past each edge without checks.
+	const int stride = glyph.w + 2;
+	std::vector<u8> &decoded = decodedGlyphCache[key];
+	decoded.resize(stride * (glyph.h + 2));
 
+	const bool hRows = (glyph.flags & FONT_PGF_BMP_OVERLAY) == FONT_PGF_BMP_H_ROWS;
 	size_t bitPtr = glyph.ptr * 8;
 	int numberPixels = glyph.w * glyph.h;
 	int pixelIndex = 0;
 
-	int x = image->xPos64 >> 6;
-	int y = image->yPos64 >> 6;
-	u8 xFrac = image->xPos64 & 0x3F;
-	u8 yFrac = image->yPos64 & 0x3F;
-
-	// Negative means don't clip on that side.
-	if (clipX < 0)
-		clipX = 0;
-	if (clipY < 0)
-		clipY = 0;
-	if (clipWidth < 0)
-		clipWidth = 8192;
-	if (clipHeight < 0)
-		clipHeight = 8192;
-
-	// Use a buffer so we can apply subpixel rendering.
-	// TODO: Cache this buffer per glyph?  Maybe even transpose it first?
-	std::vector<u8> decodedPixels;
-	decodedPixels.resize(numberPixels);
-
 	while (pixelIndex < numberPixels && bitPtr + 8 < fontDataSize * 8) {
 		// This is some kind of nibble based RLE compression.
 		int nibble = consumeBits(4, fontData, bitPtr);
@@ -622,113 +598,170 @@ void PGF::DrawCharacter(const GlyphImage *image, int clipX, int clipY, int clipW
 				value = consumeBits(4, fontData, bitPtr);
 			}
 
-			decodedPixels[pixelIndex++] = value | (value << 4);
+			int xx, yy;
+			if (hRows) {
+				xx = pixelIndex % glyph.w;
+				yy = pixelIndex / glyph.w;
+			} else {
+				xx = pixelIndex / glyph.h;
+				yy = pixelIndex % glyph.h;
+			}
+			decoded[(yy + 1) * stride + xx + 1] = value | (value << 4);
+			pixelIndex++;
 		}
 	}
 
-	auto samplePixel = [&](int xx, int yy) -> u8 {
-		if (xx < 0 || yy < 0 || xx >= glyph.w || yy >= glyph.h) {
-			return 0;
-		}
+	return decoded;
+}
 
-		int index;
-		if ((glyph.flags & FONT_PGF_BMP_OVERLAY) == FONT_PGF_BMP_H_ROWS) {
-			index = yy * glyph.w + xx;
-		} else {
-			index = xx * glyph.h + yy;
+// dst points at the byte holding pixel x, x itself only matters for 4-bit nibble order.
+static void BlitFontRow(u8 *dst, int x, const u8 *colors, int count, FontPixelFormat pixelformat) {
+	switch (pixelformat) {
+	case PSP_FONT_PIXELFORMAT_4:
+	case PSP_FONT_PIXELFORMAT_4_REV:
+		for (int i = 0; i < count; ++i) {
+			// We always get a 8-bit value, so take only the top 4 bits.
+			const u8 pix4 = colors[i] >> 4;
+			u8 &pair = dst[((x & 1) + i) / 2];
+			if (((x + i) & 1) != pixelformat) {
+				pair = (pix4 << 4) | (pair & 0xF);
+			} else {
+				pair = (pair & 0xF0) | pix4;
+			}
 		}
+		break;
 
-		return decodedPixels[index];
-	};
+	case PSP_FONT_PIXELFORMAT_8:
+		memcpy(dst, colors, count);
+		break;
 
-	int renderX1 = std::max(clipX, x) - x;
-	int renderY1 = std::max(clipY, y) - y;
-	// We can render up to frac beyond the glyph w/h, so add 1px if necessary.
-	int renderX2 = std::min(clipX + clipWidth - x, glyph.w + (xFrac > 0 ? 1 : 0));
-	int renderY2 = std::min(clipY + clipHeight - y, glyph.h + (yFrac > 0 ? 1 : 0));
+	case PSP_FONT_PIXELFORMAT_24:
+		// Each channel has the same value.
+		for (int i = 0; i < count; ++i) {
+			dst[i * 3 + 0] = colors[i];
+			dst[i * 3 + 1] = colors[i];
+			dst[i * 3 + 2] = colors[i];
+		}
+		break;
 
-	if (xFrac == 0 && yFrac == 0) {
-		for (int yy = renderY1; yy < renderY2; ++yy) {
-			for (int xx = renderX1; xx < renderX2; ++xx) {
-				u8 pixelColor = samplePixel(xx, yy);
-				SetFontPixel(image->bufferPtr, image->bytesPerLine, image->bufWidth, image->bufHeight, x + xx, y + yy, pixelColor, (FontPixelFormat)(u32)image->pixelFormat);
-			}
+	case PSP_FONT_PIXELFORMAT_32:
+		// Spread the 8 bits out into 32 bits, all bytes are equal so endian doesn't matter.
+		for (int i = 0; i < count; ++i) {
+			u32 pix32 = colors[i] * 0x01010101;
+			memcpy(dst + i * 4, &pix32, 4);
 		}
-	} else {
-		for (int yy = renderY1; yy < renderY2; ++yy) {
-			for (int xx = renderX1; xx < renderX2; ++xx) {
-				// First, blend horizontally.  Tests show we blend swizzled to 8 bit.
-				u32 horiz1 = samplePixel(xx - 1, yy - 1) * xFrac + samplePixel(xx, yy - 1) * (64 - xFrac);
-				u32 horiz2 = samplePixel(xx - 1, yy + 0) * xFrac + samplePixel(xx, yy + 0) * (64 - xFrac);
-				// Now blend those together vertically.
-				u32 blended = horiz1 * yFrac + horiz2 * (64 - yFrac);
+		break;
+	}
+}
 
-				// We multiplied an 8 bit value by 64 twice, so now we have a 20 bit value.
-				u8 pixelColor = blended >> 12;
-				SetFontPixel(image->bufferPtr, image->bytesPerLine, image->bufWidth, image->bufHeight, x + xx, y + yy, pixelColor, (FontPixelFormat)(u32)image->pixelFormat);
-			}
+void PGF::DrawCharacter(const GlyphImage *image, int clipX, int clipY, int clipWidth, int clipHeight, int charCode, int altCharCode, int glyphType) const {
+	Glyph glyph;
+	int glyphIndex;
+	if (!GetCharGlyph(charCode, glyphType, glyph, &glyphIndex)) {
+		if (charCode < firstGlyph) {
+			// Don't draw anything if the character is before the first available glyph.
+			return;
+		}
+		// No Glyph available for this charCode, try to use the alternate char.
+		charCode = altCharCode;
+		if (!GetCharGlyph(charCode, glyphType, glyph, &glyphIndex)) {
+			return;
 		}
 	}
 
-	gpu->InvalidateCache(image->bufferPtr, image->bytesPerLine * image->bufHeight, GPU_INVALIDATE_SAFE);
-}
+	if (glyph.w <= 0 || glyph.h <= 0) {
+		DEBUG_LOG(SCEFONT, "Glyph with negative size, not rendering");
+		return;
+	}
 
-void PGF::SetFontPixel(u32 base, int bpl, int bufWidth, int bufHeight, int x, int y, u8 pixelColor, FontPixelFormat pixelformat) const {
-	if (x < 0 || x >= bufWidth || y < 0 || y >= bufHeight) {
+	if (((glyph.flags & FONT_PGF_BMP_OVERLAY) != FONT_PGF_BMP_H_ROWS) &&
+		((glyph.flags & FONT_PGF_BMP_OVERLAY) != FONT_PGF_BMP_V_ROWS)) {
+		ERROR_LOG_REPORT(SCEFONT, "Nonsense glyph bitmap direction flag");
 		return;
 	}
 
+	FontPixelFormat pixelformat = (FontPixelFormat)(u32)image->pixelFormat;
 	static const u8 fontPixelSizeInBytes[] = { 0, 0, 1, 3, 4 }; // 0 means 2 pixels per byte
 	if (pixelformat < 0 || pixelformat > PSP_FONT_PIXELFORMAT_32) {
 		ERROR_LOG_REPORT_ONCE(pfgbadformat, SCEFONT, "Invalid image format in image: %d", (int)pixelformat);
 		return;
 	}
 	int pixelBytes = fontPixelSizeInBytes[pixelformat];
+	int bpl = image->bytesPerLine;
 	int bufMaxWidth = (pixelBytes == 0 ? bpl * 2 : bpl / pixelBytes);
-	if (x >= bufMaxWidth) {
+
+	int x = image->xPos64 >> 6;
+	int y = image->yPos64 >> 6;
+	u8 xFrac = image->xPos64 & 0x3F;
+	u8 yFrac = image->yPos64 & 0x3F;
+
+	// Negative means don't clip on that side.
+	if (clipX < 0)
+		clipX = 0;
+	if (clipY < 0)
+		clipY = 0;
+	if (clipWidth < 0)
+		clipWidth = 8192;
+	if (clipHeight < 0)
+		clipHeight = 8192;
+
+	int renderX1 = std::max(clipX, x) - x;
+	int renderY1 = std::max(clipY, y) - y;
+	// We can render up to frac beyond the glyph w/h, so add 1px if necessary.
+	int renderX2 = std::min(clipX + clipWidth - x, glyph.w + (xFrac > 0 ? 1 : 0));
+	int renderY2 = std::min(clipY + clipHeight - y, glyph.h + (yFrac > 0 ? 1 : 0));
+
+	// Also clip to the buffer, so the blitters don't need to check each pixel.
+	renderX1 = std::max(renderX1, -x);
+	renderY1 = std::max(renderY1, -y);
+	renderX2 = std::min(renderX2, std::min((int)image->bufWidth, bufMaxWidth) - x);
+	renderY2 = std::min(renderY2, (int)image->bufHeight - y);
+	if (renderX1 >= renderX2 || renderY1 >= renderY2) {
+		gpu->InvalidateCache(image->bufferPtr, image->bytesPerLine * image->bufHeight, GPU_INVALIDATE_SAFE);
 		return;
 	}
 
-	int framebufferAddr = base + (y * bpl) + (pixelBytes == 0 ? x / 2 : x * pixelBytes);
+	const std::vector<u8> &decoded = GetDecodedGlyph(glyph, glyphIndex, glyphType);
+	const int stride = glyph.w + 2;
+	// Pointer to glyph pixel (0, 0), the border makes (-1, -1) through (w, h) valid.
+	const u8 *pixels = &decoded[stride + 1];
 
-	switch (pixelformat) {
-	case PSP_FONT_PIXELFORMAT_4:
-	case PSP_FONT_PIXELFORMAT_4_REV:
-		{
-			// We always get a 8-bit value, so take only the top 4 bits.
-			const u8 pix4 = pixelColor >> 4;
+	const int count = renderX2 - renderX1;
+	const int dstX = x + renderX1;
+	const u32 rowStart = pixelBytes == 0 ? dstX / 2 : dstX * pixelBytes;
+	const u32 rowEnd = pixelBytes == 0 ? (dstX + count + 1) / 2 : (dstX + count) * pixelBytes;
+	u8 colors[256];
+	std::vector<u8> wideColors;
+	u8 *rowColors = colors;
+	if (count > (int)sizeof(colors)) {
+		wideColors.resize(count);
+		rowColors = wideColors.data();
+	}
 
-			int oldColor = Memory::Read_U8(framebufferAddr);
-			int newColor;
-			if ((x & 1) != pixelformat) {
-				newColor = (pix4 << 4) | (oldColor & 0xF);
-			} else {
-				newColor = (oldColor & 0xF0) | pix4;
+	for (int yy = renderY1; yy < renderY2; ++yy) {
+		if (xFrac == 0 && yFrac == 0) {
+			memcpy(rowColors, pixels + yy * stride + renderX1, count);
+		} else {
+			const u8 *above = pixels + (yy - 1) * stride;
+			const u8 *row = pixels + yy * stride;
+			for (int xx = renderX1; xx < renderX2; ++xx) {
+				// First, blend horizontally.  Tests show we blend swizzled to 8 bit.
+				u32 horiz1 = above[xx - 1] * xFrac + above[xx] * (64 - xFrac);
+				u32 horiz2 = row[xx - 1] * xFrac + row[xx] * (64 - xFrac);
+				// Now blend those together vertically.
+				u32 blended = horiz1 * yFrac + horiz2 * (64 - yFrac);
+
+				// We multiplied an 8 bit value by 64 twice, so now we have a 20 bit value.
+				rowColors[xx - renderX1] = blended >> 12;
 			}
-			Memory::Write_U8(newColor, framebufferAddr);
-			break;
-		}
-	case PSP_FONT_PIXELFORMAT_8:
-		{
-			Memory::Write_U8(pixelColor, framebufferAddr);
-			break;
 		}
-	case PSP_FONT_PIXELFORMAT_24:
-		{
-			// Each channel has the same value.
-			Memory::Write_U8(pixelColor, framebufferAddr + 0);
-			Memory::Write_U8(pixelColor, framebufferAddr + 1);
-			Memory::Write_U8(pixelColor, framebufferAddr + 2);
-			break;
-		}
-	case PSP_FONT_PIXELFORMAT_32:
-		{
-			// Spread the 8 bits out into one write of 32 bits.
-			u32 pix32 = pixelColor;
-			pix32 |= pix32 << 8;
-			pix32 |= pix32 << 16;
-			Memory::Write_U32(pix32, framebufferAddr);
-			break;
+
+		u32 rowAddr = image->bufferPtr + (y + yy) * bpl;
+		u8 *dst = Memory::GetPointerWriteRange(rowAddr + rowStart, rowEnd - rowStart);
+		if (dst) {
+			BlitFontRow(dst, dstX, rowColors, count, pixelformat);
 		}
 	}
+
+	gpu->InvalidateCache(image->bufferPtr, image->bytesPerLine * image->bufHeight, GPU_INVALIDATE_SAFE);
 }
@@ -20,6 +20,7 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "Common/CommonTypes.h"
@@ -275,13 +276,13 @@ class PGF {
 private:
 	bool ReadCharGlyph(const u8 *fontdata, size_t charPtr, Glyph &glyph);
 	bool ReadShadowGlyph(const u8 *fontdata, size_t charPtr, Glyph &glyph);
-	bool GetCharGlyph(int charCode, int glyphType, Glyph &glyph) const;
+	bool GetCharGlyph(int charCode, int glyphType, Glyph &glyph, int *glyphIndex = nullptr) const;
+	// Decoded 8-bit glyph bitmap, see the cache below.
+	const std::vector<u8> &GetDecodedGlyph(const Glyph &glyph, int glyphIndex, int glyphType) const;
 
 	// Unused
 	int GetCharIndex(int charCode, const std::vector<int> &charmapCompressed);
 
-	void SetFontPixel(u32 base, int bpl, int bufWidth, int bufHeight, int x, int y, u8 pixelColor, FontPixelFormat pixelformat) const;
-
 	PGFHeaderRev3Extra rev3extra;
 
 	// Font character image data
@@ -305,4 +306,9 @@ class PGF {
 	std::vector<Glyph> glyphs;
 	std::vector<Glyph> shadowGlyphs;
 	int firstGlyph;
+
+	// Glyphs are RLE compressed in fontData, text heavy games draw the same ones over and over.
+	// Keyed by glyph index and type, not savestated since it's just derived from fontData.
+	enum { MAX_DECODED_GLYPHS = 4096 };
+	mutable std::unordered_map<u32, std::vector<u8>> decodedGlyphCache;
 };
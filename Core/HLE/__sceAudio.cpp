@@ -23,6 +23,7 @@
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Common/Data/Collections/FixedSizeQueue.h"
+#include "Common/TimeUtil.h"
 
 #ifdef _M_SSE
 #include <emmintrin.h>
@@ -37,6 +38,7 @@
 #ifndef MOBILE_DEVICE
 #include "Core/WaveFile.h"
 #include "Core/ELF/ParamSFO.h"
+#include "Core/HLE/sceKernel.h"
 #include "Core/HLE/sceKernelTime.h"
 #include "StringUtils.h"
 #endif
@@ -340,6 +342,10 @@ void __AudioUpdate(bool resetRecording) {
 	// Audio throttle doesn't really work on the PSP since the mixing intervals are so closely tied
 	// to the CPU. Much better to throttle the frame rate on frame display and just throw away audio
 	// if the buffer somehow gets full.
+	double start = 0.0;
+	if (coreCollectDebugStats)
+		start = time_now_d();
+
 	bool firstChannel = true;
 	const int16_t srcBufferSize = hwBlockSize * 2;
 	int16_t srcBuffer[srcBufferSize];
@@ -463,6 +469,9 @@ void __AudioUpdate(bool resetRecording) {
 		}
 #endif
 	}
+
+	if (coreCollectDebugStats)
+		kernelStats.msMixingAudio += time_now_d() - start;
 }
 
 // numFrames is number of stereo frames.
@@ -551,6 +551,7 @@ struct KernelStats {
 	}
 	void ResetFrame() {
 		msInSyscalls = 0;
+		msMixingAudio = 0;
 		slowestSyscallTime = 0;
 		slowestSyscallName = 0;
 		summedMsInSyscalls.clear();
@@ -559,6 +560,7 @@ struct KernelStats {
 	}
 
 	double msInSyscalls;
+	double msMixingAudio;
 	double slowestSyscallTime;
 	const char *slowestSyscallName;
 	std::map<KernelStatsSyscall, double> summedMsInSyscalls;
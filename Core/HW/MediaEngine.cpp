@@ -29,6 +29,16 @@
 
 #include <algorithm>
 
+#if defined(_M_SSE)
+#include <emmintrin.h>
+#elif PPSSPP_ARCH(ARM_NEON)
+#if defined(_MSC_VER) && PPSSPP_ARCH(ARM64)
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif
+
 #ifdef USE_FFMPEG
 
 extern "C" {
@@ -337,6 +347,7 @@ void MediaEngine::closeContext()
 		av_free(m_buffer);
 	if (m_pFrameRGB)
 		av_frame_free(&m_pFrameRGB);
+	m_frameConvertPending = false;
 	if (m_pFrame)
 		av_frame_free(&m_pFrame);
 	if (m_pIOContext && m_pIOContext->buffer)
@@ -630,6 +641,36 @@ void MediaEngine::updateSwsFormat(int videoPixelMode) {
 #endif
 }
 
+#ifdef USE_FFMPEG
+bool MediaEngine::convertFrame(u8 *dest, int destLineSize, int videoPixelMode) {
+	auto codecIter = m_pCodecCtxs.find(m_videoStream);
+	AVCodecContext *m_pCodecCtx = codecIter == m_pCodecCtxs.end() ? 0 : codecIter->second;
+	if (!m_pCodecCtx || !m_pFrame)
+		return false;
+
+	updateSwsFormat(videoPixelMode);
+	if (!m_sws_ctx)
+		return false;
+
+	uint8_t *destData[4] = { dest, nullptr, nullptr, nullptr };
+	int destLineSizes[4] = { destLineSize, 0, 0, 0 };
+	sws_scale(m_sws_ctx, m_pFrame->data, m_pFrame->linesize, 0, m_pCodecCtx->height, destData, destLineSizes);
+	return true;
+}
+#endif
+
+void MediaEngine::convertPendingFrame() {
+#ifdef USE_FFMPEG
+	if (!m_frameConvertPending || !m_pFrameRGB)
+		return;
+	m_frameConvertPending = false;
+
+	// Update the linesize for the new format too.  We started with the largest size, so it should fit.
+	m_pFrameRGB->linesize[0] = getPixelFormatBytes(m_framePixelMode) * m_desWidth;
+	convertFrame(m_pFrameRGB->data[0], m_pFrameRGB->linesize[0], m_framePixelMode);
+#endif
+}
+
 bool MediaEngine::stepVideo(int videoPixelMode, bool skipFrame) {
 #ifdef USE_FFMPEG
 	auto codecIter = m_pCodecCtxs.find(m_videoStream);
@@ -642,6 +683,11 @@ bool MediaEngine::stepVideo(int videoPixelMode, bool skipFrame) {
 	if (!m_pFrame)
 		return false;
 
+	if (skipFrame && m_frameConvertPending) {
+		// The frame we're about to overwrite was never converted, keep it visible.
+		convertPendingFrame();
+	}
+
 	AVPacket packet;
 	av_init_packet(&packet);
 	int frameFinished;
@@ -681,13 +727,10 @@ bool MediaEngine::stepVideo(int videoPixelMode, bool skipFrame) {
 					setVideoDim();
 				}
 				if (m_pFrameRGB && !skipFrame) {
-					updateSwsFormat(videoPixelMode);
-					// TODO: Technically we could set this to frameWidth instead of m_desWidth for better perf.
-					// Update the linesize for the new format too.  We started with the largest size, so it should fit.
-					m_pFrameRGB->linesize[0] = getPixelFormatBytes(videoPixelMode) * m_desWidth;
-
-					sws_scale(m_sws_ctx, m_pFrame->data, m_pFrame->linesize, 0,
-						m_pCodecCtx->height, m_pFrameRGB->data, m_pFrameRGB->linesize);
+					// Conversion is deferred, so that writeVideoImage() can usually convert
+					// straight into PSP memory instead of going through m_pFrameRGB.
+					m_frameConvertPending = true;
+					m_framePixelMode = videoPixelMode;
 				}
 
 #if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(55, 58, 100)
@@ -739,41 +782,66 @@ bool MediaEngine::stepVideo(int videoPixelMode, bool skipFrame) {
 
 // Helpers that null out alpha (which seems to be the case on the PSP.)
 // Some games depend on this, for example Sword Art Online (doesn't clear A's from buffer.)
+// These may be used in place, with destp == srcp.
 inline void writeVideoLineRGBA(void *destp, const void *srcp, int width) {
-	// TODO: Use SSE/NEON, investigate why AV_PIX_FMT_RGB0 does not work.
+	// TODO: Investigate why AV_PIX_FMT_RGB0 does not work.
 	u32_le *dest = (u32_le *)destp;
 	const u32_le *src = (u32_le *)srcp;
 
 	const u32 mask = 0x00FFFFFF;
-	for (int i = 0; i < width; ++i) {
+	int i = 0;
+#if defined(_M_SSE)
+	const __m128i mask4 = _mm_set1_epi32(mask);
+	for (; i + 4 <= width; i += 4) {
+		__m128i pixels = _mm_loadu_si128((const __m128i *)(src + i));
+		_mm_storeu_si128((__m128i *)(dest + i), _mm_and_si128(pixels, mask4));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	const uint32x4_t mask4 = vdupq_n_u32(mask);
+	for (; i + 4 <= width; i += 4) {
+		uint32x4_t pixels = vld1q_u32((const uint32_t *)(src + i));
+		vst1q_u32((uint32_t *)(dest + i), vandq_u32(pixels, mask4));
+	}
+#endif
+	for (; i < width; ++i) {
 		dest[i] = src[i] & mask;
 	}
 }
 
-inline void writeVideoLineABGR5650(void *destp, const void *srcp, int width) {
-	memcpy(destp, srcp, width * sizeof(u16));
-}
-
-inline void writeVideoLineABGR5551(void *destp, const void *srcp, int width) {
-	// TODO: Use SSE/NEON.
+inline void writeVideoLineMasked16(void *destp, const void *srcp, int width, u16 mask) {
 	u16_le *dest = (u16_le *)destp;
 	const u16_le *src = (u16_le *)srcp;
 
-	const u16 mask = 0x7FFF;
-	for (int i = 0; i < width; ++i) {
+	int i = 0;
+#if defined(_M_SSE)
+	const __m128i mask8 = _mm_set1_epi16(mask);
+	for (; i + 8 <= width; i += 8) {
+		__m128i pixels = _mm_loadu_si128((const __m128i *)(src + i));
+		_mm_storeu_si128((__m128i *)(dest + i), _mm_and_si128(pixels, mask8));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	const uint16x8_t mask8 = vdupq_n_u16(mask);
+	for (; i + 8 <= width; i += 8) {
+		uint16x8_t pixels = vld1q_u16((const uint16_t *)(src + i));
+		vst1q_u16((uint16_t *)(dest + i), vandq_u16(pixels, mask8));
+	}
+#endif
+	for (; i < width; ++i) {
 		dest[i] = src[i] & mask;
 	}
 }
 
-inline void writeVideoLineABGR4444(void *destp, const void *srcp, int width) {
-	// TODO: Use SSE/NEON.
-	u16_le *dest = (u16_le *)destp;
-	const u16_le *src = (u16_le *)srcp;
+inline void writeVideoLineABGR5650(void *destp, const void *srcp, int width) {
+	if (destp != srcp)
+		memcpy(destp, srcp, width * sizeof(u16));
+}
 
-	const u16 mask = 0x0FFF;
-	for (int i = 0; i < width; ++i) {
-		dest[i] = src[i] & mask;
-	}
+inline void writeVideoLineABGR5551(void *destp, const void *srcp, int width) {
+	writeVideoLineMasked16(destp, srcp, width, 0x7FFF);
+}
+
+inline void writeVideoLineABGR4444(void *destp, const void *srcp, int width) {
+	writeVideoLineMasked16(destp, srcp, width, 0x0FFF);
 }
 
 int MediaEngine::writeVideoImage(u32 bufferPtr, int frameWidth, int videoPixelMode) {
@@ -807,39 +875,54 @@ int MediaEngine::writeVideoImage(u32 bufferPtr, int frameWidth, int videoPixelMo
 	int height = m_desHeight;
 	int width = m_desWidth;
 	u8 *imgbuf = buffer;
-	const u8 *data = m_pFrameRGB->data[0];
 
 	bool swizzle = Memory::IsVRAMAddress(bufferPtr) && (bufferPtr & 0x00200000) == 0x00200000;
 	if (swizzle) {
 		imgbuf = new u8[videoImageSize];
 	}
 
+	// If the frame is still in decoder format, have swscale write straight into the
+	// destination layout, and only fix up alpha afterwards.  Not for PMP frames, which
+	// put their own already converted frame in m_pFrameRGB.
+	bool direct = m_frameConvertPending && m_pFrameRGB->data[0] == m_buffer && videoPixelMode == m_framePixelMode && videoLineSize != 0 && frameWidth >= width;
+	const u8 *data;
+	int dataLineSize;
+	if (direct && convertFrame(imgbuf, videoLineSize, videoPixelMode)) {
+		// The loops below then just mask alpha in place.
+		data = imgbuf;
+		dataLineSize = videoLineSize;
+	} else {
+		convertPendingFrame();
+		data = m_pFrameRGB->data[0];
+		dataLineSize = width * getPixelFormatBytes(videoPixelMode);
+	}
+
 	switch (videoPixelMode) {
 	case GE_CMODE_32BIT_ABGR8888:
 		for (int y = 0; y < height; y++) {
 			writeVideoLineRGBA(imgbuf + videoLineSize * y, data, width);
-			data += width * sizeof(u32);
+			data += dataLineSize;
 		}
 		break;
 
 	case GE_CMODE_16BIT_BGR5650:
 		for (int y = 0; y < height; y++) {
 			writeVideoLineABGR5650(imgbuf + videoLineSize * y, data, width);
-			data += width * sizeof(u16);
+			data += dataLineSize;
 		}
 		break;
 
 	case GE_CMODE_16BIT_ABGR5551:
 		for (int y = 0; y < height; y++) {
 			writeVideoLineABGR5551(imgbuf + videoLineSize * y, data, width);
-			data += width * sizeof(u16);
+			data += dataLineSize;
 		}
 		break;
 
 	case GE_CMODE_16BIT_ABGR4444:
 		for (int y = 0; y < height; y++) {
 			writeVideoLineABGR4444(imgbuf + videoLineSize * y, data, width);
-			data += width * sizeof(u16);
+			data += dataLineSize;
 		}
 		break;
 
@@ -892,6 +975,8 @@ int MediaEngine::writeVideoImageWithRange(u32 bufferPtr, int frameWidth, int vid
 	if (!m_pFrame || !m_pFrameRGB)
 		return 0;
 
+	convertPendingFrame();
+
 	// lock the image size
 	u8 *imgbuf = buffer;
 	const u8 *data = m_pFrameRGB->data[0];
@@ -968,6 +1053,7 @@ int MediaEngine::writeVideoImageWithRange(u32 bufferPtr, int frameWidth, int vid
 
 u8 *MediaEngine::getFrameImage() {
 #ifdef USE_FFMPEG
+	convertPendingFrame();
 	return m_pFrameRGB->data[0];
 #else
 	return nullptr;
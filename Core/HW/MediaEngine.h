@@ -98,6 +98,11 @@ class MediaEngine
 	bool SetupStreams();
 	bool setVideoDim(int width = 0, int height = 0);
 	void updateSwsFormat(int videoPixelMode);
+	// Runs the deferred swscale conversion of the last decoded frame into m_pFrameRGB.
+	void convertPendingFrame();
+#ifdef USE_FFMPEG
+	bool convertFrame(u8 *dest, int destLineSize, int videoPixelMode);
+#endif
 	int getNextAudioFrame(u8 **buf, int *headerCode1, int *headerCode2);
 
 	static int MpegReadbuffer(void *opaque, uint8_t *buf, int buf_size);
@@ -132,6 +137,9 @@ class MediaEngine
 #endif
 
 	int m_sws_fmt = 0;
+	// m_pFrame holds a decoded frame not yet converted into m_pFrameRGB.
+	bool m_frameConvertPending = false;
+	int m_framePixelMode = 0;
 	int m_videoStream = -1;
 	int m_expectedVideoStreams = 0;
 
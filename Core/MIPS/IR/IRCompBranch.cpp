@@ -54,6 +54,66 @@ using namespace MIPSAnalyst;
 namespace MIPSComp
 {
 
+// Limits how far a trace may extend past its first block.
+static const int MAX_TRACE_INSTRUCTIONS = 300;
+static const u32 MAX_TRACE_BYTES = 0x1000;
+
+u32 IRFrontend::TraceBranch(const BranchInfo &branchInfo, u32 targetAddr, u32 notTakenAddr) {
+	if (branchInfo.delaySlotIsBranch || !js.compiling || js.numInstructions >= MAX_TRACE_INSTRUCTIONS)
+		return 0;
+
+	// Only go forward, so the trace can't loop and still covers a single range for invalidation.
+	auto canFollow = [&](u32 dest) {
+		return dest >= GetCompilerPC() + 8 && dest - js.blockStart <= MAX_TRACE_BYTES;
+	};
+
+	// If this branch ends the block, these are the exits the dispatcher may ask us to follow.
+	u32 segmentStart = js.lastContinuedPC != 0 ? js.lastContinuedPC : js.blockStart;
+	traceBranchPC_ = GetCompilerPC();
+	traceExits_.from = segmentStart;
+	traceExits_.dests[0] = canFollow(targetAddr) ? targetAddr : 0;
+	// In likely branches the delay slot only runs when taken, so that can't be the side exit.
+	traceExits_.dests[1] = canFollow(notTakenAddr) && !branchInfo.likely ? notTakenAddr : 0;
+
+	auto iter = hotSuccessors_.find(segmentStart);
+	if (iter == hotSuccessors_.end())
+		return 0;
+	u32 dest = iter->second;
+	if (dest != 0 && (dest == traceExits_.dests[0] || dest == traceExits_.dests[1]))
+		return dest;
+	return 0;
+}
+
+void IRFrontend::InvalidateHotSuccessors(u32 address, u32 length) {
+	address &= 0x3FFFFFFF;
+	for (auto it = hotSuccessors_.begin(); it != hotSuccessors_.end(); ) {
+		// A trace covers everything from its key up to the successor.
+		if ((it->first & 0x3FFFFFFF) < address + length && (it->second & 0x3FFFFFFF) >= address)
+			it = hotSuccessors_.erase(it);
+		else
+			++it;
+	}
+}
+
+void IRFrontend::FinishBranch(u32 targetAddr, u32 traceTarget) {
+	// Account for the delay slot.
+	js.compilerPC += 4;
+
+	if (traceTarget != 0) {
+		if (js.compiling) {
+			js.lastContinuedPC = traceTarget;
+			// Account for the increment in the loop.
+			js.compilerPC = traceTarget - 4;
+			return;
+		}
+		// The delay slot ended the block anyway.
+		targetAddr = traceTarget;
+	}
+
+	ir.Write(IROp::ExitToConst, ir.AddConstant(targetAddr));
+	js.compiling = false;
+}
+
 void IRFrontend::BranchRSRTComp(MIPSOpcode op, IRComparison cc, bool likely) {
 	if (js.inDelaySlot) {
 		ERROR_LOG_REPORT(JIT, "Branch in RSRTComp delay slot at %08x in block starting at %08x", GetCompilerPC(), js.blockStart);
@@ -100,7 +160,14 @@ void IRFrontend::BranchRSRTComp(MIPSOpcode op, IRComparison cc, bool likely) {
 	js.downcountAmount = 0;
 
 	FlushAll();
-	ir.Write(ComparisonToExit(cc), ir.AddConstant(ResolveNotTakenTarget(branchInfo)), lhs, rhs);
+	u32 notTakenTarget = ResolveNotTakenTarget(branchInfo);
+	u32 traceTarget = TraceBranch(branchInfo, targetAddr, notTakenTarget);
+	if (traceTarget != 0 && traceTarget == notTakenTarget) {
+		// The hot path falls through, so make the taken branch the side exit.
+		ir.Write(ComparisonToExit(Invert(cc)), ir.AddConstant(targetAddr), lhs, rhs);
+	} else {
+		ir.Write(ComparisonToExit(cc), ir.AddConstant(notTakenTarget), lhs, rhs);
+	}
 	// This makes the block "impure" :(
 	if (likely && !branchInfo.delaySlotIsBranch)
 		CompileDelaySlot();
@@ -114,11 +181,7 @@ void IRFrontend::BranchRSRTComp(MIPSOpcode op, IRComparison cc, bool likely) {
 	}
 
 	FlushAll();
-	ir.Write(IROp::ExitToConst, ir.AddConstant(targetAddr));
-
-	// Account for the delay slot.
-	js.compilerPC += 4;
-	js.compiling = false;
+	FinishBranch(targetAddr, traceTarget);
 }
 
 void IRFrontend::BranchRSZeroComp(MIPSOpcode op, IRComparison cc, bool andLink, bool likely) {
@@ -151,7 +214,14 @@ void IRFrontend::BranchRSZeroComp(MIPSOpcode op, IRComparison cc, bool andLink,
 	js.downcountAmount = 0;
 
 	FlushAll();
-	ir.Write(ComparisonToExit(cc), ir.AddConstant(ResolveNotTakenTarget(branchInfo)), lhs);
+	u32 notTakenTarget = ResolveNotTakenTarget(branchInfo);
+	u32 traceTarget = TraceBranch(branchInfo, targetAddr, notTakenTarget);
+	if (traceTarget != 0 && traceTarget == notTakenTarget) {
+		// The hot path falls through, so make the taken branch the side exit.
+		ir.Write(ComparisonToExit(Invert(cc)), ir.AddConstant(targetAddr), lhs);
+	} else {
+		ir.Write(ComparisonToExit(cc), ir.AddConstant(notTakenTarget), lhs);
+	}
 	if (likely && !branchInfo.delaySlotIsBranch)
 		CompileDelaySlot();
 	if (branchInfo.delaySlotIsBranch) {
@@ -165,11 +235,7 @@ void IRFrontend::BranchRSZeroComp(MIPSOpcode op, IRComparison cc, bool andLink,
 
 	// Taken
 	FlushAll();
-	ir.Write(IROp::ExitToConst, ir.AddConstant(targetAddr));
-
-	// Account for the delay slot.
-	js.compilerPC += 4;
-	js.compiling = false;
+	FinishBranch(targetAddr, traceTarget);
 }
 
 void IRFrontend::Comp_RelBranch(MIPSOpcode op) {
@@ -230,7 +296,14 @@ void IRFrontend::BranchFPFlag(MIPSOpcode op, IRComparison cc, bool likely) {
 
 	FlushAll();
 	// Not taken
-	ir.Write(ComparisonToExit(cc), ir.AddConstant(ResolveNotTakenTarget(branchInfo)), IRTEMP_LHS, 0);
+	u32 notTakenTarget = ResolveNotTakenTarget(branchInfo);
+	u32 traceTarget = TraceBranch(branchInfo, targetAddr, notTakenTarget);
+	if (traceTarget != 0 && traceTarget == notTakenTarget) {
+		// The hot path falls through, so make the taken branch the side exit.
+		ir.Write(ComparisonToExit(Invert(cc)), ir.AddConstant(targetAddr), IRTEMP_LHS, 0);
+	} else {
+		ir.Write(ComparisonToExit(cc), ir.AddConstant(notTakenTarget), IRTEMP_LHS, 0);
+	}
 	// Taken
 	if (likely && !branchInfo.delaySlotIsBranch)
 		CompileDelaySlot();
@@ -244,11 +317,7 @@ void IRFrontend::BranchFPFlag(MIPSOpcode op, IRComparison cc, bool likely) {
 	}
 
 	FlushAll();
-	ir.Write(IROp::ExitToConst, ir.AddConstant(targetAddr));
-
-	// Account for the delay slot.
-	js.compilerPC += 4;
-	js.compiling = false;
+	FinishBranch(targetAddr, traceTarget);
 }
 
 void IRFrontend::Comp_FPUBranch(MIPSOpcode op) {
@@ -291,7 +360,14 @@ void IRFrontend::BranchVFPUFlag(MIPSOpcode op, IRComparison cc, bool likely) {
 
 	ir.Write(IROp::AndConst, IRTEMP_LHS, IRTEMP_LHS, ir.AddConstant(1 << imm3));
 	FlushAll();
-	ir.Write(ComparisonToExit(cc), ir.AddConstant(ResolveNotTakenTarget(branchInfo)), IRTEMP_LHS, 0);
+	u32 notTakenTarget = ResolveNotTakenTarget(branchInfo);
+	u32 traceTarget = TraceBranch(branchInfo, targetAddr, notTakenTarget);
+	if (traceTarget != 0 && traceTarget == notTakenTarget) {
+		// The hot path falls through, so make the taken branch the side exit.
+		ir.Write(ComparisonToExit(Invert(cc)), ir.AddConstant(targetAddr), IRTEMP_LHS, 0);
+	} else {
+		ir.Write(ComparisonToExit(cc), ir.AddConstant(notTakenTarget), IRTEMP_LHS, 0);
+	}
 
 	if (likely && !branchInfo.delaySlotIsBranch)
 		CompileDelaySlot();
@@ -306,11 +382,7 @@ void IRFrontend::BranchVFPUFlag(MIPSOpcode op, IRComparison cc, bool likely) {
 
 	// Taken
 	FlushAll();
-	ir.Write(IROp::ExitToConst, ir.AddConstant(targetAddr));
-
-	// Account for the delay slot.
-	js.compilerPC += 4;
-	js.compiling = false;
+	FinishBranch(targetAddr, traceTarget);
 }
 
 void IRFrontend::Comp_VBranch(MIPSOpcode op) {
@@ -362,11 +434,7 @@ void IRFrontend::Comp_Jump(MIPSOpcode op) {
 	js.downcountAmount = 0;
 
 	FlushAll();
-	ir.Write(IROp::ExitToConst, ir.AddConstant(targetAddr));
-
-	// Account for the delay slot.
-	js.compilerPC += 4;
-	js.compiling = false;
+	FinishBranch(targetAddr, 0);
 }
 
 void IRFrontend::Comp_JumpReg(MIPSOpcode op) {
@@ -41,6 +41,11 @@ IRFrontend::IRFrontend(bool startDefaultPrefix) {
 	CBreakPoints::SetSkipFirst(0);
 }
 
+IRFrontend::IRFrontend(const IRFrontend &other) : opts(other.opts), hotSuccessors_(other.hotSuccessors_) {
+	js.startDefaultPrefix = other.js.startDefaultPrefix;
+	js.hasSetRounding = other.js.hasSetRounding;
+}
+
 void IRFrontend::DoState(PointerWrap &p) {
 	auto s = p.Section("Jit", 1, 2);
 	if (!s)
@@ -228,6 +233,8 @@ void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &m
 	js.compilerPC = em_address;
 	js.lastContinuedPC = 0;
 	js.initialBlockSize = 0;
+	traceExits_ = IRTraceExits();
+	traceBranchPC_ = 0;
 	js.nextExit = 0;
 	js.downcountAmount = 0;
 	js.curBlock = nullptr;
@@ -255,6 +262,10 @@ void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &m
 	}
 
 	mipsBytes = js.compilerPC - em_address;
+	if (traceBranchPC_ == 0 || js.compilerPC != traceBranchPC_ + 8) {
+		// The block didn't end at a branch a trace could continue from.
+		traceExits_ = IRTraceExits();
+	}
 
 	IRWriter simplified;
 	IRWriter *code = &ir;
@@ -265,6 +276,7 @@ void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &m
 			&OptimizeFPMoves,
 			&PropagateConstants,
 			&PurgeTemps,
+			&RemoveDeadStores,
 			// &ReorderLoadStore,
 			// &MergeLoadStore,
 			// &ThreeOpToTwoOp,
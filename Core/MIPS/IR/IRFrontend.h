@@ -1,5 +1,7 @@
 #pragma once
 
+#include <unordered_map>
+
 #include "Common/CommonTypes.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/MIPS/JitCommon/JitState.h"
@@ -8,9 +10,18 @@
 
 namespace MIPSComp {
 
+// The exits of a block's final branch that a trace could continue along, if they get hot.
+struct IRTraceExits {
+	// Start of the code leading up to the branch, which is what hot successors are keyed on.
+	u32 from = 0;
+	u32 dests[2]{};
+};
+
 class IRFrontend : public MIPSFrontendInterface {
 public:
 	IRFrontend(bool startDefaultPrefix);
+	// Same settings as other with fresh compile state, used for preloading on other threads.
+	IRFrontend(const IRFrontend &other);
 	void Comp_Generic(MIPSOpcode op) override;
 
 	void Comp_RunBlock(MIPSOpcode op) override;
@@ -87,8 +98,18 @@ class IRFrontend : public MIPSFrontendInterface {
 	int Replace_fabsf() override;
 	void DoState(PointerWrap &p);
 	bool CheckRounding(u32 blockAddress);  // returns true if we need a do-over
+	bool HasSetRounding() const {
+		return js.hasSetRounding != 0;
+	}
+	void SetHasSetRounding() {
+		js.hasSetRounding = 1;
+	}
 
 	void DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes, bool preload);
+	// For the block DoJit() last compiled.
+	const IRTraceExits &GetTraceExits() const {
+		return traceExits_;
+	}
 
 	void EatPrefix() override {
 		js.EatPrefix();
@@ -98,6 +119,16 @@ class IRFrontend : public MIPSFrontendInterface {
 		opts = o;
 	}
 
+	// Code from start (see IRTraceExits) will be compiled to continue along dest, when it's the
+	// target of the branch ending it.  Returns false if a successor was already recorded.
+	bool AddHotSuccessor(u32 start, u32 dest) {
+		return hotSuccessors_.insert(std::make_pair(start, dest)).second;
+	}
+	void ClearHotSuccessors() {
+		hotSuccessors_.clear();
+	}
+	void InvalidateHotSuccessors(u32 address, u32 length);
+
 private:
 	void RestoreRoundingMode(bool force = false);
 	void ApplyRoundingMode(bool force = false);
@@ -119,6 +150,8 @@ class IRFrontend : public MIPSFrontendInterface {
 	void BranchVFPUFlag(MIPSOpcode op, IRComparison cc, bool likely);
 	void BranchRSZeroComp(MIPSOpcode op, IRComparison cc, bool andLink, bool likely);
 	void BranchRSRTComp(MIPSOpcode op, IRComparison cc, bool likely);
+	u32 TraceBranch(const BranchInfo &branchInfo, u32 targetAddr, u32 notTakenAddr);
+	void FinishBranch(u32 targetAddr, u32 traceTarget);
 
 	// Utilities to reduce duplicated code
 	void CompShiftImm(MIPSOpcode op, IROp shiftType, int sa);
@@ -139,6 +172,11 @@ class IRFrontend : public MIPSFrontendInterface {
 
 	int dontLogBlocks = 0;
 	int logBlocks = 0;
+
+	// Block start -> hot successor, filled in by the dispatcher's exit counts.
+	std::unordered_map<u32, u32> hotSuccessors_;
+	IRTraceExits traceExits_;
+	u32 traceBranchPC_ = 0;
 };
 
 }  // namespace
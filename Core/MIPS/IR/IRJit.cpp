@@ -15,10 +15,12 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <atomic>
 #include <set>
 
 #include "ext/xxhash.h"
 #include "Common/Profiler/Profiler.h"
+#include "Common/Thread/ParallelLoop.h"
 
 #include "Common/Log.h"
 #include "Common/Serialize/Serializer.h"
@@ -66,15 +68,20 @@ void IRJit::UpdateFCR31() {
 void IRJit::ClearCache() {
 	INFO_LOG(JIT, "IRJit: Clearing the cache!");
 	blocks_.Clear();
+	frontend_.ClearHotSuccessors();
 }
 
 void IRJit::InvalidateCacheAt(u32 em_address, int length) {
 	blocks_.InvalidateICache(em_address, length);
+	frontend_.InvalidateHotSuccessors(em_address, length);
 }
 
 void IRJit::Compile(u32 em_address) {
 	PROFILE_THIS_SCOPE("jitc");
 
+	// We're called from the dispatcher, so nothing is running from the arena right now.
+	blocks_.CompactIfNeeded();
+
 	if (g_Config.bPreloadFunctions) {
 		// Look to see if we've preloaded this block.
 		int block_num = blocks_.FindPreloadBlock(em_address);
@@ -113,15 +120,20 @@ bool IRJit::CompileBlock(u32 em_address, std::vector<IRInst> &instructions, u32
 		return preload;
 	}
 
+	return AddBlock(em_address, instructions, mipsBytes, frontend_.GetTraceExits(), preload);
+}
+
+bool IRJit::AddBlock(u32 em_address, const std::vector<IRInst> &instructions, u32 mipsBytes, const IRTraceExits &traceExits, bool preload) {
 	int block_num = blocks_.AllocateBlock(em_address);
 	if ((block_num & ~MIPS_EMUHACK_VALUE_MASK) != 0) {
 		// Out of block numbers.  Caller will handle.
 		return false;
 	}
 
+	blocks_.SetBlockInstructions(block_num, instructions);
 	IRBlock *b = blocks_.GetBlock(block_num);
-	b->SetInstructions(instructions);
 	b->SetOriginalSize(mipsBytes);
+	b->SetTraceExits(traceExits);
 	if (preload) {
 		// Hash, then only update page stats, don't link yet.
 		b->UpdateHash();
@@ -138,6 +150,53 @@ bool IRJit::CompileBlock(u32 em_address, std::vector<IRInst> &instructions, u32
 void IRJit::CompileFunction(u32 start_address, u32 length) {
 	PROFILE_THIS_SCOPE("jitc");
 
+	std::vector<PreloadedBlock> preloaded;
+	PreloadFunction(frontend_, start_address, length, preloaded);
+	AddPreloadedBlocks(preloaded);
+}
+
+void IRJit::CompileFunctions(const std::vector<std::pair<u32, u32>> &ranges) {
+	PROFILE_THIS_SCOPE("jitc");
+
+	// Nothing in the frontend is shared between functions and preloading doesn't write emuhacks,
+	// so functions can be compiled in any order.  Only adding the blocks has to happen here.
+	std::vector<std::vector<PreloadedBlock>> preloaded(ranges.size());
+	std::atomic<bool> setRounding(false);
+	ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+		IRFrontend frontend(frontend_);
+		for (int i = l; i < h; ++i) {
+			PreloadFunction(frontend, ranges[i].first, ranges[i].second, preloaded[i]);
+		}
+		if (frontend.HasSetRounding()) {
+			setRounding = true;
+		}
+	}, 0, (int)ranges.size(), 16);
+
+	// Otherwise CheckRounding() wouldn't notice until it compiled such a block itself.
+	if (setRounding) {
+		frontend_.SetHasSetRounding();
+	}
+
+	for (const auto &blocks : preloaded) {
+		if (!AddPreloadedBlocks(blocks)) {
+			break;
+		}
+	}
+}
+
+bool IRJit::AddPreloadedBlocks(const std::vector<PreloadedBlock> &preloaded) {
+	for (const PreloadedBlock &block : preloaded) {
+		if (!AddBlock(block.em_address, block.instructions, block.mipsBytes, block.traceExits, true)) {
+			// Ran out of block numbers - let's hope there's no more code it needs to run.
+			// Will flush when actually compiling.
+			ERROR_LOG(JIT, "Ran out of block numbers while compiling function");
+			return false;
+		}
+	}
+	return true;
+}
+
+void IRJit::PreloadFunction(IRFrontend &frontend, u32 start_address, u32 length, std::vector<PreloadedBlock> &preloaded) {
 	// Note: we don't actually write emuhacks yet, so we can validate hashes.
 	// This way, if the game changes the code afterward, we'll catch even without icache invalidation.
 
@@ -156,18 +215,15 @@ void IRJit::CompileFunction(u32 start_address, u32 length) {
 			continue;
 		}
 
-		std::vector<IRInst> instructions;
-		u32 mipsBytes;
-		if (!CompileBlock(em_address, instructions, mipsBytes, true)) {
-			// Ran out of block numbers - let's hope there's no more code it needs to run.
-			// Will flush when actually compiling.
-			ERROR_LOG(JIT, "Ran out of block numbers while compiling function");
-			return;
-		}
+		PreloadedBlock block;
+		block.em_address = em_address;
+		frontend.DoJit(em_address, block.instructions, block.mipsBytes, true);
+		block.traceExits = frontend.GetTraceExits();
+		u32 mipsBytes = block.mipsBytes;
 
 		doneAddresses.insert(em_address);
 
-		for (const IRInst &inst : instructions) {
+		for (const IRInst &inst : block.instructions) {
 			u32 exit = 0;
 
 			switch (inst.op) {
@@ -201,6 +257,11 @@ void IRJit::CompileFunction(u32 start_address, u32 length) {
 			}
 		}
 
+		// Cancelled blocks come back empty, they'll be compiled when actually reached.
+		if (!block.instructions.empty()) {
+			preloaded.push_back(std::move(block));
+		}
+
 		// Also include after the block for jal returns.
 		if (em_address + mipsBytes < start_address + length) {
 			pendingAddresses.push_back(em_address + mipsBytes);
@@ -221,29 +282,61 @@ void IRJit::RunLoopUntil(u64 globalticks) {
 		if (coreState != 0) {
 			break;
 		}
+		// Set while chaining along a linked exit, so the emuhack at the target needn't be decoded.
+		int blockNum = -1;
 		while (mips_->downcount >= 0) {
-			u32 inst = Memory::ReadUnchecked_U32(mips_->pc);
-			u32 opcode = inst & 0xFF000000;
-			if (opcode == MIPS_EMUHACK_OPCODE) {
-				u32 data = inst & 0xFFFFFF;
-				IRBlock *block = blocks_.GetBlock(data);
-				u32 startPC = mips_->pc;
-				mips_->pc = IRInterpret(mips_, block->GetInstructions(), block->GetNumInstructions());
+			if (blockNum < 0) {
+				u32 inst = Memory::ReadUnchecked_U32(mips_->pc);
+				u32 opcode = inst & 0xFF000000;
+				if (opcode != MIPS_EMUHACK_OPCODE) {
+					// RestoreRoundingMode(true);
+					MIPSComp::CompileWithStats(this, mips_->pc);
+					// ApplyRoundingMode(true);
+					continue;
+				}
+				blockNum = inst & 0xFFFFFF;
+			}
+
+			IRBlock *block = blocks_.GetBlock(blockNum);
+			u32 startPC = mips_->pc;
+			mips_->pc = IRInterpret(mips_, blocks_.GetBlockInstructions(*block), block->GetNumInstructions());
+
+			// Look the block up again, a syscall may have cleared the cache.
+			int next = blocks_.TakeExit(blockNum, mips_->pc);
+			if (next == IRBlock::HOT_EXIT) {
+				FormTrace(blockNum, mips_->pc);
+				next = -1;
+			}
+			if (next < 0) {
 				if (!Memory::IsValidAddress(mips_->pc) || (mips_->pc & 3) != 0) {
 					Core_ExecException(mips_->pc, startPC, ExecExceptionType::JUMP);
 					break;
 				}
-			} else {
-				// RestoreRoundingMode(true);
-				Compile(mips_->pc);
-				// ApplyRoundingMode(true);
+				next = blocks_.LinkBlockExit(blockNum, mips_->pc);
 			}
+			blockNum = next;
 		}
 	}
 
 	// RestoreRoundingMode(true);
 }
 
+void IRJit::FormTrace(int block_num, u32 dest) {
+	// Only the final branch's exits can be followed, and only those the frontend said it would.
+	// These are keyed on where that branch's code starts, which is past the block start in a trace.
+	const IRTraceExits &traceExits = blocks_.GetBlock(block_num)->GetTraceExits();
+	if (dest == 0 || (dest != traceExits.dests[0] && dest != traceExits.dests[1])) {
+		return;
+	}
+	// Each start is traced once.
+	if (!frontend_.AddHotSuccessor(traceExits.from, dest)) {
+		return;
+	}
+
+	// Next time we get here, it'll be recompiled continuing along dest.
+	blocks_.DestroyBlock(block_num);
+}
+
 bool IRJit::DescribeCodePtr(const u8 *ptr, std::string &name) {
 	// Used in target disassembly viewer.
 	return false;
@@ -268,6 +361,85 @@ void IRBlockCache::Clear() {
 	}
 	blocks_.clear();
 	byPage_.clear();
+	linkedFrom_.clear();
+	arenaChunks_.clear();
+	arenaPos_ = ARENA_CHUNK_SIZE;
+	arenaLive_ = 0;
+	arenaDead_ = 0;
+}
+
+u32 IRBlockCache::AllocateArena(u32 count) {
+	// Nothing to place, and there may not even be a chunk yet to point into.
+	if (count == 0) {
+		return 0;
+	}
+	if (arenaPos_ + count > ARENA_CHUNK_SIZE) {
+		// Just waste the tail, blocks are small compared to a chunk.
+		arenaChunks_.push_back(std::unique_ptr<IRInst[]>(new IRInst[ARENA_CHUNK_SIZE]));
+		arenaPos_ = 0;
+	}
+	u32 offset = ((u32)(arenaChunks_.size() - 1) << ARENA_CHUNK_SHIFT) | arenaPos_;
+	arenaPos_ += count;
+	arenaLive_ += count;
+	return offset;
+}
+
+void IRBlockCache::SetBlockInstructions(int i, const std::vector<IRInst> &inst) {
+	u32 offset = AllocateArena((u32)inst.size());
+	IRInst *dest = nullptr;
+	if (!inst.empty()) {
+		dest = arenaChunks_[offset >> ARENA_CHUNK_SHIFT].get() + (offset & (ARENA_CHUNK_SIZE - 1));
+		memcpy(dest, &inst[0], sizeof(IRInst) * inst.size());
+	}
+	blocks_[i].SetInstructions(offset, dest, (u16)inst.size());
+}
+
+void IRBlockCache::CompactIfNeeded() {
+	// Only worth it once at least a chunk's worth is garbage, and more of it than is in use.
+	if (arenaDead_ < ARENA_CHUNK_SIZE || arenaDead_ < arenaLive_) {
+		return;
+	}
+
+	std::vector<std::unique_ptr<IRInst[]>> oldChunks;
+	oldChunks.swap(arenaChunks_);
+	arenaPos_ = ARENA_CHUNK_SIZE;
+	arenaLive_ = 0;
+	arenaDead_ = 0;
+
+	// Place blocks after the ones that chain into them, so hot paths end up next to each other.
+	std::vector<bool> placed(blocks_.size(), false);
+	std::vector<int> pending;
+	for (int first = 0; first < (int)blocks_.size(); ++first) {
+		pending.push_back(first);
+		while (!pending.empty()) {
+			int i = pending.back();
+			pending.pop_back();
+			if (placed[i]) {
+				continue;
+			}
+			placed[i] = true;
+
+			IRBlock &b = blocks_[i];
+			int count = b.GetNumInstructions();
+			if (count == 0) {
+				continue;
+			}
+			u32 oldOffset = b.GetArenaOffset();
+			const IRInst *src = oldChunks[oldOffset >> ARENA_CHUNK_SHIFT].get() + (oldOffset & (ARENA_CHUNK_SIZE - 1));
+			u32 offset = AllocateArena(count);
+			memcpy(arenaChunks_[offset >> ARENA_CHUNK_SHIFT].get() + (offset & (ARENA_CHUNK_SIZE - 1)), src, sizeof(IRInst) * count);
+			b.MoveInstructions(offset);
+
+			for (int e = b.GetNumExits() - 1; e >= 0; --e) {
+				int next = b.GetExitBlock(e);
+				if (next >= 0 && !placed[next]) {
+					pending.push_back(next);
+				}
+			}
+		}
+	}
+
+	INFO_LOG(JIT, "IR arena compacted to %d chunks", (int)arenaChunks_.size());
 }
 
 void IRBlockCache::InvalidateICache(u32 address, u32 length) {
@@ -283,12 +455,50 @@ void IRBlockCache::InvalidateICache(u32 address, u32 length) {
 		for (int i : blocksInPage) {
 			if (blocks_[i].OverlapsRange(address, length)) {
 				// Not removing from the page, hopefully doesn't build up with small recompiles.
-				blocks_[i].Destroy(i);
+				DestroyBlock(i);
 			}
 		}
 	}
 }
 
+void IRBlockCache::DestroyBlock(int i) {
+	blocks_[i].Destroy(i);
+	// The instructions stay put until the next compaction, they may still be running.
+	arenaLive_ -= blocks_[i].GetNumInstructions();
+	arenaDead_ += blocks_[i].GetNumInstructions();
+	blocks_[i].ReleaseInstructions();
+
+	// Anything chaining into it now has to go through the dispatcher again.
+	auto iter = linkedFrom_.find(i);
+	if (iter != linkedFrom_.end()) {
+		for (int from : iter->second) {
+			blocks_[from].UnlinkExitsTo(i);
+		}
+		linkedFrom_.erase(iter);
+	}
+}
+
+int IRBlockCache::LinkBlockExit(int i, u32 dest) {
+	if (i < 0 || i >= (int)blocks_.size() || !blocks_[i].IsValid()) {
+		return -1;
+	}
+
+	// Only resolve once the target has been compiled and finalized.
+	u32 inst = Memory::ReadUnchecked_U32(dest);
+	if ((inst & 0xFF000000) != MIPS_EMUHACK_OPCODE) {
+		return -1;
+	}
+	int target = inst & 0xFFFFFF;
+	if (target >= (int)blocks_.size() || !blocks_[target].IsValid()) {
+		return -1;
+	}
+
+	if (blocks_[i].LinkExit(dest, target)) {
+		linkedFrom_[target].push_back(i);
+	}
+	return target;
+}
+
 void IRBlockCache::FinalizeBlock(int i, bool preload) {
 	if (!preload) {
 		blocks_[i].Finalize(i);
@@ -377,7 +587,7 @@ JitBlockDebugInfo IRBlockCache::GetBlockDebugInfo(int blockNum) const {
 	}
 
 	for (int i = 0; i < ir.GetNumInstructions(); i++) {
-		IRInst inst = ir.GetInstructions()[i];
+		IRInst inst = GetBlockInstructions(ir)[i];
 		char buffer[256];
 		DisassembleIR(buffer, sizeof(buffer), inst);
 		debugInfo.irDisasm.push_back(buffer);
@@ -461,6 +671,7 @@ void IRBlock::Finalize(int number) {
 }
 
 void IRBlock::Destroy(int number) {
+	numExits_ = 0;
 	if (origAddr_) {
 		MIPSOpcode opcode = MIPSOpcode(MIPS_EMUHACK_OPCODE | number);
 		if (Memory::ReadUnchecked_U32(origAddr_) == opcode.encoding)
@@ -489,6 +700,51 @@ u64 IRBlock::CalculateHash() const {
 	return 0;
 }
 
+void IRBlock::CollectExits(const IRInst *instr) {
+	numExits_ = 0;
+	for (int i = 0; i < numInstructions_; ++i) {
+		const IRInst &inst = instr[i];
+		switch (inst.op) {
+		case IROp::ExitToConst:
+		case IROp::ExitToConstIfEq:
+		case IROp::ExitToConstIfNeq:
+		case IROp::ExitToConstIfGtZ:
+		case IROp::ExitToConstIfGeZ:
+		case IROp::ExitToConstIfLtZ:
+		case IROp::ExitToConstIfLeZ:
+		case IROp::ExitToConstIfFpTrue:
+		case IROp::ExitToConstIfFpFalse:
+			if (!HasExit(inst.constant) && numExits_ < MAX_LINKED_EXITS) {
+				exits_[numExits_].dest = inst.constant;
+				exits_[numExits_].block = -1;
+				exits_[numExits_].hits = 0;
+				numExits_++;
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+}
+
+bool IRBlock::LinkExit(u32 dest, int block) {
+	for (int i = 0; i < numExits_; ++i) {
+		if (exits_[i].dest == dest && exits_[i].block == -1) {
+			exits_[i].block = block;
+			return true;
+		}
+	}
+	return false;
+}
+
+void IRBlock::UnlinkExitsTo(int block) {
+	for (int i = 0; i < numExits_; ++i) {
+		if (exits_[i].block == block)
+			exits_[i].block = -1;
+	}
+}
+
 bool IRBlock::OverlapsRange(u32 addr, u32 size) const {
 	addr &= 0x3FFFFFFF;
 	u32 origAddr = origAddr_ & 0x3FFFFFFF;
@@ -18,6 +18,7 @@
 #pragma once
 
 #include <cstring>
+#include <memory>
 #include <unordered_map>
 
 #include "Common/CommonTypes.h"
@@ -35,34 +36,27 @@
 
 namespace MIPSComp {
 
-// TODO : Use arena allocators. For now let's just malloc.
+// Instructions live in the owning IRBlockCache's arena, blocks only hold an offset.
 class IRBlock {
 public:
-	IRBlock() : instr_(nullptr), numInstructions_(0), origAddr_(0), origSize_(0) {}
-	IRBlock(u32 emAddr) : instr_(nullptr), numInstructions_(0), origAddr_(emAddr), origSize_(0) {}
-	IRBlock(IRBlock &&b) {
-		instr_ = b.instr_;
-		numInstructions_ = b.numInstructions_;
-		origAddr_ = b.origAddr_;
-		origSize_ = b.origSize_;
-		origFirstOpcode_ = b.origFirstOpcode_;
-		hash_ = b.hash_;
-		b.instr_ = nullptr;
-	}
-
-	~IRBlock() {
-		delete[] instr_;
-	}
-
-	void SetInstructions(const std::vector<IRInst> &inst) {
-		instr_ = new IRInst[inst.size()];
-		numInstructions_ = (u16)inst.size();
-		if (!inst.empty()) {
-			memcpy(instr_, &inst[0], sizeof(IRInst) * inst.size());
-		}
+	IRBlock() {}
+	IRBlock(u32 emAddr) : origAddr_(emAddr) {}
+
+	void SetInstructions(u32 arenaOffset, const IRInst *instr, u16 count) {
+		arenaOffset_ = arenaOffset;
+		numInstructions_ = count;
+		CollectExits(instr);
+	}
+	void MoveInstructions(u32 arenaOffset) {
+		arenaOffset_ = arenaOffset;
+	}
+	void ReleaseInstructions() {
+		numInstructions_ = 0;
 	}
 
-	const IRInst *GetInstructions() const { return instr_; }
+	int GetNumExits() const { return numExits_; }
+	int GetExitBlock(int i) const { return exits_[i].block; }
+	u32 GetArenaOffset() const { return arenaOffset_; }
 	int GetNumInstructions() const { return numInstructions_; }
 	MIPSOpcode GetOriginalFirstOp() const { return origFirstOpcode_; }
 	bool HasOriginalFirstOp() const;
@@ -79,23 +73,67 @@ class IRBlock {
 	}
 	bool OverlapsRange(u32 addr, u32 size) const;
 
+	// Counts the exit as taken. Returns the block number a constant exit to dest has been
+	// linked to, -1 if none, or HOT_EXIT once a conditional block's exit gets hot.
+	int TakeExit(u32 dest) {
+		for (int i = 0; i < numExits_; ++i) {
+			if (exits_[i].dest == dest) {
+				if (++exits_[i].hits == HOT_EXIT_HITS && numExits_ > 1)
+					return HOT_EXIT;
+				return exits_[i].block;
+			}
+		}
+		return -1;
+	}
+	enum {
+		HOT_EXIT = -2,
+		HOT_EXIT_HITS = 1000,
+	};
+	bool LinkExit(u32 dest, int block);
+	void UnlinkExitsTo(int block);
+
 	void GetRange(u32 &start, u32 &size) const {
 		start = origAddr_;
 		size = origSize_;
 	}
+	void SetTraceExits(const IRTraceExits &traceExits) {
+		traceExits_ = traceExits;
+	}
+	const IRTraceExits &GetTraceExits() const {
+		return traceExits_;
+	}
 
 	void Finalize(int number);
 	void Destroy(int number);
 
 private:
 	u64 CalculateHash() const;
+	void CollectExits(const IRInst *instr);
+	bool HasExit(u32 dest) const {
+		for (int i = 0; i < numExits_; ++i) {
+			if (exits_[i].dest == dest)
+				return true;
+		}
+		return false;
+	}
 
-	IRInst *instr_;
-	u16 numInstructions_;
-	u32 origAddr_;
-	u32 origSize_;
+	// Blocks rarely have more than a taken and a not taken exit.
+	enum { MAX_LINKED_EXITS = 4 };
+	struct Exit {
+		u32 dest;
+		int block;
+		u32 hits;
+	};
+
+	u32 arenaOffset_ = 0;
+	u16 numInstructions_ = 0;
+	u32 origAddr_ = 0;
+	u32 origSize_ = 0;
 	u64 hash_ = 0;
 	MIPSOpcode origFirstOpcode_ = MIPSOpcode(0x68FFFFFF);
+	Exit exits_[MAX_LINKED_EXITS];
+	int numExits_ = 0;
+	IRTraceExits traceExits_;
 };
 
 class IRBlockCache : public JitBlockCacheDebugInterface {
@@ -109,6 +147,17 @@ class IRBlockCache : public JitBlockCacheDebugInterface {
 		blocks_.push_back(IRBlock(emAddr));
 		return (int)blocks_.size() - 1;
 	}
+	void SetBlockInstructions(int i, const std::vector<IRInst> &inst);
+	const IRInst *GetBlockInstructions(const IRBlock &b) const {
+		// Empty blocks own no arena space, their offset may not point at a chunk.
+		if (b.GetNumInstructions() == 0)
+			return nullptr;
+		u32 offset = b.GetArenaOffset();
+		return arenaChunks_[offset >> ARENA_CHUNK_SHIFT].get() + (offset & (ARENA_CHUNK_SIZE - 1));
+	}
+	// Only safe while no block is being interpreted, invalidations just mark it as needed.
+	void CompactIfNeeded();
+	void DestroyBlock(int i);
 	IRBlock *GetBlock(int i) {
 		if (i >= 0 && i < (int)blocks_.size()) {
 			return &blocks_[i];
@@ -119,6 +168,16 @@ class IRBlockCache : public JitBlockCacheDebugInterface {
 
 	int FindPreloadBlock(u32 em_address);
 
+	// Exit links let the dispatcher chain from block to block without decoding the emuhack at
+	// the target each time. They're dropped when either side is invalidated.
+	int TakeExit(int i, u32 dest) {
+		if (i >= 0 && i < (int)blocks_.size()) {
+			return blocks_[i].TakeExit(dest);
+		}
+		return -1;
+	}
+	int LinkBlockExit(int i, u32 dest);
+
 	std::vector<u32> SaveAndClearEmuHackOps();
 	void RestoreSavedEmuHackOps(std::vector<u32> saved);
 
@@ -128,9 +187,25 @@ class IRBlockCache : public JitBlockCacheDebugInterface {
 
 private:
 	u32 AddressToPage(u32 addr) const;
+	u32 AllocateArena(u32 count);
+
+	// A block has at most 65535 instructions, so it always fits in one chunk. Chunks never move,
+	// since preloading may compile while a block is still being interpreted.
+	enum {
+		ARENA_CHUNK_SHIFT = 16,
+		ARENA_CHUNK_SIZE = 1 << ARENA_CHUNK_SHIFT,
+	};
 
 	std::vector<IRBlock> blocks_;
 	std::unordered_map<u32, std::vector<int>> byPage_;
+	// Target block -> blocks with an exit linked to it.
+	std::unordered_map<int, std::vector<int>> linkedFrom_;
+
+	std::vector<std::unique_ptr<IRInst[]>> arenaChunks_;
+	// Next free instruction in the last chunk.
+	u32 arenaPos_ = ARENA_CHUNK_SIZE;
+	u32 arenaLive_ = 0;
+	u32 arenaDead_ = 0;
 };
 
 class IRJit : public JitInterface {
@@ -146,6 +221,7 @@ class IRJit : public JitInterface {
 
 	void Compile(u32 em_address) override;	// Compiles a block at current MIPS PC
 	void CompileFunction(u32 start_address, u32 length) override;
+	void CompileFunctions(const std::vector<std::pair<u32, u32>> &ranges) override;
 
 	bool DescribeCodePtr(const u8 *ptr, std::string &name) override;
 	// Not using a regular block cache.
@@ -171,7 +247,19 @@ class IRJit : public JitInterface {
 	void UnlinkBlock(u8 *checkedEntry, u32 originalAddress) override;
 
 private:
+	struct PreloadedBlock {
+		u32 em_address;
+		u32 mipsBytes;
+		IRTraceExits traceExits;
+		std::vector<IRInst> instructions;
+	};
+
 	bool CompileBlock(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes, bool preload);
+	bool AddBlock(u32 em_address, const std::vector<IRInst> &instructions, u32 mipsBytes, const IRTraceExits &traceExits, bool preload);
+	// Doesn't touch the block cache, so may run on any thread with its own frontend.
+	void PreloadFunction(IRFrontend &frontend, u32 start_address, u32 length, std::vector<PreloadedBlock> &preloaded);
+	bool AddPreloadedBlocks(const std::vector<PreloadedBlock> &preloaded);
+	void FormTrace(int block_num, u32 dest);
 	bool ReplaceJalTo(u32 dest);
 
 	JitOptions jo;
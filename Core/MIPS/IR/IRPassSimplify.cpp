@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <bitset>
 #include <cstring>
 #include <utility>
 
@@ -973,6 +974,185 @@ bool PurgeTemps(const IRWriter &in, IRWriter &out, const IROptions &opts) {
 	return logBlocks;
 }
 
+// Liveness is tracked per 32-bit word of MIPSState, since G regs index from r and F regs from f,
+// and the two overlap (e.g. lo/hi, vfpuCtrl.)
+static const int IRLIVE_F_BASE = 32;
+typedef std::bitset<IRLIVE_F_BASE + 256> IRLiveSet;
+
+struct IRRegRange {
+	int word;
+	int count;
+};
+
+struct IRRegEffects {
+	IRRegRange reads[4];
+	int numReads = 0;
+	IRRegRange writes[2];
+	int numWrites = 0;
+	// May read any state, or has effects not described by reads/writes.
+	bool barrier = false;
+	// Nothing happens other than the writes, so it can go if they're all dead.
+	bool pure = false;
+
+	void Read(int word, int count) {
+		reads[numReads++] = IRRegRange{ word, count };
+	}
+	void Write(int word, int count) {
+		writes[numWrites++] = IRRegRange{ word, count };
+	}
+};
+
+static bool IRRegOperand(char type, int reg, int *word, int *count) {
+	switch (type) {
+	case 'G': *word = reg; *count = 1; return true;
+	case 'F': *word = IRLIVE_F_BASE + reg; *count = 1; return true;
+	case '2': *word = IRLIVE_F_BASE + reg; *count = 2; return true;
+	case 'V': *word = IRLIVE_F_BASE + reg; *count = 4; return true;
+	default: return false;
+	}
+}
+
+static void IRGetRegEffects(const IRInst &inst, IRRegEffects &e) {
+	const IRMeta *m = GetIRMeta(inst.op);
+	if (!m || (m->flags & IRFLAG_EXIT) != 0) {
+		e.barrier = true;
+		return;
+	}
+
+	switch (inst.op) {
+	case IROp::Interpret:
+	case IROp::CallReplacement:
+	case IROp::VfpuCtrlToReg:
+	case IROp::SetCtrlVFPU:
+	case IROp::SetCtrlVFPUReg:
+	case IROp::SetCtrlVFPUFReg:
+	case IROp::FCmovVfpuCC:
+	case IROp::FCmpVfpuBit:
+	case IROp::FCmpVfpuAggregate:
+	case IROp::RestoreRoundingMode:
+	case IROp::ApplyRoundingMode:
+	case IROp::UpdateRoundingMode:
+		// Could be described, but they're rare - not worth the risk.
+		e.barrier = true;
+		return;
+	default:
+		break;
+	}
+
+	int word, count;
+	if (IRRegOperand(m->types[1], inst.src1, &word, &count))
+		e.Read(word, count);
+	if (IRRegOperand(m->types[2], inst.src2, &word, &count))
+		e.Read(word, count);
+	if (IRRegOperand(m->types[0], inst.dest, &word, &count)) {
+		if ((m->flags & (IRFLAG_SRC3 | IRFLAG_SRC3DST)) != 0)
+			e.Read(word, count);
+		if ((m->flags & IRFLAG_SRC3) == 0) {
+			e.Write(word, count);
+			// Stores have no dest, so everything left with one is loads or math.
+			e.pure = true;
+		}
+	}
+
+	switch (inst.op) {
+	case IROp::Mult:
+	case IROp::MultU:
+	case IROp::Div:
+	case IROp::DivU:
+		e.Write(IRREG_LO, 2);
+		e.pure = true;
+		break;
+	case IROp::Madd:
+	case IROp::MaddU:
+	case IROp::Msub:
+	case IROp::MsubU:
+		e.Read(IRREG_LO, 2);
+		e.Write(IRREG_LO, 2);
+		e.pure = true;
+		break;
+	case IROp::MtLo:
+	case IROp::MtHi:
+		e.Write(inst.op == IROp::MtLo ? IRREG_LO : IRREG_HI, 1);
+		e.pure = true;
+		break;
+	case IROp::MfLo:
+	case IROp::MfHi:
+		e.Read(inst.op == IROp::MfLo ? IRREG_LO : IRREG_HI, 1);
+		break;
+	case IROp::FCmp:
+	case IROp::ZeroFpCond:
+		e.Write(IRREG_FPCOND, 1);
+		e.pure = true;
+		break;
+	case IROp::FpCondToReg:
+		e.Read(IRREG_FPCOND, 1);
+		break;
+	default:
+		break;
+	}
+}
+
+static bool IRAnyLive(const IRLiveSet &live, const IRRegRange &range) {
+	for (int i = 0; i < range.count; ++i) {
+		if (live[range.word + i])
+			return true;
+	}
+	return false;
+}
+
+// Walks backward, calling func(index, effects, live after the inst) before updating live.
+template <typename F>
+static void IRWalkLiveness(const IRInst *insts, int count, F func) {
+	IRLiveSet live;
+	// Whatever comes after the block might read anything.
+	live.set();
+	for (int i = count - 1; i >= 0; --i) {
+		IRRegEffects e;
+		IRGetRegEffects(insts[i], e);
+		if (!func(i, e, live))
+			continue;
+
+		if (e.barrier) {
+			live.set();
+			continue;
+		}
+		for (int w = 0; w < e.numWrites; ++w) {
+			for (int j = 0; j < e.writes[w].count; ++j)
+				live.reset(e.writes[w].word + j);
+		}
+		for (int r = 0; r < e.numReads; ++r) {
+			for (int j = 0; j < e.reads[r].count; ++j)
+				live.set(e.reads[r].word + j);
+		}
+	}
+}
+
+bool RemoveDeadStores(const IRWriter &in, IRWriter &out, const IROptions &opts) {
+	CONDITIONAL_DISABLE;
+	const std::vector<IRInst> &insts = in.GetInstructions();
+	std::vector<bool> dead(insts.size(), false);
+
+	// PurgeTemps already catches most GPR cases, this mostly gets FPU/VFPU and lo/hi.
+	// Traces are walked as a whole, their side exits keep everything live like any other exit.
+	IRWalkLiveness(insts.data(), (int)insts.size(), [&](int i, const IRRegEffects &e, const IRLiveSet &live) {
+		if (!e.pure || e.barrier || e.numWrites == 0)
+			return true;
+		for (int w = 0; w < e.numWrites; ++w) {
+			if (IRAnyLive(live, e.writes[w]))
+				return true;
+		}
+		// Skip it, and don't let its reads make anything live.
+		dead[i] = true;
+		return false;
+	});
+
+	for (size_t i = 0; i < insts.size(); ++i) {
+		if (!dead[i])
+			out.Write(insts[i]);
+	}
+	return false;
+}
+
 bool ReduceLoads(const IRWriter &in, IRWriter &out, const IROptions &opts) {
 	CONDITIONAL_DISABLE;
 	// This tells us to skip an AND op that has been optimized out.
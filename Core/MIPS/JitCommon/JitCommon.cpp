@@ -25,11 +25,13 @@
 
 #include "Common/LogReporting.h"
 #include "Common/StringUtils.h"
+#include "Common/TimeUtil.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
 
 #include "Core/Util/DisArm64.h"
 #include "Core/Config.h"
+#include "Core/System.h"
 
 #include "Core/MIPS/IR/IRJit.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
@@ -53,8 +55,22 @@ namespace MIPSComp {
 	JitInterface *jit;
 	std::recursive_mutex jitLock;
 
+	JitCompileStats compileStats;
+
 	void JitAt() {
-		jit->Compile(currentMIPS->pc);
+		CompileWithStats(jit, currentMIPS->pc);
+	}
+
+	void CompileWithStats(JitInterface *jit, u32 em_address) {
+		if (!coreCollectDebugStats) {
+			jit->Compile(em_address);
+			return;
+		}
+
+		double st = time_now_d();
+		jit->Compile(em_address);
+		compileStats.seconds += time_now_d() - st;
+		compileStats.blocks++;
 	}
 
 	void DoDummyJitState(PointerWrap &p) {
@@ -19,6 +19,7 @@
 
 #include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "Common/CommonTypes.h"
@@ -136,6 +137,12 @@ namespace MIPSComp {
 		virtual void RunLoopUntil(u64 globalticks) = 0;
 		virtual void Compile(u32 em_address) = 0;
 		virtual void CompileFunction(u32 start_address, u32 length) { }
+		// Ranges are start address and length pairs.
+		virtual void CompileFunctions(const std::vector<std::pair<u32, u32>> &ranges) {
+			for (const auto &range : ranges) {
+				CompileFunction(range.first, range.second);
+			}
+		}
 		virtual void ClearCache() = 0;
 		virtual void UpdateFCR31() = 0;
 		virtual MIPSOpcode GetOriginalOp(MIPSOpcode op) = 0;
@@ -174,6 +181,14 @@ namespace MIPSComp {
 	extern JitInterface *jit;
 	extern std::recursive_mutex jitLock;
 
+	// Only tracked while coreCollectDebugStats is enabled.
+	struct JitCompileStats {
+		double seconds;
+		int blocks;
+	};
+	extern JitCompileStats compileStats;
+	void CompileWithStats(JitInterface *jit, u32 em_address);
+
 	void DoDummyJitState(PointerWrap &p);
 
 	JitInterface *CreateNativeJit(MIPSState *mipsState);
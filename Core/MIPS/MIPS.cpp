@@ -170,6 +170,7 @@ void MIPSState::Shutdown() {
 		MIPSComp::jit = nullptr;
 		delete oldjit;
 	}
+	MIPSInterpret_ShutdownCache();
 }
 
 void MIPSState::Reset() {
@@ -263,6 +264,8 @@ void MIPSState::UpdateCore(CPUCore desired) {
 			MIPSComp::jit = nullptr;
 			delete oldjit;
 		}
+		// Invalidations went to the jit meanwhile.
+		MIPSInterpret_ClearCache();
 		break;
 	}
 
@@ -364,11 +367,13 @@ void MIPSState::ProcessPendingClears() {
 }
 
 void MIPSState::InvalidateICache(u32 address, int length) {
-	// Only really applies to jit.
 	// Note that the backend is responsible for ensuring native code can still be returned to.
 	std::lock_guard<std::recursive_mutex> guard(MIPSComp::jitLock);
 	if (MIPSComp::jit && length != 0) {
 		MIPSComp::jit->InvalidateCacheAt(address, length);
+	} else if (!MIPSComp::jit) {
+		// The interpreter keeps pre-decoded ops.
+		MIPSInterpret_InvalidateCache(address, length);
 	}
 }
 
@@ -382,5 +387,7 @@ void MIPSState::ClearJitCache() {
 		} else {
 			MIPSComp::jit->ClearCache();
 		}
+	} else {
+		MIPSInterpret_ClearCache();
 	}
 }
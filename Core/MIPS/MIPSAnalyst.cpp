@@ -16,6 +16,7 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include "ppsspp_config.h"
+#include <algorithm>
 #include <map>
 #include <set>
 #include <unordered_map>
@@ -27,6 +28,7 @@
 
 #include "Common/File/FileUtil.h"
 #include "Common/Log.h"
+#include "Common/Thread/ParallelLoop.h"
 #include "Common/TimeUtil.h"
 #include "Core/Config.h"
 #include "Core/MemMap.h"
@@ -867,40 +869,44 @@ namespace MIPSAnalyst {
 		return DetermineRegisterUsage(reg, addr, instrs) == USAGE_CLOBBERED;
 	}
 
-	void HashFunctions() {
-		std::lock_guard<std::recursive_mutex> guard(functions_lock);
-		std::vector<u32> buffer;
+	static void HashFunction(AnalyzedFunction &f, std::vector<u32> &buffer) {
+		if (!Memory::IsValidRange(f.start, f.end - f.start + 4)) {
+			return;
+		}
 
-		for (auto iter = functions.begin(), end = functions.end(); iter != end; iter++) {
-			AnalyzedFunction &f = *iter;
-			if (!Memory::IsValidRange(f.start, f.end - f.start + 4)) {
-				continue;
+		// This is unfortunate.  In case of emuhacks or relocs, we have to make a copy.
+		buffer.resize((f.end - f.start + 4) / 4);
+		size_t pos = 0;
+		for (u32 addr = f.start; addr <= f.end; addr += 4) {
+			u32 validbits = 0xFFFFFFFF;
+			MIPSOpcode instr = Memory::ReadUnchecked_Instruction(addr, true);
+			if (MIPS_IS_EMUHACK(instr)) {
+				f.hasHash = false;
+				return;
 			}
 
-			// This is unfortunate.  In case of emuhacks or relocs, we have to make a copy.
-			buffer.resize((f.end - f.start + 4) / 4);
-			size_t pos = 0;
-			for (u32 addr = f.start; addr <= f.end; addr += 4) {
-				u32 validbits = 0xFFFFFFFF;
-				MIPSOpcode instr = Memory::ReadUnchecked_Instruction(addr, true);
-				if (MIPS_IS_EMUHACK(instr)) {
-					f.hasHash = false;
-					goto skip;
-				}
+			MIPSInfo flags = MIPSGetInfo(instr);
+			if (flags & IN_IMM16)
+				validbits &= ~0xFFFF;
+			if (flags & IN_IMM26)
+				validbits &= ~0x03FFFFFF;
+			buffer[pos++] = instr & validbits;
+		}
 
-				MIPSInfo flags = MIPSGetInfo(instr);
-				if (flags & IN_IMM16)
-					validbits &= ~0xFFFF;
-				if (flags & IN_IMM26)
-					validbits &= ~0x03FFFFFF;
-				buffer[pos++] = instr & validbits;
-			}
+		f.hash = CityHash64((const char *) &buffer[0], buffer.size() * sizeof(u32));
+		f.hasHash = true;
+	}
 
-			f.hash = CityHash64((const char *) &buffer[0], buffer.size() * sizeof(u32));
-			f.hasHash = true;
-skip:
-			;
-		}
+	void HashFunctions() {
+		std::lock_guard<std::recursive_mutex> guard(functions_lock);
+
+		// Functions only read their own memory, so they can be hashed in any order.
+		ParallelRangeLoop(&g_threadManager, [](int l, int h) {
+			std::vector<u32> buffer;
+			for (int i = l; i < h; ++i) {
+				HashFunction(functions[i], buffer);
+			}
+		}, 0, (int)functions.size(), 256);
 	}
 
 	void PrecompileFunction(u32 startAddr, u32 length) {
@@ -920,10 +926,17 @@ namespace MIPSAnalyst {
 		// TODO: Load from cache file if available instead.
 
 		double st = time_now_d();
-		for (auto iter = functions.begin(), end = functions.end(); iter != end; iter++) {
-			const AnalyzedFunction &f = *iter;
-
-			PrecompileFunction(f.start, f.end - f.start + 4);
+		std::vector<std::pair<u32, u32>> ranges;
+		ranges.reserve(functions.size());
+		for (const AnalyzedFunction &f : functions) {
+			ranges.push_back(std::make_pair(f.start, f.end - f.start + 4));
+		}
+		{
+			// The jit may spread these across threads.
+			std::lock_guard<std::recursive_mutex> jitGuard(MIPSComp::jitLock);
+			if (MIPSComp::jit) {
+				MIPSComp::jit->CompileFunctions(ranges);
+			}
 		}
 		double et = time_now_d();
 
@@ -1015,12 +1028,12 @@ namespace MIPSAnalyst {
 		return furthestJumpbackAddr;
 	}
 
-	bool ScanForFunctions(u32 startAddr, u32 endAddr, bool insertSymbols) {
-		std::lock_guard<std::recursive_mutex> guard(functions_lock);
-
-		FunctionsVector new_functions;
-
+	// Scans until endAddr, or until the next function would start at or after stopAddr.  Returns
+	// where that is, or 0 if endAddr was reached.  Since all state is reset between functions,
+	// scans that pass through the same function start agree from there on.
+	static u32 ScanFunctionsFrom(u32 startAddr, u32 stopAddr, u32 endAddr, FunctionsVector &found, std::vector<u32> *scanStarts) {
 		AnalyzedFunction currentFunction = {startAddr};
+		u32 scanStart = startAddr;
 
 		u32 furthestBranch = 0;
 		bool looking = false;
@@ -1124,23 +1137,9 @@ namespace MIPSAnalyst {
 			if (end) {
 				currentFunction.end = addr + 4;
 				currentFunction.isStraightLeaf = isStraightLeaf;
-
-				// Check if we already have symbol info starting here.  If so, skip insertion.
-				// We used to use the symbols to find the functions, but sometimes we'd find
-				// wrong ones due to two modules with the same name.
-				u32 existingSize = g_symbolMap->GetFunctionSize(currentFunction.start);
-				if (existingSize != SymbolMap::INVALID_ADDRESS) {
-					currentFunction.foundInSymbolMap = true;
-
-					// If we run into a func with a different size, skip updating the hash map.
-					// This will prevent us saving incorrectly named funcs with wrong hashes.
-					u32 detectedSize = currentFunction.end - currentFunction.start + 4;
-					if (existingSize != detectedSize) {
-						insertSymbols = false;
-					}
-				}
-
-				new_functions.push_back(currentFunction);
+				found.push_back(currentFunction);
+				if (scanStarts)
+					scanStarts->push_back(scanStart);
 
 				furthestBranch = 0;
 				addr += 4;
@@ -1150,12 +1149,97 @@ namespace MIPSAnalyst {
 				decreasedSp = false;
 				currentFunction.start = addr + 4;
 				currentFunction.foundInSymbolMap = false;
+
+				// Nothing carries over into the next function, so this is a good place to stop.
+				scanStart = currentFunction.start;
+				if (scanStart >= stopAddr) {
+					return scanStart;
+				}
 			}
 		}
 
 		if (addr <= endAddr) {
 			currentFunction.end = addr + 4;
-			new_functions.push_back(currentFunction);
+			found.push_back(currentFunction);
+			if (scanStarts)
+				scanStarts->push_back(scanStart);
+		}
+		return 0;
+	}
+
+	bool ScanForFunctions(u32 startAddr, u32 endAddr, bool insertSymbols) {
+		std::lock_guard<std::recursive_mutex> guard(functions_lock);
+
+		FunctionsVector new_functions;
+
+		// Large ranges are split up, and each chunk scanned as if a function started there.
+		// A chunk's results are used from the first function start the previous chunk's scan
+		// ended at, so the result is the same as scanning in one go.
+		static const u32 MIN_SCAN_CHUNK = 0x10000;
+		u32 scanSize = endAddr >= startAddr ? endAddr - startAddr + 4 : 0;
+		int numChunks = std::min(g_threadManager.GetNumLooperThreads(), (int)(scanSize / MIN_SCAN_CHUNK));
+		if (numChunks <= 1) {
+			ScanFunctionsFrom(startAddr, 0xFFFFFFFF, endAddr, new_functions, nullptr);
+		} else {
+			struct ScanChunk {
+				u32 start;
+				u32 stop;
+				u32 next;
+				FunctionsVector found;
+				std::vector<u32> scanStarts;
+			};
+			std::vector<ScanChunk> chunks(numChunks);
+			u32 chunkSize = (scanSize / numChunks) & ~3;
+			for (int i = 0; i < numChunks; ++i) {
+				chunks[i].start = startAddr + i * chunkSize;
+				chunks[i].stop = i + 1 < numChunks ? chunks[i].start + chunkSize : 0xFFFFFFFF;
+			}
+
+			ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+				for (int i = l; i < h; ++i) {
+					ScanChunk &chunk = chunks[i];
+					chunk.next = ScanFunctionsFrom(chunk.start, chunk.stop, endAddr, chunk.found, &chunk.scanStarts);
+				}
+			}, 0, numChunks, 1);
+
+			u32 next = startAddr;
+			for (ScanChunk &chunk : chunks) {
+				// The previous scan may have reached the end, or gone past this whole chunk.
+				if (next == 0 || next >= chunk.stop) {
+					continue;
+				}
+
+				size_t first = 0;
+				if (next != chunk.start) {
+					auto match = std::lower_bound(chunk.scanStarts.begin(), chunk.scanStarts.end(), next);
+					if (match != chunk.scanStarts.end() && *match == next) {
+						first = match - chunk.scanStarts.begin();
+					} else {
+						// Never lined up, so redo this chunk from the right place.
+						chunk.found.clear();
+						chunk.next = ScanFunctionsFrom(next, chunk.stop, endAddr, chunk.found, nullptr);
+					}
+				}
+				new_functions.insert(new_functions.end(), chunk.found.begin() + first, chunk.found.end());
+				next = chunk.next;
+			}
+		}
+
+		for (auto iter = new_functions.begin(); iter != new_functions.end(); iter++) {
+			// Check if we already have symbol info starting here.  If so, skip insertion.
+			// We used to use the symbols to find the functions, but sometimes we'd find
+			// wrong ones due to two modules with the same name.
+			u32 existingSize = g_symbolMap->GetFunctionSize(iter->start);
+			if (existingSize != SymbolMap::INVALID_ADDRESS) {
+				iter->foundInSymbolMap = true;
+
+				// If we run into a func with a different size, skip updating the hash map.
+				// This will prevent us saving incorrectly named funcs with wrong hashes.
+				u32 detectedSize = iter->end - iter->start + 4;
+				if (existingSize != detectedSize) {
+					insertSymbols = false;
+				}
+			}
 		}
 
 		for (auto iter = new_functions.begin(); iter != new_functions.end(); iter++) {
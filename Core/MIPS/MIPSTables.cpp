@@ -15,6 +15,10 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
 #include "Core/Core.h"
 #include "Core/System.h"
 #include "Core/MemMap.h"
@@ -962,6 +966,103 @@ void MIPSInterpret(MIPSOpcode op) {
 	Interpret(instr, op);
 }
 
+// Pre-decoded instructions for the interpreter, kept per 4KB page of code.
+// Like the jit, this relies on icache invalidation: once decoded, the opcode isn't read from
+// memory again until InvalidateICache or ClearJitCache drops the entry.
+struct PredecodedOp {
+	MIPSOpcode op;
+	bool valid = false;
+	MIPSInterpretFunc interpret = nullptr;
+	MIPSInfo flags;
+};
+
+static const int PREDECODE_PAGE_SHIFT = 12;
+static const u32 PREDECODE_PAGE_OPS = 1 << (PREDECODE_PAGE_SHIFT - 2);
+// Mirrors share pages, since they run the same memory.
+static const u32 PREDECODE_ADDR_MASK = 0x3FFFFFFF;
+
+struct PredecodedPage {
+	PredecodedOp ops[PREDECODE_PAGE_OPS];
+};
+
+// Indexed by page number, allocated on first use.
+static std::vector<std::unique_ptr<PredecodedPage>> predecodedPages;
+static u32 lastPredecodedPageNum = 0xFFFFFFFF;
+static PredecodedPage *lastPredecodedPage = nullptr;
+
+static PredecodedPage *GetPredecodedPage(u32 pageNum) {
+	if (pageNum == lastPredecodedPageNum)
+		return lastPredecodedPage;
+
+	if (predecodedPages.empty())
+		predecodedPages.resize((PREDECODE_ADDR_MASK >> PREDECODE_PAGE_SHIFT) + 1);
+	auto &page = predecodedPages[pageNum];
+	if (!page)
+		page.reset(new PredecodedPage());
+	lastPredecodedPageNum = pageNum;
+	lastPredecodedPage = page.get();
+	return lastPredecodedPage;
+}
+
+static inline const PredecodedOp &GetPredecodedOp(u32 pc) {
+	PredecodedPage *page = GetPredecodedPage((pc & PREDECODE_ADDR_MASK) >> PREDECODE_PAGE_SHIFT);
+	PredecodedOp &entry = page->ops[(pc >> 2) & (PREDECODE_PAGE_OPS - 1)];
+	if (!entry.valid) {
+		// Replacements and similar are processed here, intentionally.
+		entry.op = MIPSOpcode(Memory::Read_U32(pc));
+		const MIPSInstruction *instr = MIPSGetInstruction(entry.op);
+		entry.interpret = instr ? instr->interpret : nullptr;
+		entry.flags = instr ? instr->flags : MIPSInfo(0, 1);
+		// Bad addresses must keep reporting the exception each time.
+		entry.valid = Memory::IsValidAddress(pc);
+	}
+	return entry;
+}
+
+static inline void InterpretPredecoded(const PredecodedOp &entry) {
+	if (entry.interpret) {
+		entry.interpret(entry.op);
+	} else {
+		// Let the slow path report it.
+		Interpret(MIPSGetInstruction(entry.op), entry.op);
+	}
+}
+
+void MIPSInterpret_InvalidateCache(u32 address, int length) {
+	if (length <= 0 || predecodedPages.empty())
+		return;
+
+	u32 start = address & PREDECODE_ADDR_MASK;
+	u32 end = std::min(start + (u32)length - 1, PREDECODE_ADDR_MASK);
+	for (u32 pageNum = start >> PREDECODE_PAGE_SHIFT; pageNum <= end >> PREDECODE_PAGE_SHIFT; ++pageNum) {
+		PredecodedPage *page = predecodedPages[pageNum].get();
+		if (!page)
+			continue;
+
+		u32 pageStart = pageNum << PREDECODE_PAGE_SHIFT;
+		u32 first = start > pageStart ? (start - pageStart) >> 2 : 0;
+		u32 last = std::min((end - pageStart) >> 2, PREDECODE_PAGE_OPS - 1);
+		for (u32 i = first; i <= last; ++i)
+			page->ops[i].valid = false;
+	}
+}
+
+void MIPSInterpret_ClearCache() {
+	// This may be called from a syscall mid-instruction, so just invalidate.
+	for (auto &page : predecodedPages) {
+		if (!page)
+			continue;
+		for (auto &entry : page->ops)
+			entry.valid = false;
+	}
+}
+
+void MIPSInterpret_ShutdownCache() {
+	predecodedPages.clear();
+	lastPredecodedPageNum = 0xFFFFFFFF;
+	lastPredecodedPage = nullptr;
+}
+
 #define _RS   ((op>>21) & 0x1F)
 #define _RT   ((op>>16) & 0x1F)
 #define _RD   ((op>>11) & 0x1F)
@@ -972,13 +1073,11 @@ static inline void RunUntilFast() {
 	// NEVER stop in a delay slot!
 	while (curMips->downcount >= 0 && coreState == CORE_RUNNING) {
 		do {
-			// Replacements and similar are processed here, intentionally.
-			MIPSOpcode op = MIPSOpcode(Memory::Read_U32(curMips->pc));
-
 			bool wasInDelaySlot = curMips->inDelaySlot;
-			const MIPSInstruction *instr = MIPSGetInstruction(op);
-			Interpret(instr, op);
-			curMips->downcount -= GetInstructionCycleEstimate(instr);
+			const PredecodedOp &entry = GetPredecodedOp(curMips->pc);
+			int cycles = entry.flags.cycles;
+			InterpretPredecoded(entry);
+			curMips->downcount -= cycles;
 
 			// The reason we have to check this is the delay slot hack in Int_Syscall.
 			if (curMips->inDelaySlot && wasInDelaySlot) {
@@ -996,9 +1095,8 @@ static void RunUntilWithChecks(u64 globalTicks) {
 	bool hasMCs = CBreakPoints::HasMemChecks();
 	while (curMips->downcount >= 0 && coreState == CORE_RUNNING) {
 		do {
-			// Replacements and similar are processed here, intentionally.
-			MIPSOpcode op = MIPSOpcode(Memory::Read_U32(curMips->pc));
-			const MIPSInstruction *instr = MIPSGetInstruction(op);
+			const PredecodedOp &entry = GetPredecodedOp(curMips->pc);
+			MIPSOpcode op = entry.op;
 
 			// Check for breakpoint
 			if (hasBPs && CBreakPoints::IsAddressBreakPoint(curMips->pc) && CBreakPoints::CheckSkipFirst() != curMips->pc) {
@@ -1010,15 +1108,15 @@ static void RunUntilWithChecks(u64 globalTicks) {
 					break;
 				}
 			}
-			if (hasMCs && (instr->flags & (IN_MEM | OUT_MEM)) != 0 && CBreakPoints::CheckSkipFirst() != curMips->pc && instr->interpret != &Int_Syscall) {
+			if (hasMCs && (entry.flags & (IN_MEM | OUT_MEM)) != 0 && CBreakPoints::CheckSkipFirst() != curMips->pc && entry.interpret != &Int_Syscall) {
 				// This is common for all IN_MEM/OUT_MEM funcs.
-				int offset = (instr->flags & IS_VFPU) != 0 ? SignExtend16ToS32(op & 0xFFFC) : SignExtend16ToS32(op);
+				int offset = (entry.flags & IS_VFPU) != 0 ? SignExtend16ToS32(op & 0xFFFC) : SignExtend16ToS32(op);
 				u32 addr = (R(_RS) + offset) & 0xFFFFFFFC;
 				int sz = MIPSGetMemoryAccessSize(op);
 
-				if ((instr->flags & IN_MEM) != 0)
+				if ((entry.flags & IN_MEM) != 0)
 					CBreakPoints::ExecMemCheck(addr, false, sz, curMips->pc, "interpret");
-				if ((instr->flags & OUT_MEM) != 0)
+				if ((entry.flags & OUT_MEM) != 0)
 					CBreakPoints::ExecMemCheck(addr, true, sz, curMips->pc, "interpret");
 
 				// If it tripped, bail without running.
@@ -1027,8 +1125,9 @@ static void RunUntilWithChecks(u64 globalTicks) {
 			}
 
 			bool wasInDelaySlot = curMips->inDelaySlot;
-			Interpret(instr, op);
-			curMips->downcount -= GetInstructionCycleEstimate(instr);
+			int cycles = entry.flags.cycles;
+			InterpretPredecoded(entry);
+			curMips->downcount -= cycles;
 
 			// The reason we have to check this is the delay slot hack in Int_Syscall.
 			if (curMips->inDelaySlot && wasInDelaySlot) {
@@ -22,8 +22,10 @@
 #endif
 #endif
 
+#include <algorithm>
 #include <cstring>
 #include <ctime>
+#include <string>
 #include <vector>
 
 #include "Common/CommonTypes.h"
@@ -45,21 +47,31 @@ enum class ReplayState {
 // Overall structure of file format:
 //
 // - ReplayFileHeader with basic data about replay (mostly timestamp for sync.)
-// - An indeterminate sequence of events:
-//   - ReplayItemHeader (primary event details)
-//   - Side data of bytes listed in header, if SIDEDATA flag set on action.
+// - An indeterminate sequence of chunks, one per flush:
+//   - ReplayChunkHeader (item count and size, start time.)
+//   - For keyframes, the filename of a savestate taken at the start time.
+//   - An indeterminate sequence of events:
+//     - ReplayItemHeader (primary event details)
+//     - Side data of bytes listed in header, if SIDEDATA flag set on action.
 //
-// The header doesn't say how long the replay is, because new events are
-// appended to the file as they occur.  It is usually near, and always less than:
+// The header doesn't say how long the replay is, because new chunks are
+// appended to the file as they occur.  The chunk headers are scanned on load
+// to form an index, so playback only needs one chunk in memory at a time, and
+// can seek to any keyframe.
 //
-// (fileSize - sizeof(ReplayFileHeader)) / sizeof(ReplayItemHeader)
+// Version 1 files have no chunks, just a single sequence of events.
 
 // File data formats below.
 #pragma pack(push, 1)
 
 static const char *REPLAY_MAGIC = "PPREPLAY";
+static const char *REPLAY_CHUNK_MAGIC = "RPCK";
 static const int REPLAY_VERSION_MIN = 1;
-static const int REPLAY_VERSION_CURRENT = 1;
+static const int REPLAY_VERSION_CHUNKED = 2;
+static const int REPLAY_VERSION_CURRENT = 2;
+
+// Once saving to a file, flush automatically when this much is buffered.
+static const size_t REPLAY_CHUNK_MAX_BYTES = 1024 * 1024;
 
 struct ReplayFileHeader {
 	char magic[8];
@@ -68,6 +80,23 @@ struct ReplayFileHeader {
 	u64_le rtcBaseSeconds;
 };
 
+enum ReplayChunkFlags {
+	CHUNK_KEYFRAME = 1 << 0,
+	CHUNK_SAW_GAME_DIR_WRITE = 1 << 1,
+};
+
+struct ReplayChunkHeader {
+	char magic[4];
+	u32_le flags = 0;
+	u32_le itemCount = 0;
+	u32_le dataSize = 0;
+	u64_le startTimestamp = 0;
+	// Ctrl state as of the end of the chunk, needed to begin playback at a keyframe.
+	u32_le buttons = 0;
+	uint8_t analog[2][2]{};
+	u32_le stateFilenameSize = 0;
+};
+
 struct ReplayItemHeader {
 	ReplayAction action;
 	u64_le timestamp;
@@ -122,6 +151,27 @@ struct ReplayItem {
 	}
 };
 
+// Index entry for a chunk of a streamed replay file.
+struct ReplayChunkInfo {
+	int64_t offset;
+	size_t firstItem;
+	uint32_t itemCount;
+	uint32_t dataSize;
+	uint32_t flags;
+	uint64_t startTimestamp;
+	uint32_t buttons;
+	uint8_t analog[2][2];
+	Path stateFilename;
+};
+
+// Position in the replay.  When streaming from a file, each cursor holds only its current chunk.
+struct ReplayCursor {
+	size_t pos = 0;
+	size_t nextChunk = 0;
+	size_t base = 0;
+	std::vector<ReplayItem> items;
+};
+
 static std::vector<ReplayItem> replayItems;
 // One more than the last executed item.
 static size_t replayExecPos = 0;
@@ -129,31 +179,29 @@ static bool replaySaveWroteHeader = false;
 static ReplayState replayState = ReplayState::IDLE;
 static bool replaySawGameDirWrite = false;
 
-static size_t replayCtrlPos = 0;
+// Only while streaming a chunked replay file, otherwise items are in replayItems.
+static FILE *replayFile = nullptr;
+static std::vector<ReplayChunkInfo> replayChunks;
+static size_t replayFileItemCount = 0;
+
+// Once a file has been flushed to, further flushes happen automatically.
+static Path replaySaveFilename;
+static size_t replaySaveBufferedBytes = 0;
+
+static ReplayCursor replayCtrlCursor;
 static uint32_t lastButtons = 0;
 static uint8_t lastAnalog[2][2]{};
 
-static size_t replayDiskPos = 0;
+static ReplayCursor replayDiskCursor;
 static bool diskFailed = false;
 
-bool ReplayExecuteBlob(int version, const std::vector<uint8_t> &data) {
-	if (version < REPLAY_VERSION_MIN || version > REPLAY_VERSION_CURRENT) {
-		ERROR_LOG(SYSTEM, "Bad replay data version: %d", version);
-		return false;
-	}
-	if (data.size() == 0) {
-		ERROR_LOG(SYSTEM, "Empty replay data");
-		return false;
-	}
-
-	ReplayAbort();
-
+static bool ReplayParseItems(const uint8_t *data, size_t sz, std::vector<ReplayItem> *items) {
 	// Rough estimate.
-	replayItems.reserve(data.size() / sizeof(ReplayItemHeader));
-	for (size_t i = 0, sz = data.size(); i < sz; ) {
+	items->reserve(items->size() + sz / sizeof(ReplayItemHeader));
+	for (size_t i = 0; i < sz; ) {
 		if (i + sizeof(ReplayItemHeader) > sz) {
 			ERROR_LOG(SYSTEM, "Truncated replay data at %lld during item header", (long long)i);
-			break;
+			return false;
 		}
 		ReplayItemHeader *info = (ReplayItemHeader *)&data[i];
 		ReplayItem item(*info);
@@ -162,7 +210,7 @@ bool ReplayExecuteBlob(int version, const std::vector<uint8_t> &data) {
 		if ((int)item.info.action & (int)ReplayAction::MASK_SIDEDATA) {
 			if (i + item.info.size > sz) {
 				ERROR_LOG(SYSTEM, "Truncated replay data at %lld during side data", (long long)i);
-				break;
+				return false;
 			}
 			if (item.info.size != 0) {
 				item.data.resize(item.info.size);
@@ -171,14 +219,136 @@ bool ReplayExecuteBlob(int version, const std::vector<uint8_t> &data) {
 			}
 		}
 
-		replayItems.push_back(item);
+		items->push_back(item);
 	}
 
+	return true;
+}
+
+static size_t ReplayItemCount() {
+	return replayFile ? replayFileItemCount : replayItems.size();
+}
+
+static bool ReplayLoadChunk(const ReplayChunkInfo &chunk, std::vector<ReplayItem> *items) {
+	items->clear();
+	if (chunk.dataSize == 0) {
+		return true;
+	}
+
+	std::vector<uint8_t> data;
+	data.resize(chunk.dataSize);
+	if (fseeko(replayFile, chunk.offset, SEEK_SET) != 0 || fread(&data[0], chunk.dataSize, 1, replayFile) != 1) {
+		ERROR_LOG(SYSTEM, "Could not read replay chunk at %lld", (long long)chunk.offset);
+		return false;
+	}
+
+	ReplayParseItems(&data[0], data.size(), items);
+	if (items->size() != chunk.itemCount) {
+		ERROR_LOG(SYSTEM, "Replay chunk at %lld has %d items, expected %d", (long long)chunk.offset, (int)items->size(), chunk.itemCount);
+		items->resize(std::min((size_t)chunk.itemCount, items->size()), ReplayItem(ReplayItemHeader(ReplayAction::BUTTONS, 0)));
+		return false;
+	}
+	return true;
+}
+
+// Returns the item at the cursor, streaming in the next chunk if necessary.  Null at the end.
+static const ReplayItem *ReplayItemAt(ReplayCursor &cursor) {
+	if (!replayFile) {
+		return cursor.pos < replayItems.size() ? &replayItems[cursor.pos] : nullptr;
+	}
+
+	while (cursor.pos >= cursor.base + cursor.items.size()) {
+		if (cursor.nextChunk >= replayChunks.size()) {
+			return nullptr;
+		}
+		size_t index = cursor.nextChunk++;
+		bool loaded = ReplayLoadChunk(replayChunks[index], &cursor.items);
+		cursor.base = replayChunks[index].firstItem;
+		if (!loaded) {
+			// Don't continue past corrupt data, and only count the items we could decode.
+			replayChunks[index].itemCount = (uint32_t)cursor.items.size();
+			replayChunks.resize(index + 1);
+			replayFileItemCount = cursor.base + cursor.items.size();
+			replayCtrlCursor.nextChunk = std::min(replayCtrlCursor.nextChunk, replayChunks.size());
+			replayDiskCursor.nextChunk = std::min(replayDiskCursor.nextChunk, replayChunks.size());
+		}
+	}
+
+	return &cursor.items[cursor.pos - cursor.base];
+}
+
+bool ReplayExecuteBlob(int version, const std::vector<uint8_t> &data) {
+	if (version < REPLAY_VERSION_MIN || version > REPLAY_VERSION_CURRENT) {
+		ERROR_LOG(SYSTEM, "Bad replay data version: %d", version);
+		return false;
+	}
+	if (data.size() == 0) {
+		ERROR_LOG(SYSTEM, "Empty replay data");
+		return false;
+	}
+
+	ReplayAbort();
+
+	// Item data is the same in all versions.
+	ReplayParseItems(&data[0], data.size(), &replayItems);
+
 	replayState = ReplayState::EXECUTE;
 	INFO_LOG(SYSTEM, "Executing replay with %lld items", (long long)replayItems.size());
 	return true;
 }
 
+static bool ReplayScanChunks(FILE *fp) {
+	replayChunks.clear();
+	replayFileItemCount = 0;
+
+	int64_t fileSize = (int64_t)File::GetFileSize(fp);
+	int64_t pos = (int64_t)sizeof(ReplayFileHeader);
+	while (pos + (int64_t)sizeof(ReplayChunkHeader) <= fileSize) {
+		ReplayChunkHeader ch;
+		if (fseeko(fp, pos, SEEK_SET) != 0 || fread(&ch, sizeof(ch), 1, fp) != 1) {
+			ERROR_LOG(SYSTEM, "Could not read replay chunk header at %lld", (long long)pos);
+			break;
+		}
+		if (memcmp(ch.magic, REPLAY_CHUNK_MAGIC, sizeof(ch.magic)) != 0) {
+			ERROR_LOG(SYSTEM, "Replay chunk header corrupt at %lld", (long long)pos);
+			break;
+		}
+		pos += sizeof(ch);
+
+		ReplayChunkInfo chunk;
+		if (ch.stateFilenameSize != 0) {
+			std::string stateFilename;
+			stateFilename.resize(ch.stateFilenameSize);
+			if (ch.stateFilenameSize > fileSize - pos || fread(&stateFilename[0], ch.stateFilenameSize, 1, fp) != 1) {
+				WARN_LOG(SYSTEM, "Truncated replay chunk at %lld", (long long)pos);
+				break;
+			}
+			chunk.stateFilename = Path(stateFilename);
+			pos += ch.stateFilenameSize;
+		}
+		if (ch.dataSize > fileSize - pos) {
+			// Probably crashed during a flush.  Play what we have.
+			WARN_LOG(SYSTEM, "Truncated replay chunk at %lld", (long long)pos);
+			break;
+		}
+
+		chunk.offset = pos;
+		chunk.firstItem = replayFileItemCount;
+		chunk.itemCount = ch.itemCount;
+		chunk.dataSize = ch.dataSize;
+		chunk.flags = ch.flags;
+		chunk.startTimestamp = ch.startTimestamp;
+		chunk.buttons = ch.buttons;
+		memcpy(chunk.analog, ch.analog, sizeof(chunk.analog));
+		replayChunks.push_back(chunk);
+
+		replayFileItemCount += ch.itemCount;
+		pos += ch.dataSize;
+	}
+
+	return !replayChunks.empty();
+}
+
 bool ReplayExecuteFile(const Path &filename) {
 	ReplayAbort();
 
@@ -191,7 +361,6 @@ bool ReplayExecuteFile(const Path &filename) {
 	int version = -1;
 	std::vector<uint8_t> data;
 	auto loadData = [&]() {
-		// TODO: Maybe stream instead.
 		size_t sz = File::GetFileSize(fp);
 		if (sz <= sizeof(ReplayFileHeader)) {
 			ERROR_LOG(SYSTEM, "Empty replay data");
@@ -220,6 +389,11 @@ bool ReplayExecuteFile(const Path &filename) {
 		RtcSetBaseTime((int32_t)fh.rtcBaseSeconds, 0);
 		version = fh.version;
 
+		if (version >= REPLAY_VERSION_CHUNKED) {
+			// Stream these, we only need the index now.
+			return ReplayScanChunks(fp);
+		}
+
 		data.resize(sz);
 
 		if (fread(&data[0], sz, 1, fp) != 1) {
@@ -230,24 +404,101 @@ bool ReplayExecuteFile(const Path &filename) {
 		return true;
 	};
 
-	if (loadData()) {
+	if (!loadData()) {
+		replayChunks.clear();
+		replayFileItemCount = 0;
+		fclose(fp);
+		return false;
+	}
+
+	if (version < REPLAY_VERSION_CHUNKED) {
 		fclose(fp);
 		ReplayExecuteBlob(version, data);
 		return true;
 	}
 
-	fclose(fp);
-	return false;
+	replayFile = fp;
+	replayState = ReplayState::EXECUTE;
+	INFO_LOG(SYSTEM, "Executing replay with %lld items in %lld chunks", (long long)replayFileItemCount, (long long)replayChunks.size());
+	return true;
+}
+
+bool ReplaySeek(uint64_t t, Path *keyframeState) {
+	if (keyframeState) {
+		*keyframeState = Path();
+	}
+	if (replayState != ReplayState::EXECUTE || !replayFile) {
+		WARN_LOG(SYSTEM, "Can only seek while executing a replay file");
+		return false;
+	}
+
+	// Start from the latest keyframe at or before the requested time.
+	size_t startChunk = 0;
+	for (size_t i = 0; i < replayChunks.size(); ++i) {
+		if (replayChunks[i].startTimestamp > t)
+			break;
+		if (replayChunks[i].flags & CHUNK_KEYFRAME)
+			startChunk = i;
+	}
+
+	const ReplayChunkInfo &start = replayChunks[startChunk];
+	if (start.flags & CHUNK_KEYFRAME) {
+		lastButtons = start.buttons;
+		memcpy(lastAnalog, start.analog, sizeof(lastAnalog));
+		replaySawGameDirWrite = (start.flags & CHUNK_SAW_GAME_DIR_WRITE) != 0;
+		if (keyframeState) {
+			*keyframeState = start.stateFilename;
+		}
+	} else {
+		lastButtons = 0;
+		memset(lastAnalog, 0, sizeof(lastAnalog));
+		replaySawGameDirWrite = false;
+	}
+
+	for (ReplayCursor *cursor : { &replayCtrlCursor, &replayDiskCursor }) {
+		cursor->pos = start.firstItem;
+		cursor->base = start.firstItem;
+		cursor->nextChunk = startChunk;
+		cursor->items.clear();
+	}
+	replayExecPos = start.firstItem;
+	diskFailed = false;
+
+	INFO_LOG(SYSTEM, "Seeked replay to chunk %lld", (long long)startChunk);
+	return true;
 }
 
 bool ReplayHasMoreEvents() {
-	return replayExecPos < replayItems.size();
+	return replayExecPos < ReplayItemCount();
 }
 
-void ReplayBeginSave() {
+bool ReplayBeginSave() {
 	if (replayState != ReplayState::EXECUTE) {
 		// Restart any save operation.
 		ReplayAbort();
+	} else if (replayFile) {
+		// Keep the executed items, like below, but they have to be read back in first.
+		std::vector<ReplayItem> executed;
+		for (const ReplayChunkInfo &chunk : replayChunks) {
+			if (chunk.firstItem >= replayExecPos)
+				break;
+			std::vector<ReplayItem> items;
+			if (!ReplayLoadChunk(chunk, &items)) {
+				ERROR_LOG(SYSTEM, "Could not read back executed replay items to save");
+				return false;
+			}
+			executed.insert(executed.end(), items.begin(), items.end());
+		}
+		if (executed.size() > replayExecPos)
+			executed.resize(replayExecPos, ReplayItem(ReplayItemHeader(ReplayAction::BUTTONS, 0)));
+		replayItems = std::move(executed);
+
+		fclose(replayFile);
+		replayFile = nullptr;
+		replayChunks.clear();
+		replayFileItemCount = 0;
+		replayCtrlCursor = ReplayCursor();
+		replayDiskCursor = ReplayCursor();
 	} else {
 		// Discard any unexecuted items, but resume from there.
 		// The parameter isn't used here, since we'll always be resizing down.
@@ -255,6 +506,7 @@ void ReplayBeginSave() {
 	}
 
 	replayState = ReplayState::SAVE;
+	return true;
 }
 
 void ReplayFlushBlob(std::vector<uint8_t> *data) {
@@ -281,9 +533,32 @@ void ReplayFlushBlob(std::vector<uint8_t> *data) {
 
 	// Keep recording, but throw away our buffered items.
 	replayItems.clear();
+	replaySaveBufferedBytes = 0;
 }
 
-bool ReplayFlushFile(const Path &filename) {
+static bool ReplayWriteChunk(FILE *fp, uint32_t flags, uint64_t t, const std::string &stateFilename) {
+	ReplayChunkHeader ch;
+	memcpy(ch.magic, REPLAY_CHUNK_MAGIC, sizeof(ch.magic));
+	ch.flags = flags | (replaySawGameDirWrite ? CHUNK_SAW_GAME_DIR_WRITE : 0);
+	ch.itemCount = (uint32_t)replayItems.size();
+	ch.startTimestamp = replayItems.empty() ? t : (uint64_t)replayItems[0].info.timestamp;
+	ch.buttons = lastButtons;
+	memcpy(ch.analog, lastAnalog, sizeof(ch.analog));
+	ch.stateFilenameSize = (uint32_t)stateFilename.size();
+
+	std::vector<uint8_t> data;
+	ReplayFlushBlob(&data);
+	ch.dataSize = (uint32_t)data.size();
+
+	bool success = fwrite(&ch, sizeof(ch), 1, fp) == 1;
+	if (success && !stateFilename.empty())
+		success = fwrite(stateFilename.data(), stateFilename.size(), 1, fp) == 1;
+	if (success && !data.empty())
+		success = fwrite(&data[0], data.size(), 1, fp) == 1;
+	return success;
+}
+
+static bool ReplayFlushFile(const Path &filename, uint32_t flags, uint64_t t, const Path &stateFilename) {
 	FILE *fp = File::OpenCFile(filename, replaySaveWroteHeader ? "ab" : "wb");
 	if (!fp) {
 		ERROR_LOG(SYSTEM, "Failed to open replay file: %s", filename.c_str());
@@ -302,15 +577,16 @@ bool ReplayFlushFile(const Path &filename) {
 
 	size_t c = replayItems.size();
 	if (success && c != 0) {
-		// TODO: Maybe stream instead.
-		std::vector<uint8_t> data;
-		ReplayFlushBlob(&data);
-
-		success = fwrite(&data[0], data.size(), 1, fp) == 1;
+		success = ReplayWriteChunk(fp, 0, t, "");
+	}
+	// Keyframes get their own empty chunk, so playback can seek right there.
+	if (success && (flags & CHUNK_KEYFRAME) != 0) {
+		success = ReplayWriteChunk(fp, CHUNK_KEYFRAME, t, stateFilename.ToString());
 	}
 	fclose(fp);
 
 	if (success) {
+		replaySaveFilename = filename;
 		DEBUG_LOG(SYSTEM, "Flushed %lld replay items", (long long)c);
 	} else {
 		ERROR_LOG(SYSTEM, "Could not write %lld replay items (disk full?)", (long long)c);
@@ -318,6 +594,14 @@ bool ReplayFlushFile(const Path &filename) {
 	return success;
 }
 
+bool ReplayFlushFile(const Path &filename) {
+	return ReplayFlushFile(filename, 0, 0, Path());
+}
+
+bool ReplayFlushFileKeyframe(const Path &filename, const Path &stateFilename, uint64_t t) {
+	return ReplayFlushFile(filename, CHUNK_KEYFRAME, t, stateFilename);
+}
+
 int ReplayVersion() {
 	return REPLAY_VERSION_CURRENT;
 }
@@ -329,11 +613,20 @@ void ReplayAbort() {
 	replayState = ReplayState::IDLE;
 	replaySawGameDirWrite = false;
 
-	replayCtrlPos = 0;
+	if (replayFile)
+		fclose(replayFile);
+	replayFile = nullptr;
+	replayChunks.clear();
+	replayFileItemCount = 0;
+
+	replaySaveFilename.clear();
+	replaySaveBufferedBytes = 0;
+
+	replayCtrlCursor = ReplayCursor();
 	lastButtons = 0;
 	memset(lastAnalog, 0, sizeof(lastAnalog));
 
-	replayDiskPos = 0;
+	replayDiskCursor = ReplayCursor();
 	diskFailed = false;
 }
 
@@ -345,46 +638,57 @@ bool ReplayIsSaving() {
 	return replayState == ReplayState::SAVE;
 }
 
+static void ReplaySaveItem(const ReplayItem &item) {
+	replayItems.push_back(item);
+	replaySaveBufferedBytes += sizeof(ReplayItemHeader) + item.data.size();
+
+	// Keep memory use flat for long recordings, once we know where they go.
+	if (!replaySaveFilename.empty() && replaySaveBufferedBytes >= REPLAY_CHUNK_MAX_BYTES) {
+		ReplayFlushFile(replaySaveFilename);
+	}
+}
+
 static void ReplaySaveCtrl(uint32_t &buttons, uint8_t analog[2][2], uint64_t t) {
 	if (lastButtons != buttons) {
-		replayItems.push_back(ReplayItemHeader(ReplayAction::BUTTONS, t, buttons));
+		ReplaySaveItem(ReplayItemHeader(ReplayAction::BUTTONS, t, buttons));
 		lastButtons = buttons;
 	}
 	if (memcmp(lastAnalog, analog, sizeof(lastAnalog)) != 0) {
-		replayItems.push_back(ReplayItemHeader(ReplayAction::ANALOG, t, analog));
+		ReplaySaveItem(ReplayItemHeader(ReplayAction::ANALOG, t, analog));
 		memcpy(lastAnalog, analog, sizeof(lastAnalog));
 	}
 }
 
 static void ReplayExecuteCtrl(uint32_t &buttons, uint8_t analog[2][2], uint64_t t) {
-	if (replayCtrlPos >= replayItems.size()) {
+	const ReplayItem *item = ReplayItemAt(replayCtrlCursor);
+	if (!item) {
 		// Don't assert buttons, let the user input prevail.
 		return;
 	}
 
-	for (; replayCtrlPos < replayItems.size() && t >= replayItems[replayCtrlPos].info.timestamp; ++replayCtrlPos) {
-		const auto &item = replayItems[replayCtrlPos];
-		switch (item.info.action) {
+	for (; item && t >= item->info.timestamp; item = ReplayItemAt(replayCtrlCursor)) {
+		switch (item->info.action) {
 		case ReplayAction::BUTTONS:
-			lastButtons = item.info.buttons;
+			lastButtons = item->info.buttons;
 			break;
 
 		case ReplayAction::ANALOG:
-			memcpy(lastAnalog, item.info.analog, sizeof(lastAnalog));
+			memcpy(lastAnalog, item->info.analog, sizeof(lastAnalog));
 			break;
 
 		default:
 			// Ignore non ctrl types.
 			break;
 		}
+		++replayCtrlCursor.pos;
 	}
 
 	// We have to always apply the latest state here, because otherwise real input is used between changes.
 	buttons = lastButtons;
 	memcpy(analog, lastAnalog, sizeof(lastAnalog));
 
-	if (replayExecPos < replayCtrlPos) {
-		replayExecPos = replayCtrlPos;
+	if (replayExecPos < replayCtrlCursor.pos) {
+		replayExecPos = replayCtrlCursor.pos;
 	}
 }
 
@@ -406,10 +710,10 @@ void ReplayApplyCtrl(uint32_t &buttons, uint8_t analog[2][2], uint64_t t) {
 
 static const ReplayItem *ReplayNextDisk(uint64_t t) {
 	// TODO: Currently not checking t for timing purposes.  Should still be same order anyway.
-	while (replayDiskPos < replayItems.size()) {
-		const auto &item = replayItems[replayDiskPos++];
-		if ((int)item.info.action & (int)ReplayAction::MASK_FILE) {
-			return &item;
+	while (const ReplayItem *item = ReplayItemAt(replayDiskCursor)) {
+		++replayDiskCursor.pos;
+		if ((int)item->info.action & (int)ReplayAction::MASK_FILE) {
+			return item;
 		}
 	}
 
@@ -429,8 +733,8 @@ static const ReplayItem *ReplayNextDisk(ReplayAction action, uint64_t t) {
 		return nullptr;
 	}
 
-	if (replayExecPos < replayDiskPos) {
-		replayExecPos = replayDiskPos;
+	if (replayExecPos < replayDiskCursor.pos) {
+		replayExecPos = replayDiskCursor.pos;
 	}
 
 	return item;
@@ -447,7 +751,7 @@ uint32_t ReplayApplyDisk(ReplayAction action, uint32_t result, uint64_t t) {
 	}
 
 	case ReplayState::SAVE:
-		replayItems.push_back(ReplayItemHeader(action, t, result));
+		ReplaySaveItem(ReplayItemHeader(action, t, result));
 		return result;
 
 	case ReplayState::IDLE:
@@ -467,7 +771,7 @@ uint64_t ReplayApplyDisk64(ReplayAction action, uint64_t result, uint64_t t) {
 	}
 
 	case ReplayState::SAVE:
-		replayItems.push_back(ReplayItemHeader(action, t, result));
+		ReplaySaveItem(ReplayItemHeader(action, t, result));
 		return result;
 
 	case ReplayState::IDLE:
@@ -498,7 +802,7 @@ uint32_t ReplayApplyDiskRead(void *data, uint32_t readSize, uint32_t dataSize, b
 		ReplayItem item = ReplayItemHeader(ReplayAction::FILE_READ, t, readSize);
 		item.data.resize(readSize);
 		memcpy(&item.data[0], data, readSize);
-		replayItems.push_back(item);
+		ReplaySaveItem(item);
 		return readSize;
 	}
 
@@ -588,7 +892,7 @@ PSPFileInfo ReplayApplyDiskFileInfo(const PSPFileInfo &data, uint64_t t) {
 		ReplayItem item = ReplayItemHeader(ReplayAction::FILE_INFO, t, (uint32_t)sizeof(info));
 		item.data.resize(sizeof(info));
 		memcpy(&item.data[0], &info, sizeof(info));
-		replayItems.push_back(item);
+		ReplaySaveItem(item);
 		return data;
 	}
 
@@ -625,7 +929,7 @@ std::vector<PSPFileInfo> ReplayApplyDiskListing(const std::vector<PSPFileInfo> &
 			ReplayFileInfo info = ConvertFileInfo(data[i]);
 			memcpy(&item.data[i * sizeof(ReplayFileInfo)], &info, sizeof(info));
 		}
-		replayItems.push_back(item);
+		ReplaySaveItem(item);
 		return data;
 	}
 
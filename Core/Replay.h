@@ -49,19 +49,28 @@ struct PSPFileInfo;
 
 // Replay from data in memory.  Does not manipulate base time / RNG state.
 bool ReplayExecuteBlob(int version, const std::vector<uint8_t> &data);
-// Replay from data in a file.  Returns false if invalid.
+// Replay from data in a file, streaming it in as it executes.  Returns false if invalid.
 bool ReplayExecuteFile(const Path &filename);
+// Move playback of a replay file back or forward to the latest keyframe at or before t, or the
+// beginning if none.  The caller should load the savestate written to keyframeState (empty when
+// starting from the beginning.)  Returns false if not executing a replay file.
+bool ReplaySeek(uint64_t t, Path *keyframeState);
 // Returns whether there are unexecuted events to replay.
 bool ReplayHasMoreEvents();
 
 // Begin recording.  If currently executing, discards unexecuted events.
-void ReplayBeginSave();
+// Returns false, without changing anything, if executed events could not be read back.
+bool ReplayBeginSave();
 // Flush buffered events to memory.  Continues recording (next call will receive new events only.)
 // No header is flushed with this operation - don't mix with ReplayFlushFile().
 void ReplayFlushBlob(std::vector<uint8_t> *data);
 // Flush buffered events to file.  Continues recording (next call will receive new events only.)
 // Do not call with a different filename before ReplayAbort().
+// After the first call, events are also flushed automatically as they accumulate.
 bool ReplayFlushFile(const Path &filename);
+// Flush, then mark a keyframe at time t, which playback can seek to.
+// The caller is responsible for saving the state to stateFilename at that time.
+bool ReplayFlushFileKeyframe(const Path &filename, const Path &stateFilename, uint64_t t);
 // Get current replay data version.
 int ReplayVersion();
 
@@ -46,6 +46,7 @@
 #include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/MIPSAnalyst.h"
 #include "Core/MIPS/MIPSVFPUUtils.h"
+#include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/Debugger/SymbolMap.h"
 #include "Core/Host.h"
 #include "Core/System.h"
@@ -70,6 +71,7 @@
 #include "Core/HLE/sceAudiocodec.h"
 #include "GPU/GPUState.h"
 #include "GPU/GPUInterface.h"
+#include "GPU/Debugger/Playback.h"
 #include "GPU/Debugger/RecordFormat.h"
 
 enum CPUThreadState {
@@ -396,6 +398,8 @@ void Core_UpdateDebugStats(bool collectStats) {
 	if (!PSP_CoreParameter().frozen && !Core_IsStepping()) {
 		kernelStats.ResetFrame();
 		gpuStats.ResetFrame();
+		MIPSComp::compileStats = {};
+		GPURecord::ResetReplayStats();
 	}
 }
 
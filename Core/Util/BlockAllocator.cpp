@@ -17,6 +17,7 @@
 
 #include <cstring>
 
+#include "Common/BitScan.h"
 #include "Common/Log.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
@@ -25,7 +26,13 @@
 #include "Core/Util/BlockAllocator.h"
 #include "Core/Reporting.h"
 
-// Slow freaking thing but works (eventually) :)
+// The blocks form an address ordered linked list, which is what gets saved.  On top of that,
+// blocks are indexed by start address and free blocks by size class, so that lookups and
+// first fit allocation don't need to walk the whole list.
+
+static inline int SizeClass(u32 size) {
+	return 31 - (int)clz32_nonzero(size);
+}
 
 BlockAllocator::BlockAllocator(int grain) : bottom_(NULL), top_(NULL), grain_(grain)
 {
@@ -43,6 +50,7 @@ void BlockAllocator::Init(u32 rangeStart, u32 rangeSize, bool suballoc) {
 	//Initial block, covering everything
 	top_ = new Block(rangeStart_, rangeSize_, false, NULL, NULL);
 	bottom_ = top_;
+	IndexBlock(top_);
 	suballoc_ = suballoc;
 }
 
@@ -55,6 +63,130 @@ void BlockAllocator::Shutdown()
 		bottom_ = next;
 	}
 	top_ = NULL;
+
+	blocksByStart_.clear();
+	for (auto &freeList : freeBySize_)
+		freeList.clear();
+	freeBytes_ = 0;
+}
+
+void BlockAllocator::IndexBlock(Block *b)
+{
+	if (b->size == 0)
+		return;
+	blocksByStart_[b->start] = b;
+	if (!b->taken)
+	{
+		freeBySize_[SizeClass(b->size)][b->start] = b;
+		freeBytes_ += b->size;
+	}
+}
+
+void BlockAllocator::UnindexBlock(Block *b)
+{
+	if (b->size == 0)
+		return;
+	// Only remove the entries if they're really for this block, it may not have been indexed yet.
+	auto it = blocksByStart_.find(b->start);
+	if (it != blocksByStart_.end() && it->second == b)
+		blocksByStart_.erase(it);
+	if (!b->taken)
+	{
+		auto &freeList = freeBySize_[SizeClass(b->size)];
+		auto freeIt = freeList.find(b->start);
+		if (freeIt != freeList.end() && freeIt->second == b)
+		{
+			freeList.erase(freeIt);
+			freeBytes_ -= b->size;
+		}
+	}
+}
+
+void BlockAllocator::MarkTaken(Block *b)
+{
+	UnindexBlock(b);
+	b->taken = true;
+	IndexBlock(b);
+}
+
+static inline u32 AlignOffset(u32 start, u32 size, u32 blockSize, u32 grain, bool fromTop)
+{
+	if (fromTop)
+		return (start + blockSize - size) % grain;
+	u32 offset = start % grain;
+	if (offset != 0)
+		offset = grain - offset;
+	return offset;
+}
+
+// Finds the same block a first fit walk of the list would: the lowest (or highest, from the top)
+// free block that still fits the size once aligned.
+BlockAllocator::Block *BlockAllocator::FindFreeBlock(u32 size, u32 grain, bool fromTop) const
+{
+	// Anything this large fits wherever it starts.
+	u64 alwaysFits = (u64)size + grain - 1;
+	// If the needed size could wrap around, only the plain walk matches the old results.
+	if (size == 0 || alwaysFits > 0xFFFFFFFFULL)
+		return FindFreeBlockSlow(size, grain, fromTop);
+
+	Block *best = NULL;
+	for (int sizeClass = SizeClass(size); sizeClass < 32; ++sizeClass)
+	{
+		const auto &freeList = freeBySize_[sizeClass];
+		if (freeList.empty())
+			continue;
+
+		if (((u64)1 << sizeClass) >= alwaysFits)
+		{
+			// Everything in this class fits, so only its lowest or highest block can win.
+			Block *candidate = fromTop ? freeList.rbegin()->second : freeList.begin()->second;
+			if (best == NULL || (fromTop ? candidate->start > best->start : candidate->start < best->start))
+				best = candidate;
+			continue;
+		}
+
+		// Size and alignment decide, walk in address order until something better than best fits.
+		if (fromTop)
+		{
+			for (auto it = freeList.rbegin(); it != freeList.rend(); ++it)
+			{
+				const Block &b = *it->second;
+				if (best != NULL && b.start < best->start)
+					break;
+				if (b.size >= AlignOffset(b.start, size, b.size, grain, true) + size)
+				{
+					best = it->second;
+					break;
+				}
+			}
+		}
+		else
+		{
+			for (auto it = freeList.begin(); it != freeList.end(); ++it)
+			{
+				const Block &b = *it->second;
+				if (best != NULL && b.start > best->start)
+					break;
+				if (b.size >= AlignOffset(b.start, size, b.size, grain, false) + size)
+				{
+					best = it->second;
+					break;
+				}
+			}
+		}
+	}
+	return best;
+}
+
+BlockAllocator::Block *BlockAllocator::FindFreeBlockSlow(u32 size, u32 grain, bool fromTop) const
+{
+	for (Block *bp = fromTop ? top_ : bottom_; bp != NULL; bp = fromTop ? bp->prev : bp->next)
+	{
+		const Block &b = *bp;
+		if (b.taken == false && b.size >= AlignOffset(b.start, size, b.size, grain, fromTop) + size)
+			return bp;
+	}
+	return NULL;
 }
 
 u32 BlockAllocator::AllocAligned(u32 &size, u32 sizeGrain, u32 grain, bool fromTop, const char *tag)
@@ -74,67 +206,31 @@ u32 BlockAllocator::AllocAligned(u32 &size, u32 sizeGrain, u32 grain, bool fromT
 	// upalign size to grain
 	size = (size + sizeGrain - 1) & ~(sizeGrain - 1);
 
-	if (!fromTop)
+	Block *bp = FindFreeBlock(size, grain, fromTop);
+	if (bp != NULL)
 	{
-		//Allocate from bottom of mem
-		for (Block *bp = bottom_; bp != NULL; bp = bp->next)
+		Block &b = *bp;
+		u32 offset = AlignOffset(b.start, size, b.size, grain, fromTop);
+		u32 needed = offset + size;
+		if (!fromTop)
 		{
-			Block &b = *bp;
-			u32 offset = b.start % grain;
-			if (offset != 0)
-				offset = grain - offset;
-			u32 needed = offset + size;
-			if (b.taken == false && b.size >= needed)
-			{
-				if (b.size == needed)
-				{
-					if (offset >= grain_)
-						InsertFreeBefore(&b, offset);
-					b.taken = true;
-					b.SetAllocated(tag, suballoc_);
-					return b.start;
-				}
-				else
-				{
-					InsertFreeAfter(&b, b.size - needed);
-					if (offset >= grain_)
-						InsertFreeBefore(&b, offset);
-					b.taken = true;
-					b.SetAllocated(tag, suballoc_);
-					return b.start;
-				}
-			}
+			//Allocate from bottom of mem
+			if (b.size != needed)
+				InsertFreeAfter(&b, b.size - needed);
+			if (offset >= grain_)
+				InsertFreeBefore(&b, offset);
 		}
-	}
-	else
-	{
-		// Allocate from top of mem.
-		for (Block *bp = top_; bp != NULL; bp = bp->prev)
+		else
 		{
-			Block &b = *bp;
-			u32 offset = (b.start + b.size - size) % grain;
-			u32 needed = offset + size;
-			if (b.taken == false && b.size >= needed)
-			{
-				if (b.size == needed)
-				{
-					if (offset >= grain_)
-						InsertFreeAfter(&b, offset);
-					b.taken = true;
-					b.SetAllocated(tag, suballoc_);
-					return b.start;
-				}
-				else
-				{
-					InsertFreeBefore(&b, b.size - needed);
-					if (offset >= grain_)
-						InsertFreeAfter(&b, offset);
-					b.taken = true;
-					b.SetAllocated(tag, suballoc_);
-					return b.start;
-				}
-			}
+			// Allocate from top of mem.
+			if (b.size != needed)
+				InsertFreeBefore(&b, b.size - needed);
+			if (offset >= grain_)
+				InsertFreeAfter(&b, offset);
 		}
+		MarkTaken(&b);
+		b.SetAllocated(tag, suballoc_);
+		return b.start;
 	}
 
 	//Out of memory :(
@@ -195,7 +291,7 @@ u32 BlockAllocator::AllocAt(u32 position, u32 size, const char *tag)
 			{
 				if (b.size != alignedSize)
 					InsertFreeAfter(&b, b.size - alignedSize);
-				b.taken = true;
+				MarkTaken(&b);
 				b.SetAllocated(tag, suballoc_);
 				CheckBlocks();
 				return position;
@@ -205,7 +301,7 @@ u32 BlockAllocator::AllocAt(u32 position, u32 size, const char *tag)
 				InsertFreeBefore(&b, alignedPosition - b.start);
 				if (b.size > alignedSize)
 					InsertFreeAfter(&b, b.size - alignedSize);
-				b.taken = true;
+				MarkTaken(&b);
 				b.SetAllocated(tag, suballoc_);
 
 				return position;
@@ -228,10 +324,12 @@ void BlockAllocator::MergeFreeBlocks(Block *fromBlock)
 {
 	DEBUG_LOG(SCEKERNEL, "Merging Blocks");
 
+	UnindexBlock(fromBlock);
 	Block *prev = fromBlock->prev;
 	while (prev != NULL && prev->taken == false)
 	{
 		DEBUG_LOG(SCEKERNEL, "Block Alloc found adjacent free blocks - merging");
+		UnindexBlock(prev);
 		prev->size += fromBlock->size;
 		if (fromBlock->next == NULL)
 			top_ = prev;
@@ -252,6 +350,7 @@ void BlockAllocator::MergeFreeBlocks(Block *fromBlock)
 	while (next != NULL && next->taken == false)
 	{
 		DEBUG_LOG(SCEKERNEL, "Block Alloc found adjacent free blocks - merging");
+		UnindexBlock(next);
 		fromBlock->size += next->size;
 		fromBlock->next = next->next;
 		delete next;
@@ -262,6 +361,8 @@ void BlockAllocator::MergeFreeBlocks(Block *fromBlock)
 		top_ = fromBlock;
 	else
 		next->prev = fromBlock;
+
+	IndexBlock(fromBlock);
 }
 
 bool BlockAllocator::Free(u32 position)
@@ -300,6 +401,7 @@ bool BlockAllocator::FreeExact(u32 position)
 
 BlockAllocator::Block *BlockAllocator::InsertFreeBefore(Block *b, u32 size)
 {
+	UnindexBlock(b);
 	Block *inserted = new Block(b->start, size, false, b->prev, b);
 	b->prev = inserted;
 	if (inserted->prev == NULL)
@@ -309,11 +411,14 @@ BlockAllocator::Block *BlockAllocator::InsertFreeBefore(Block *b, u32 size)
 
 	b->start += size;
 	b->size -= size;
+	IndexBlock(inserted);
+	IndexBlock(b);
 	return inserted;
 }
 
 BlockAllocator::Block *BlockAllocator::InsertFreeAfter(Block *b, u32 size)
 {
+	UnindexBlock(b);
 	Block *inserted = new Block(b->start + b->size - size, size, false, b, b->next);
 	b->next = inserted;
 	if (inserted->next == NULL)
@@ -322,6 +427,8 @@ BlockAllocator::Block *BlockAllocator::InsertFreeAfter(Block *b, u32 size)
 		inserted->next->prev = inserted;
 
 	b->size -= size;
+	IndexBlock(inserted);
+	IndexBlock(b);
 	return inserted;
 }
 
@@ -345,30 +452,23 @@ const char *BlockAllocator::GetBlockTag(u32 addr) const {
 	return b->tag;
 }
 
-inline BlockAllocator::Block *BlockAllocator::GetBlockFromAddress(u32 addr)
+BlockAllocator::Block *BlockAllocator::GetBlockFromAddress(u32 addr)
 {
-	for (Block *bp = bottom_; bp != NULL; bp = bp->next)
-	{
-		Block &b = *bp;
-		if (b.start <= addr && b.start + b.size > addr)
-		{
-			// Got one!
-			return bp;
-		}
-	}
-	return NULL;
+	const BlockAllocator *self = this;
+	return const_cast<Block *>(self->GetBlockFromAddress(addr));
 }
 
 const BlockAllocator::Block *BlockAllocator::GetBlockFromAddress(u32 addr) const
 {
-	for (const Block *bp = bottom_; bp != NULL; bp = bp->next)
+	auto it = blocksByStart_.upper_bound(addr);
+	if (it == blocksByStart_.begin())
+		return NULL;
+	--it;
+	const Block &b = *it->second;
+	if (b.start <= addr && b.start + b.size > addr)
 	{
-		const Block &b = *bp;
-		if (b.start <= addr && b.start + b.size > addr)
-		{
-			// Got one!
-			return bp;
-		}
+		// Got one!
+		return it->second;
 	}
 	return NULL;
 }
@@ -405,14 +505,18 @@ void BlockAllocator::ListBlocks() const
 u32 BlockAllocator::GetLargestFreeBlockSize() const
 {
 	u32 maxFreeBlock = 0;
-	for (const Block *bp = bottom_; bp != NULL; bp = bp->next)
+	// Only the largest non-empty size class can have the largest block.
+	for (int sizeClass = 31; sizeClass >= 0; --sizeClass)
 	{
-		const Block &b = *bp;
-		if (!b.taken)
+		const auto &freeList = freeBySize_[sizeClass];
+		if (freeList.empty())
+			continue;
+		for (const auto &it : freeList)
 		{
-			if (b.size > maxFreeBlock)
-				maxFreeBlock = b.size;
+			if (it.second->size > maxFreeBlock)
+				maxFreeBlock = it.second->size;
 		}
+		break;
 	}
 	if (maxFreeBlock & (grain_ - 1))
 		WARN_LOG_REPORT(HLE, "GetLargestFreeBlockSize: free size %08x does not align to grain %08x.", maxFreeBlock, grain_);
@@ -421,15 +525,7 @@ u32 BlockAllocator::GetLargestFreeBlockSize() const
 
 u32 BlockAllocator::GetTotalFreeBytes() const
 {
-	u32 sum = 0;
-	for (const Block *bp = bottom_; bp != NULL; bp = bp->next)
-	{
-		const Block &b = *bp;
-		if (!b.taken)
-		{
-			sum += b.size;
-		}
-	}
+	u32 sum = freeBytes_;
 	if (sum & (grain_ - 1))
 		WARN_LOG_REPORT(HLE, "GetTotalFreeBytes: free size %08x does not align to grain %08x.", sum, grain_);
 	return sum;
@@ -459,6 +555,9 @@ void BlockAllocator::DoState(PointerWrap &p)
 			top_->next->DoState(p);
 			top_ = top_->next;
 		}
+
+		for (Block *bp = bottom_; bp != NULL; bp = bp->next)
+			IndexBlock(bp);
 	}
 	else
 	{
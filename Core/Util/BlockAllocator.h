@@ -17,10 +17,12 @@
 
 #pragma once
 
-class PointerWrap;
+#include <map>
 
 #include "Common/CommonTypes.h"
 
+class PointerWrap;
+
 class BlockAllocator
 {
 public:
@@ -74,12 +76,23 @@ class BlockAllocator
 
 	Block *bottom_;
 	Block *top_;
+	// Blocks by start address, for address lookups.  Zero sized blocks never contain an address, so they're left out.
+	std::map<u32, Block *> blocksByStart_;
+	// Free blocks segregated by floor(log2(size)), each class ordered by address.
+	std::map<u32, Block *> freeBySize_[32];
+	u32 freeBytes_ = 0;
 	u32 rangeStart_;
 	u32 rangeSize_;
 
 	u32 grain_;
 	bool suballoc_;
 
+	void IndexBlock(Block *b);
+	void UnindexBlock(Block *b);
+	void MarkTaken(Block *b);
+	Block *FindFreeBlock(u32 size, u32 grain, bool fromTop) const;
+	Block *FindFreeBlockSlow(u32 size, u32 grain, bool fromTop) const;
+
 	void MergeFreeBlocks(Block *fromBlock);
 	Block *GetBlockFromAddress(u32 addr);
 	const Block *GetBlockFromAddress(u32 addr) const;
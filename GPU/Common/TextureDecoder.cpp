@@ -30,7 +30,15 @@
 
 #ifdef _M_SSE
 #include <emmintrin.h>
+#include <tmmintrin.h>
 #include <smmintrin.h>
+
+// These are only called after checking cpu_info, so allow the instructions regardless of -m flags.
+#if defined(__GNUC__) || defined(__clang__)
+#define SSSE3_FUNC __attribute__((target("ssse3")))
+#else
+#define SSSE3_FUNC
+#endif
 #endif
 
 #if PPSSPP_ARCH(ARM_NEON)
@@ -442,6 +450,42 @@ static inline int mix_2_3(int c1, int c2) {
 	return (c1 + c1 + c2) / 3;
 }
 
+#ifdef _M_SSE
+// Writes a full 4x4 block, looking up each texel's color with pshufb.
+// rowOr is OR-ed into each row (for alpha), and can be null.
+SSSE3_FUNC
+static void WriteDXTBlockSSSE3(u32 *dst, int pitch, const u32 colors[4], const u8 lines[4], const __m128i *rowOr) {
+	const __m128i colorTable = _mm_loadu_si128((const __m128i *)colors);
+	// Moves texel x's two index bits to bits 2-3, in both 16-bit halves of the texel.
+	const __m128i indexShift = _mm_setr_epi16(64, 64, 16, 16, 4, 4, 1, 1);
+	// Adds the byte offsets within the color, so each texel reads colors[index].
+	const __m128i byteOffsets = _mm_setr_epi16(0x0100, 0x0302, 0x0100, 0x0302, 0x0100, 0x0302, 0x0100, 0x0302);
+
+	for (int y = 0; y < 4; y++) {
+		__m128i index4 = _mm_mullo_epi16(_mm_set1_epi16(lines[y]), indexShift);
+		index4 = _mm_and_si128(_mm_srli_epi16(index4, 4), _mm_set1_epi16(0x000C));
+		__m128i control = _mm_add_epi16(_mm_mullo_epi16(index4, _mm_set1_epi16(0x0101)), byteOffsets);
+		__m128i row = _mm_shuffle_epi8(colorTable, control);
+		if (rowOr)
+			row = _mm_or_si128(row, rowOr[y]);
+		_mm_storeu_si128((__m128i *)dst, row);
+		dst += pitch;
+	}
+}
+
+SSSE3_FUNC
+static void WriteDXT3BlockSSSE3(u32 *dst, int pitch, const u32 colors[4], const DXT3Block *src) {
+	// Moves texel x's alpha nibble to the top of the texel.
+	const __m128i alphaShift = _mm_setr_epi16(0, 4096, 0, 256, 0, 16, 0, 1);
+	const __m128i alphaMask = _mm_set1_epi32(0xF0000000);
+	__m128i alpha[4];
+	for (int y = 0; y < 4; y++) {
+		alpha[y] = _mm_and_si128(_mm_mullo_epi16(_mm_set1_epi16(src->alphaLines[y]), alphaShift), alphaMask);
+	}
+	WriteDXTBlockSSSE3(dst, pitch, colors, src->color.lines, alpha);
+}
+#endif
+
 // This could probably be done faster by decoding two or four blocks at a time with SSE/NEON.
 void DXTDecoder::DecodeColors(const DXT1Block *src, bool ignore1bitAlpha) {
 	u16 c1 = src->color1;
@@ -508,6 +552,19 @@ void DXTDecoder::DecodeAlphaDXT5(const DXT5Block *src) {
 }
 
 void DXTDecoder::WriteColorsDXT1(u32 *dst, const DXT1Block *src, int pitch, int width, int height) {
+#ifdef _M_SSE
+	if (width == 4 && height == 4 && cpu_info.bSSSE3) {
+		WriteDXTBlockSSSE3(dst, pitch, colors_, src->lines, nullptr);
+		if (alphaMode_) {
+			// Any index of 3 (both bits set) is transparent.
+			u32 lines = src->lines[0] | (src->lines[1] << 8) | (src->lines[2] << 16) | (src->lines[3] << 24);
+			if ((lines & (lines >> 1) & 0x55555555) != 0)
+				anyNonFullAlpha_ = true;
+		}
+		return;
+	}
+#endif
+
 	bool anyColor3 = false;
 	for (int y = 0; y < height; y++) {
 		int colordata = src->lines[y];
@@ -528,6 +585,13 @@ void DXTDecoder::WriteColorsDXT1(u32 *dst, const DXT1Block *src, int pitch, int
 }
 
 void DXTDecoder::WriteColorsDXT3(u32 *dst, const DXT3Block *src, int pitch, int width, int height) {
+#ifdef _M_SSE
+	if (width == 4 && height == 4 && cpu_info.bSSSE3) {
+		WriteDXT3BlockSSSE3(dst, pitch, colors_, src);
+		return;
+	}
+#endif
+
 	for (int y = 0; y < height; y++) {
 		int colordata = src->color.lines[y];
 		u32 alphadata = src->alphaLines[y];
@@ -544,12 +608,26 @@ void DXTDecoder::WriteColorsDXT5(u32 *dst, const DXT5Block *src, int pitch, int
 	// 48 bits, 3 bit index per pixel, 12 bits per line.
 	u64 alphadata = ((u64)(u16)src->alphadata1 << 32) | (u32)src->alphadata2;
 
+#ifdef _M_SSE
+	if (width == 4 && height == 4 && cpu_info.bSSSE3) {
+		__m128i alpha[4];
+		for (int y = 0; y < 4; y++) {
+			alpha[y] = _mm_setr_epi32(alpha_[alphadata & 7] << 24, alpha_[(alphadata >> 3) & 7] << 24, alpha_[(alphadata >> 6) & 7] << 24, alpha_[(alphadata >> 9) & 7] << 24);
+			alphadata >>= 12;
+		}
+		WriteDXTBlockSSSE3(dst, pitch, colors_, src->color.lines, alpha);
+		return;
+	}
+#endif
+
 	for (int y = 0; y < height; y++) {
 		int colordata = src->color.lines[y];
+		// Narrow blocks still use 12 bits per line.
+		u32 alphaLine = (u32)(alphadata >> (y * 12));
 		for (int x = 0; x < width; x++) {
-			dst[x] = colors_[colordata & 3] | (alpha_[alphadata & 7] << 24);
+			dst[x] = colors_[colordata & 3] | (alpha_[alphaLine & 7] << 24);
 			colordata >>= 2;
-			alphadata >>= 3;
+			alphaLine >>= 3;
 		}
 		dst += pitch;
 	}
@@ -806,3 +884,181 @@ void CheckMask32(const u32 *src, int width, u32 *outMask) {
 	}
 	*outMask &= (u32)mask;
 }
+
+#ifdef _M_SSE
+SSSE3_FUNC
+static int DeIndexTexture4SSSE3(u16 *dest, const u8 *indexed, int length, const u16 *clut, u32 *outAlphaSum) {
+	// Split the 16 colors into tables of low and high bytes, for pshufb.
+	const __m128i lowByte = _mm_set1_epi16(0x00FF);
+	const __m128i clut0 = _mm_loadu_si128((const __m128i *)clut);
+	const __m128i clut1 = _mm_loadu_si128((const __m128i *)(clut + 8));
+	const __m128i tableLo = _mm_packus_epi16(_mm_and_si128(clut0, lowByte), _mm_and_si128(clut1, lowByte));
+	const __m128i tableHi = _mm_packus_epi16(_mm_srli_epi16(clut0, 8), _mm_srli_epi16(clut1, 8));
+	const __m128i nibble = _mm_set1_epi8(0x0F);
+
+	__m128i alphaSum = _mm_set1_epi32(0xFFFFFFFF);
+	int done = 0;
+	for (; done + 32 <= length; done += 32) {
+		__m128i packed = _mm_loadu_si128((const __m128i *)(indexed + done / 2));
+		__m128i lo = _mm_and_si128(packed, nibble);
+		__m128i hi = _mm_and_si128(_mm_srli_epi16(packed, 4), nibble);
+		__m128i indices[2] = { _mm_unpacklo_epi8(lo, hi), _mm_unpackhi_epi8(lo, hi) };
+		for (int i = 0; i < 2; ++i) {
+			__m128i colorLo = _mm_shuffle_epi8(tableLo, indices[i]);
+			__m128i colorHi = _mm_shuffle_epi8(tableHi, indices[i]);
+			__m128i color0 = _mm_unpacklo_epi8(colorLo, colorHi);
+			__m128i color1 = _mm_unpackhi_epi8(colorLo, colorHi);
+			_mm_storeu_si128((__m128i *)(dest + done + i * 16), color0);
+			_mm_storeu_si128((__m128i *)(dest + done + i * 16 + 8), color1);
+			alphaSum = _mm_and_si128(alphaSum, _mm_and_si128(color0, color1));
+		}
+	}
+
+	if (done != 0)
+		*outAlphaSum &= SSEReduce16And(alphaSum);
+	return done;
+}
+
+SSSE3_FUNC
+static int DeIndexTexture4SSSE3(u32 *dest, const u8 *indexed, int length, const u32 *clut, u32 *outAlphaSum) {
+	// One table per byte of the 16 colors, for pshufb.
+	const __m128i lowByte = _mm_set1_epi32(0x000000FF);
+	__m128i clutVecs[4];
+	for (int i = 0; i < 4; ++i)
+		clutVecs[i] = _mm_loadu_si128((const __m128i *)(clut + i * 4));
+	__m128i tables[4];
+	for (int b = 0; b < 4; ++b) {
+		__m128i parts[4];
+		for (int i = 0; i < 4; ++i)
+			parts[i] = _mm_and_si128(_mm_srli_epi32(clutVecs[i], b * 8), lowByte);
+		tables[b] = _mm_packus_epi16(_mm_packs_epi32(parts[0], parts[1]), _mm_packs_epi32(parts[2], parts[3]));
+	}
+	const __m128i nibble = _mm_set1_epi8(0x0F);
+
+	__m128i alphaSum = _mm_set1_epi32(0xFFFFFFFF);
+	int done = 0;
+	for (; done + 16 <= length; done += 16) {
+		__m128i packed = _mm_loadl_epi64((const __m128i *)(indexed + done / 2));
+		__m128i lo = _mm_and_si128(packed, nibble);
+		__m128i hi = _mm_and_si128(_mm_srli_epi16(packed, 4), nibble);
+		__m128i index = _mm_unpacklo_epi8(lo, hi);
+
+		__m128i b0 = _mm_shuffle_epi8(tables[0], index);
+		__m128i b1 = _mm_shuffle_epi8(tables[1], index);
+		__m128i b2 = _mm_shuffle_epi8(tables[2], index);
+		__m128i b3 = _mm_shuffle_epi8(tables[3], index);
+		__m128i lo01 = _mm_unpacklo_epi8(b0, b1);
+		__m128i hi01 = _mm_unpackhi_epi8(b0, b1);
+		__m128i lo23 = _mm_unpacklo_epi8(b2, b3);
+		__m128i hi23 = _mm_unpackhi_epi8(b2, b3);
+
+		__m128i colors[4] = {
+			_mm_unpacklo_epi16(lo01, lo23),
+			_mm_unpackhi_epi16(lo01, lo23),
+			_mm_unpacklo_epi16(hi01, hi23),
+			_mm_unpackhi_epi16(hi01, hi23),
+		};
+		for (int i = 0; i < 4; ++i) {
+			_mm_storeu_si128((__m128i *)(dest + done + i * 4), colors[i]);
+			alphaSum = _mm_and_si128(alphaSum, colors[i]);
+		}
+	}
+
+	if (done != 0)
+		*outAlphaSum &= SSEReduce32And(alphaSum);
+	return done;
+}
+#endif
+
+#if PPSSPP_ARCH(ARM_NEON)
+static inline uint8x16_t NEONLookup16(uint8x16_t table, uint8x16_t index) {
+#if PPSSPP_ARCH(ARM64)
+	return vqtbl1q_u8(table, index);
+#else
+	uint8x8x2_t table2 = { { vget_low_u8(table), vget_high_u8(table) } };
+	return vcombine_u8(vtbl2_u8(table2, vget_low_u8(index)), vtbl2_u8(table2, vget_high_u8(index)));
+#endif
+}
+
+static inline u32 NEONReduce8And(uint8x16_t value) {
+	uint8x8_t half = vand_u8(vget_low_u8(value), vget_high_u8(value));
+	uint32x2_t half32 = vreinterpret_u32_u8(half);
+	u32 mask = vget_lane_u32(half32, 0) & vget_lane_u32(half32, 1);
+	mask &= mask >> 16;
+	mask &= mask >> 8;
+	return mask & 0xFF;
+}
+
+static inline uint8x16_t NEONUnpackNibbles(const u8 *indexed) {
+	uint8x8_t packed = vld1_u8(indexed);
+	uint8x8x2_t zipped = vzip_u8(vand_u8(packed, vdup_n_u8(0x0F)), vshr_n_u8(packed, 4));
+	return vcombine_u8(zipped.val[0], zipped.val[1]);
+}
+
+static int DeIndexTexture4NEON(u16 *dest, const u8 *indexed, int length, const u16 *clut, u32 *outAlphaSum) {
+	// De-interleaves into tables of low and high bytes.
+	const uint8x16x2_t tables = vld2q_u8((const u8 *)clut);
+
+	uint8x16_t alphaSumLo = vdupq_n_u8(0xFF);
+	uint8x16_t alphaSumHi = vdupq_n_u8(0xFF);
+	int done = 0;
+	for (; done + 16 <= length; done += 16) {
+		uint8x16_t index = NEONUnpackNibbles(indexed + done / 2);
+		uint8x16x2_t colors;
+		colors.val[0] = NEONLookup16(tables.val[0], index);
+		colors.val[1] = NEONLookup16(tables.val[1], index);
+		vst2q_u8((u8 *)(dest + done), colors);
+		alphaSumLo = vandq_u8(alphaSumLo, colors.val[0]);
+		alphaSumHi = vandq_u8(alphaSumHi, colors.val[1]);
+	}
+
+	if (done != 0)
+		*outAlphaSum &= NEONReduce8And(alphaSumLo) | (NEONReduce8And(alphaSumHi) << 8);
+	return done;
+}
+
+static int DeIndexTexture4NEON(u32 *dest, const u8 *indexed, int length, const u32 *clut, u32 *outAlphaSum) {
+	// One table per byte of the 16 colors.
+	const uint8x16x4_t tables = vld4q_u8((const u8 *)clut);
+
+	uint8x16_t alphaSum[4] = { vdupq_n_u8(0xFF), vdupq_n_u8(0xFF), vdupq_n_u8(0xFF), vdupq_n_u8(0xFF) };
+	int done = 0;
+	for (; done + 16 <= length; done += 16) {
+		uint8x16_t index = NEONUnpackNibbles(indexed + done / 2);
+		uint8x16x4_t colors;
+		for (int b = 0; b < 4; ++b) {
+			colors.val[b] = NEONLookup16(tables.val[b], index);
+			alphaSum[b] = vandq_u8(alphaSum[b], colors.val[b]);
+		}
+		vst4q_u8((u8 *)(dest + done), colors);
+	}
+
+	if (done != 0) {
+		u32 mask = 0;
+		for (int b = 0; b < 4; ++b)
+			mask |= NEONReduce8And(alphaSum[b]) << (b * 8);
+		*outAlphaSum &= mask;
+	}
+	return done;
+}
+#endif
+
+int DeIndexTexture4SIMD(u16 *dest, const u8 *indexed, int length, const u16 *clut, u32 *outAlphaSum) {
+#ifdef _M_SSE
+	if (cpu_info.bSSSE3)
+		return DeIndexTexture4SSSE3(dest, indexed, length, clut, outAlphaSum);
+#elif PPSSPP_ARCH(ARM_NEON)
+	return DeIndexTexture4NEON(dest, indexed, length, clut, outAlphaSum);
+#endif
+	return 0;
+}
+
+int DeIndexTexture4SIMD(u32 *dest, const u8 *indexed, int length, const u32 *clut, u32 *outAlphaSum) {
+#ifdef _M_SSE
+	if (cpu_info.bSSSE3)
+		return DeIndexTexture4SSSE3(dest, indexed, length, clut, outAlphaSum);
+#elif PPSSPP_ARCH(ARM_NEON)
+	return DeIndexTexture4NEON(dest, indexed, length, clut, outAlphaSum);
+#endif
+	return 0;
+}
@@ -118,6 +118,11 @@ inline CheckAlphaResult CheckAlpha32Rect(const u32 *pixelData, int stride, int w
 	return AlphaSumIsFull(alphaSum, fullAlphaMask) ? CHECKALPHA_FULL : CHECKALPHA_ANY;
 }
 
+// Handles as many texels as possible with a SIMD table lookup, if supported by the CPU.
+// Only for simple clut indexing.  Returns the number of texels written (always even.)
+int DeIndexTexture4SIMD(u16 *dest, const u8 *indexed, int length, const u16 *clut, u32 *outAlphaSum);
+int DeIndexTexture4SIMD(u32 *dest, const u8 *indexed, int length, const u32 *clut, u32 *outAlphaSum);
+
 template <typename IndexT, typename ClutT>
 inline void DeIndexTexture(/*WRITEONLY*/ ClutT *dest, const IndexT *indexed, int length, const ClutT *clut, u32 *outAlphaSum) {
 	// Usually, there is no special offset, mask, or shift.
@@ -163,6 +168,11 @@ inline void DeIndexTexture4(/*WRITEONLY*/ ClutT *dest, const u8 *indexed, int le
 
 	ClutT alphaSum = (ClutT)(-1);
 	if (nakedIndex) {
+		int done = DeIndexTexture4SIMD(dest, indexed, length, clut, outAlphaSum);
+		dest += done;
+		indexed += done / 2;
+		length -= done;
+
 		while (length >= 2) {
 			u8 index = *indexed++;
 			ClutT color0 = clut[index & 0xf];
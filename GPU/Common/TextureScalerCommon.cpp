@@ -20,8 +20,10 @@
 #include <cstdlib>
 #include <cstring>
 #include <cmath>
+#include <vector>
 
 #include "GPU/Common/TextureScalerCommon.h"
+#include "GPU/Common/TextureScalerDiskCache.h"
 
 #include "Core/Config.h"
 #include "Common/Common.h"
@@ -35,6 +37,7 @@
 #if defined(_M_SSE)
 #include <emmintrin.h>
 #include <smmintrin.h>
+#include <immintrin.h>
 #endif
 
 // Report the time and throughput for each larger scaling operation in the log
@@ -68,29 +71,6 @@ namespace {
 
 #define BLOCK_SIZE 32
 
-// 3x3 convolution with Neumann boundary conditions, parallelizable
-// quite slow, could be sped up a lot
-// especially handling of separable kernels
-void convolve3x3(const u32 *data, u32 *out, const int kernel[3][3], int width, int height, int l, int u) {
-	for (int yb = 0; yb < (u - l) / BLOCK_SIZE + 1; ++yb) {
-		for (int xb = 0; xb < width / BLOCK_SIZE + 1; ++xb) {
-			for (int y = l + yb*BLOCK_SIZE; y < l + (yb + 1)*BLOCK_SIZE && y < u; ++y) {
-				for (int x = xb*BLOCK_SIZE; x < (xb + 1)*BLOCK_SIZE && x < width; ++x) {
-					int val = 0;
-					for (int yoff = -1; yoff <= 1; ++yoff) {
-						int yy = std::max(std::min(y + yoff, height - 1), 0);
-						for (int xoff = -1; xoff <= 1; ++xoff) {
-							int xx = std::max(std::min(x + xoff, width - 1), 0);
-							val += data[yy*width + xx] * kernel[yoff + 1][xoff + 1];
-						}
-					}
-					out[y*width + x] = abs(val);
-				}
-			}
-		}
-	}
-}
-
 // deposterization: smoothes posterized gradients from low-color-depth (e.g. 444, 565, compressed) sources
 void deposterizeH(const u32 *data, u32 *out, int w, int l, int u) {
 	static const int T = 8;
@@ -150,48 +130,51 @@ void deposterizeV(const u32 *data, u32 *out, int w, int h, int l, int u) {
 	}
 }
 
-// generates a distance mask value for each pixel in data
+// generates a distance mask value for each pixel in row y of data
 // higher values -> larger distance to the surrounding pixels
-void generateDistanceMask(const u32 *data, u32 *out, int width, int height, int l, int u) {
-	for (int yb = 0; yb < (u - l) / BLOCK_SIZE + 1; ++yb) {
-		for (int xb = 0; xb < width / BLOCK_SIZE + 1; ++xb) {
-			for (int y = l + yb*BLOCK_SIZE; y < l + (yb + 1)*BLOCK_SIZE && y < u; ++y) {
-				for (int x = xb*BLOCK_SIZE; x < (xb + 1)*BLOCK_SIZE && x < width; ++x) {
-					const u32 center = data[y*width + x];
-					u32 dist = 0;
-					for (int yoff = -1; yoff <= 1; ++yoff) {
-						int yy = y + yoff;
-						if (yy == height || yy == -1) {
-							dist += 1200; // assume distance at borders, usually makes for better result
-							continue;
-						}
-						for (int xoff = -1; xoff <= 1; ++xoff) {
-							if (yoff == 0 && xoff == 0) continue;
-							int xx = x + xoff;
-							if (xx == width || xx == -1) {
-								dist += 400; // assume distance at borders, usually makes for better result
-								continue;
-							}
-							dist += DISTANCE(data[yy*width + xx], center);
-						}
-					}
-					out[y*width + x] = dist;
+void distanceMaskRow(const u32 *data, u32 *out, int width, int height, int y) {
+	for (int x = 0; x < width; ++x) {
+		const u32 center = data[y*width + x];
+		u32 dist = 0;
+		for (int yoff = -1; yoff <= 1; ++yoff) {
+			int yy = y + yoff;
+			if (yy == height || yy == -1) {
+				dist += 1200; // assume distance at borders, usually makes for better result
+				continue;
+			}
+			for (int xoff = -1; xoff <= 1; ++xoff) {
+				if (yoff == 0 && xoff == 0) continue;
+				int xx = x + xoff;
+				if (xx == width || xx == -1) {
+					dist += 400; // assume distance at borders, usually makes for better result
+					continue;
 				}
+				dist += DISTANCE(data[yy*width + xx], center);
 			}
 		}
+		out[x] = dist;
 	}
 }
 
-// mix two images based on a mask
-void mix(u32 *data, const u32 *source, const u32 *mask, u32 maskmax, int width, int l, int u) {
-	for (int y = l; y < u; ++y) {
-		for (int x = 0; x < width; ++x) {
-			int pos = y*width + x;
-			u8 mixFactors[2] = { 0, static_cast<u8>((std::min(mask[pos], maskmax) * 255) / maskmax) };
-			mixFactors[0] = 255 - mixFactors[1];
-			data[pos] = MIX_PIXELS(data[pos], source[pos], mixFactors);
-			if (A(source[pos]) == 0) data[pos] = data[pos] & 0x00FFFFFF; // xBRZ always does a better job with hard alpha
-		}
+// 3x3 box filter (splat) of three rows with Neumann boundary conditions
+// colSum is scratch space for width values
+void splatRow(const u32 *above, const u32 *row, const u32 *below, u32 *out, u32 *colSum, int width) {
+	for (int x = 0; x < width; ++x) {
+		colSum[x] = above[x] + row[x] + below[x];
+	}
+	for (int x = 0; x < width; ++x) {
+		out[x] = colSum[std::max(x - 1, 0)] + colSum[x] + colSum[std::min(x + 1, width - 1)];
+	}
+}
+
+// mix two rows based on a mask, the result replaces sharp
+void mixRow(u32 *sharp, const u32 *smooth, const u32 *mask, u32 maskmax, int width) {
+	for (int x = 0; x < width; ++x) {
+		u8 mixFactors[2] = { 0, static_cast<u8>((std::min(mask[x], maskmax) * 255) / maskmax) };
+		mixFactors[0] = 255 - mixFactors[1];
+		u32 sharpPixel = sharp[x];
+		sharp[x] = MIX_PIXELS(smooth[x], sharpPixel, mixFactors);
+		if (A(sharpPixel) == 0) sharp[x] = sharp[x] & 0x00FFFFFF; // xBRZ always does a better job with hard alpha
 	}
 }
 
@@ -426,8 +409,107 @@ static void upscale_block_sse2(
 			memcpy(dst_pixels + 4*(BLOCK*iy+ix), &pixel, 4);
 		}
 }
+
+// The AVX variant runs the same arithmetic as the SSE2 one on two output
+// pixels per instruction. It's only called after checking cpu_info.
+#if defined(__GNUC__) || defined(__clang__)
+#define AVX_FUNC __attribute__((target("avx")))
+#else
+#define AVX_FUNC
+#endif
+
+AVX_FUNC static inline __m256 set2_ps(float lo, float hi) {
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(lo)), _mm_set1_ps(hi), 1);
+}
+
+AVX_FUNC static inline __m256 load2_ps(const float *lo, const float *hi) {
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(lo)), _mm_loadu_ps(hi), 1);
+}
+
+AVX_FUNC static void upscale_block_avx(
+	ptrdiff_t w, ptrdiff_t h,
+	ptrdiff_t src_stride, const u8 *src_pixels,
+	int wrap_mode, ptrdiff_t factor, float B, float C,
+	ptrdiff_t x0, ptrdiff_t y0,
+	u8 *dst_pixels) {
+	static_assert(BLOCK % 2 == 0, "AVX path processes pixel pairs");
+	float cx[BLOCK][4], cy[BLOCK][4];
+	ptrdiff_t lx[BLOCK], ly[BLOCK], lx0, ly0, sx, sy;
+	ALIGNED(32) u8 src[BLOCK+4][(BLOCK+4)*4];
+	ALIGNED(32) float buf[2][BLOCK+4][BLOCK+4][4];
+	init_block(
+		w, h, src_stride, src_pixels, wrap_mode, factor, B, C, x0, y0,
+		cx, cy, lx, ly, &lx0, &ly0, &sx, &sy, src);
+	// Unpack source pixels.
+	for(ptrdiff_t iy = 0; iy < sy; ++iy)
+		for(ptrdiff_t ix = 0; ix < sx; ++ix) {
+			int pixel;
+			memcpy(&pixel, src[iy] + 4*ix, 4);
+			__m128i C = _mm_cvtsi32_si128(pixel);
+			C = _mm_unpacklo_epi8(C, _mm_set1_epi32(0));
+			C = _mm_unpacklo_epi8(C, _mm_set1_epi32(0));
+			_mm_storeu_ps(buf[0][iy][ix], _mm_cvtepi32_ps(C));
+		}
+	// Horizontal pass, two dst columns at a time.
+	for(ptrdiff_t ix = 0; ix < BLOCK; ix += 2) {
+		#define S(i) load2_ps(buf[0][iy][lx[ix] + i], buf[0][iy][lx[ix + 1] + i])
+		__m256 C0 = set2_ps(cx[ix][0], cx[ix + 1][0]),
+			C1 = set2_ps(cx[ix][1], cx[ix + 1][1]),
+			C2 = set2_ps(cx[ix][2], cx[ix + 1][2]),
+			C3 = set2_ps(cx[ix][3], cx[ix + 1][3]);
+		for(ptrdiff_t iy = 0; iy < sy; ++iy)
+			_mm256_storeu_ps(buf[1][iy][ix],
+				_mm256_add_ps(_mm256_mul_ps(S(0), C0),
+				_mm256_add_ps(_mm256_mul_ps(S(1), C1),
+				_mm256_add_ps(_mm256_mul_ps(S(2), C2),
+							  _mm256_mul_ps(S(3), C3)))));
+		#undef S
+	}
+	// Vertical pass, neighbouring dst columns are contiguous here.
+	for(ptrdiff_t iy = 0; iy < BLOCK; ++iy) {
+		#define S(i) _mm256_loadu_ps(buf[1][ly[iy] + i][ix])
+		__m256 C0 = _mm256_set1_ps(cy[iy][0]),
+			C1 = _mm256_set1_ps(cy[iy][1]),
+			C2 = _mm256_set1_ps(cy[iy][2]),
+			C3 = _mm256_set1_ps(cy[iy][3]);
+		for(ptrdiff_t ix = 0; ix < BLOCK; ix += 2)
+			_mm256_storeu_ps(buf[0][iy][ix],
+				_mm256_add_ps(_mm256_mul_ps(S(0), C0),
+				_mm256_add_ps(_mm256_mul_ps(S(1), C1),
+				_mm256_add_ps(_mm256_mul_ps(S(2), C2),
+							  _mm256_mul_ps(S(3), C3)))));
+		#undef S
+	}
+	// Pack destination pixels.
+	for(ptrdiff_t iy = 0; iy < BLOCK; ++iy)
+		for(ptrdiff_t ix = 0; ix < BLOCK; ix += 2) {
+			__m256 C = _mm256_loadu_ps(buf[0][iy][ix]);
+			C = _mm256_min_ps(_mm256_max_ps(C, _mm256_set1_ps(0.0f)), _mm256_set1_ps(255.0f));
+			C = _mm256_add_ps(C, _mm256_set1_ps(0.5f));
+			__m256i R = _mm256_cvttps_epi32(C);
+			__m128i P = _mm_packs_epi32(_mm256_castsi256_si128(R), _mm256_extractf128_si256(R, 1));
+			P = _mm_packus_epi16(P, P);
+			_mm_storel_epi64((__m128i *)(dst_pixels + 4*(BLOCK*iy+ix)), P);
+		}
+}
 #endif // defined(_M_SSE)
 
+static void upscale_block(
+	ptrdiff_t w, ptrdiff_t h,
+	ptrdiff_t src_stride, const u8 *src_pixels,
+	int wrap_mode, ptrdiff_t factor, float B, float C,
+	ptrdiff_t x0, ptrdiff_t y0,
+	u8 *dst_pixels) {
+#if defined(_M_SSE)
+	if(cpu_info.bAVX)
+		upscale_block_avx (w, h, src_stride, src_pixels, wrap_mode, factor, B, C, x0, y0, dst_pixels);
+	else
+		upscale_block_sse2(w, h, src_stride, src_pixels, wrap_mode, factor, B, C, x0, y0, dst_pixels);
+#else
+	upscale_block_c   (w, h, src_stride, src_pixels, wrap_mode, factor, B, C, x0, y0, dst_pixels);
+#endif
+}
+
 static void upscale_cubic(
 	ptrdiff_t width, ptrdiff_t height,	ptrdiff_t src_stride_in_bytes, const void *src_pixels,
 									  	ptrdiff_t dst_stride_in_bytes, void       *dst_pixels,
@@ -436,11 +518,7 @@ static void upscale_cubic(
 	u8 pixels[BLOCK*BLOCK*4];
 	for(ptrdiff_t y = y0; y < y1; y+= BLOCK)
 		for(ptrdiff_t x = x0; x < x1; x+= BLOCK) {
-#if defined(_M_SSE)
-			upscale_block_sse2(width, height, src_stride_in_bytes, (const u8*)src_pixels, wrap_mode, scale, B, C, x, y, pixels);
-#else
-			upscale_block_c   (width, height, src_stride_in_bytes, (const u8*)src_pixels, wrap_mode, scale, B, C, x, y, pixels);
-#endif
+			upscale_block(width, height, src_stride_in_bytes, (const u8*)src_pixels, wrap_mode, scale, B, C, x, y, pixels);
 			for(ptrdiff_t iy = 0, ny = (y1-y < BLOCK ? y1-y : BLOCK), nx = (x1-x < BLOCK ? x1-x : BLOCK); iy < ny; ++iy)
 				memcpy((u8*)dst_pixels + dst_stride_in_bytes*(y+iy) + 4*x, pixels + BLOCK*4*iy, (size_t)(4*nx));
 		}
@@ -541,6 +619,86 @@ void bilinearV(int factor, const u32 *data, u32 *out, int w, int gl, int gu, int
 	}
 }
 
+//////////////////////////////////////////////////////////////////// Hybrid scaling
+
+// Rough per-tile working set. The upscaled mask dominates, so this decides how many
+// source lines a tile covers and keeps the intermediates in L2 instead of RAM.
+const int HYBRID_TILE_BYTES = 256 * 1024;
+const int HYBRID_MAX_TILE_LINES = 32;
+
+// Runs the whole hybrid pipeline (mask, xBRZ, bicubic/bilinear, mix) for source lines [l, u),
+// one tile at a time. The mask needs two source lines of context on each side, which are
+// recomputed per tile rather than round-tripping full size intermediates through memory.
+void scaleHybridRange(int factor, const u32 *source, u32 *dest, int width, int height, bool bicubic, int l, int u) {
+	// The factor 8192 was found through practical testing on a variety of textures
+	const u32 MASK_MAX = 8192;
+	const int outw = width * factor;
+	const int tileLines = std::max(1, std::min(HYBRID_MAX_TILE_LINES, HYBRID_TILE_BYTES / (outw * factor * 4)));
+
+	std::vector<u32> dist((tileLines + 4) * width);
+	std::vector<u32> splat((tileLines + 2) * width);
+	std::vector<u32> colSum(width);
+	std::vector<u32> scaledH((tileLines + 2) * outw);
+	std::vector<u32> mask((tileLines + 2) * factor * outw);
+	std::vector<u32> smooth(bicubic ? 0 : (tileLines + 2) * factor * outw);
+
+	xbrz::ScalerCfg cfg;
+	for (int tl = l; tl < u; tl += tileLines) {
+		const int tu = std::min(tl + tileLines, u);
+
+		// 1) distance mask for the tile plus a two line halo
+		const int dl = std::max(tl - 2, 0), du = std::min(tu + 2, height);
+		for (int y = dl; y < du; ++y) {
+			distanceMaskRow(source, &dist[(y - dl) * width], width, height, y);
+		}
+
+		// 2) splat it, one line of halo is left for the vertical bilinear pass
+		const int sl = std::max(tl - 1, 0), su = std::min(tu + 1, height);
+		for (int y = sl; y < su; ++y) {
+			const u32 *above = &dist[(std::max(y - 1, 0) - dl) * width];
+			const u32 *row = &dist[(y - dl) * width];
+			const u32 *below = &dist[(std::min(y + 1, height - 1) - dl) * width];
+			splatRow(above, row, below, &splat[(y - sl) * width], colSum.data(), width);
+		}
+
+		// 3) upscale the mask bilinearly. Line indices are local to the halo'd tile, which
+		// clamps at the same place as the whole image would since the halo ends at the borders.
+		const int localL = tl - sl, localU = tu - sl;
+		bilinearH(factor, splat.data(), scaledH.data(), width, 0, su - sl);
+		bilinearV(factor, scaledH.data(), mask.data(), width, 0, su - sl, localL, localU);
+		const u32 *tileMask = &mask[localL * factor * outw];
+
+		// 4) xBRZ straight into the output, it keeps its own small line buffers
+		xbrz::scale(factor, source, dest, width, height, xbrz::ColorFormat::ARGB, cfg, tl, tu);
+
+		// 5) + 6) smooth upscale and mix it into the xBRZ result
+		const int oy0 = tl * factor, oy1 = tu * factor;
+		if (bicubic) {
+			// B-Spline, computed per block and consumed while still hot.
+			const float B = 1.0f, C = 0.0f;
+			const int wrap_mode = 1; // Clamp
+			u32 pixels[BLOCK * BLOCK];
+			for (int y = oy0; y < oy1; y += BLOCK) {
+				const int ny = std::min(oy1 - y, BLOCK);
+				for (int x = 0; x < outw; x += BLOCK) {
+					const int nx = std::min(outw - x, BLOCK);
+					upscale_block(width, height, width * 4, (const u8 *)source, wrap_mode, factor, B, C, x, y, (u8 *)pixels);
+					for (int iy = 0; iy < ny; ++iy) {
+						mixRow(dest + (y + iy) * outw + x, pixels + BLOCK * iy, tileMask + (y - oy0 + iy) * outw + x, MASK_MAX, nx);
+					}
+				}
+			}
+		} else {
+			bilinearH(factor, source + sl * width, scaledH.data(), width, 0, su - sl);
+			bilinearV(factor, scaledH.data(), smooth.data(), width, 0, su - sl, localL, localU);
+			const u32 *tileSmooth = &smooth[localL * factor * outw];
+			for (int y = oy0; y < oy1; ++y) {
+				mixRow(dest + y * outw, tileSmooth + (y - oy0) * outw, tileMask + (y - oy0) * outw, MASK_MAX, outw);
+			}
+		}
+	}
+}
+
 #undef BLOCK_SIZE
 #undef MIX_PIXELS
 #undef DISTANCE
@@ -624,7 +782,21 @@ void TextureScalerCommon::ScaleAlways(u32 *out, u32 *src, int width, int height,
 				out[i] = pixel;
 			}
 		}
+	} else if (g_Config.bTexScalingDiskCache) {
+		if (!diskCache_)
+			diskCache_.reset(new ScaledTextureDiskCache());
+
+		size_t pixelCount = width * factor * height * factor;
+		u64 key = ScaledTextureDiskCache::MakeKey(src, width, height, factor, g_Config.iTexScalingType, g_Config.bTexDeposterize);
+		if (diskCache_->Lookup(key, out, pixelCount)) {
+			*scaledWidth = width * factor;
+			*scaledHeight = height * factor;
+			return;
+		}
+		ScaleInto(out, src, width, height, scaledWidth, scaledHeight, factor);
+		diskCache_->Store(key, out, pixelCount);
 	} else {
+		diskCache_.reset();
 		ScaleInto(out, src, width, height, scaledWidth, scaledHeight, factor);
 	}
 }
@@ -722,29 +894,8 @@ void TextureScalerCommon::ScaleHybrid(int factor, u32* source, u32* dest, int wi
 	// 2) generate 2 scaled images: A - using Bilinear filtering, B - using xBRZ
 	// 3) output = A*C + B*(1-C)
 
-	const static int KERNEL_SPLAT[3][3] = {
-			{ 1, 1, 1 }, { 1, 1, 1 }, { 1, 1, 1 }
-	};
-
-	bufTmp1.resize(width*height);
-	bufTmp2.resize(width*height*factor*factor);
-	bufTmp3.resize(width*height*factor*factor);
-
-	ParallelRangeLoop(&g_threadManager,std::bind(&generateDistanceMask, source, bufTmp1.data(), width, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
-	ParallelRangeLoop(&g_threadManager,std::bind(&convolve3x3, bufTmp1.data(), bufTmp2.data(), KERNEL_SPLAT, width, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
-	ScaleBilinear(factor, bufTmp2.data(), bufTmp3.data(), width, height);
-	// mask C is now in bufTmp3
-
-	ScaleXBRZ(factor, source, bufTmp2.data(), width, height);
-	// xBRZ upscaled source is in bufTmp2
-
-	if (bicubic) ScaleBicubicBSpline(factor, source, dest, width, height);
-	else ScaleBilinear(factor, source, dest, width, height);
-	// Upscaled source is in dest
-
-	// Now we can mix it all together
-	// The factor 8192 was found through practical testing on a variety of textures
-	ParallelRangeLoop(&g_threadManager,std::bind(&mix, dest, bufTmp2.data(), bufTmp3.data(), 8192, width*factor, std::placeholders::_1, std::placeholders::_2), 0, height*factor, MIN_LINES_PER_THREAD);
+	// All stages run fused per tile, see scaleHybridRange.
+	ParallelRangeLoop(&g_threadManager, std::bind(&scaleHybridRange, factor, source, dest, width, height, bicubic, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
 }
 
 void TextureScalerCommon::DePosterize(u32* source, u32* dest, int width, int height) {
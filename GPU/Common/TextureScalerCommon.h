@@ -17,9 +17,13 @@
 
 #pragma once
 
+#include <memory>
+
 #include "Common/CommonTypes.h"
 #include "Common/MemoryUtil.h"
 
+class ScaledTextureDiskCache;
+
 static const int MIN_TEXSCALE_LINES_PER_THREAD = 4;
 
 // The texture scaler requires input to be in R8G8B8A8.
@@ -47,8 +51,10 @@ class TextureScalerCommon {
 
 	bool IsEmptyOrFlat(const u32 *data, int pixels) const;
 
-	// depending on the factor and texture sizes, these can get pretty large 
-	// maximum is (100 MB total for a 512 by 512 texture with scaling factor 5 and hybrid scaling)
-	// of course, scaling factor 5 is totally silly anyway
+	// depending on the factor and texture sizes, these can get pretty large
+	// (hybrid scaling only needs small per-tile buffers, the rest still scale with the output size)
 	SimpleBuf<u32> bufDeposter, bufOutput, bufTmp1, bufTmp2, bufTmp3;
+
+	// Only created while the disk cache setting is on.
+	std::unique_ptr<ScaledTextureDiskCache> diskCache_;
 };
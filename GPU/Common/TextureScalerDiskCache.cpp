@@ -0,0 +1,443 @@
+// Copyright (c) 2012- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <zstd.h>
+
+#include "ext/xxhash.h"
+#include "Common/File/DirListing.h"
+#include "Common/File/FileUtil.h"
+#include "Common/File/Path.h"
+#include "Common/Log.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Core/Config.h"
+#include "Core/System.h"
+#include "GPU/Common/TextureScalerDiskCache.h"
+
+// Bump when the scalers change their output, so stale entries stop matching.
+static const u64 CACHE_VERSION = 1;
+static const u32 ENTRY_MAGIC = 0x31435354;  // TSC1
+static const u32 INDEX_MAGIC = 0x49435354;  // TSCI
+static const int CACHE_COMPRESSION_LEVEL = 3;
+static const char *const ENTRY_EXTENSION = "tsc";
+static const char *const INDEX_FILENAME = "index.dat";
+// Loaded entries kept in memory for when their texture is scaled again.
+static const u64 READY_BUDGET = 32 * 1024 * 1024;
+
+struct ScaledTextureEntryHeader {
+	u32 magic;
+	u32 pixels;
+};
+
+struct ScaledTextureIndexItem {
+	u64 key;
+	u64 lastUse;
+};
+
+struct ScaledTextureDiskCacheState {
+	struct Entry {
+		u64 size;
+		u64 lastUse;
+	};
+	struct ReadyEntry {
+		std::vector<u32> pixels;
+		std::list<u64>::iterator order;
+	};
+
+	std::mutex lock;
+	Path dir;
+	u64 budget = 0;
+	bool loaded = false;
+	std::unordered_map<u64, Entry> entries;
+	// Keys currently being compressed and written.
+	std::unordered_set<u64> pending;
+	// Keys currently being read and decompressed.
+	std::unordered_set<u64> loading;
+	// Decompressed entries, least recently used first in readyOrder.
+	std::unordered_map<u64, ReadyEntry> ready;
+	std::list<u64> readyOrder;
+	u64 readySize = 0;
+	u64 totalSize = 0;
+	u64 useCounter = 0;
+
+	Path EntryPath(u64 key) const {
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.%s", key, ENTRY_EXTENSION);
+		return dir / name;
+	}
+
+	void LoadIndex();
+	void Prefetch();
+	void SaveIndex();
+	bool ReadEntry(u64 key, size_t expectedPixels, std::vector<u32> *pixels);
+	void Forget(u64 key);
+	void EvictLocked();
+	void AddReadyLocked(u64 key, std::vector<u32> &&pixels);
+	void DropReadyLocked(u64 key);
+};
+
+void ScaledTextureDiskCacheState::LoadIndex() {
+	File::CreateFullPath(dir);
+
+	// The index only remembers recency. The directory itself is authoritative for which entries
+	// exist, so leftovers from a crash or writes that finished after shutdown are still picked up.
+	std::unordered_map<u64, u64> lastUses;
+	FILE *f = File::OpenCFile(dir / INDEX_FILENAME, "rb");
+	if (f) {
+		u32 magic = 0;
+		u32 count = 0;
+		if (fread(&magic, sizeof(magic), 1, f) == 1 && magic == INDEX_MAGIC && fread(&count, sizeof(count), 1, f) == 1) {
+			std::vector<ScaledTextureIndexItem> items(count);
+			if (count != 0 && fread(&items[0], sizeof(ScaledTextureIndexItem), count, f) == count) {
+				for (const auto &item : items) {
+					lastUses[item.key] = item.lastUse;
+				}
+			}
+		}
+		fclose(f);
+	}
+
+	std::vector<File::FileInfo> files;
+	File::GetFilesInDir(dir, &files, ENTRY_EXTENSION);
+
+	std::lock_guard<std::mutex> guard(lock);
+	for (const auto &file : files) {
+		char *end = nullptr;
+		u64 key = strtoull(file.name.c_str(), &end, 16);
+		if (end != file.name.c_str() + 16) {
+			continue;
+		}
+		auto lastUse = lastUses.find(key);
+		Entry &entry = entries[key];
+		entry.size = file.size;
+		entry.lastUse = lastUse != lastUses.end() ? lastUse->second : 0;
+		totalSize += entry.size;
+		useCounter = std::max(useCounter, entry.lastUse);
+	}
+	loaded = true;
+	INFO_LOG(G3D, "Scaled texture cache: %d entries, %d KB", (int)entries.size(), (int)(totalSize / 1024));
+
+	// The budget may have been lowered since last time.
+	EvictLocked();
+}
+
+void ScaledTextureDiskCacheState::SaveIndex() {
+	std::vector<ScaledTextureIndexItem> items;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		if (!loaded) {
+			return;
+		}
+		items.reserve(entries.size());
+		for (const auto &it : entries) {
+			items.push_back({ it.first, it.second.lastUse });
+		}
+	}
+
+	FILE *f = File::OpenCFile(dir / INDEX_FILENAME, "wb");
+	if (!f) {
+		WARN_LOG(G3D, "Scaled texture cache: unable to write index");
+		return;
+	}
+	u32 count = (u32)items.size();
+	bool success = fwrite(&INDEX_MAGIC, sizeof(INDEX_MAGIC), 1, f) == 1 && fwrite(&count, sizeof(count), 1, f) == 1;
+	if (success && count != 0) {
+		success = fwrite(&items[0], sizeof(ScaledTextureIndexItem), count, f) == count;
+	}
+	fclose(f);
+	if (!success) {
+		File::Delete(dir / INDEX_FILENAME);
+	}
+}
+
+void ScaledTextureDiskCacheState::Forget(u64 key) {
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		auto it = entries.find(key);
+		if (it == entries.end()) {
+			return;
+		}
+		totalSize -= it->second.size;
+		entries.erase(it);
+		DropReadyLocked(key);
+	}
+	File::Delete(EntryPath(key));
+}
+
+void ScaledTextureDiskCacheState::EvictLocked() {
+	if (totalSize <= budget) {
+		return;
+	}
+
+	std::vector<std::pair<u64, u64>> byAge;
+	byAge.reserve(entries.size());
+	for (const auto &it : entries) {
+		byAge.push_back(std::make_pair(it.second.lastUse, it.first));
+	}
+	std::sort(byAge.begin(), byAge.end());
+
+	for (const auto &victim : byAge) {
+		if (totalSize <= budget) {
+			break;
+		}
+		auto it = entries.find(victim.second);
+		totalSize -= it->second.size;
+		entries.erase(it);
+		DropReadyLocked(victim.second);
+		File::Delete(EntryPath(victim.second));
+	}
+}
+
+void ScaledTextureDiskCacheState::AddReadyLocked(u64 key, std::vector<u32> &&pixels) {
+	DropReadyLocked(key);
+	readySize += pixels.size() * sizeof(u32);
+	readyOrder.push_back(key);
+	ready[key] = ReadyEntry{ std::move(pixels), std::prev(readyOrder.end()) };
+
+	while (readySize > READY_BUDGET && !readyOrder.empty()) {
+		DropReadyLocked(readyOrder.front());
+	}
+}
+
+void ScaledTextureDiskCacheState::DropReadyLocked(u64 key) {
+	auto it = ready.find(key);
+	if (it != ready.end()) {
+		readySize -= it->second.pixels.size() * sizeof(u32);
+		readyOrder.erase(it->second.order);
+		ready.erase(it);
+	}
+}
+
+bool ScaledTextureDiskCacheState::ReadEntry(u64 key, size_t expectedPixels, std::vector<u32> *pixels) {
+	size_t fileSize = 0;
+	uint8_t *data = File::ReadLocalFile(EntryPath(key), &fileSize);
+	bool success = false;
+	if (data && fileSize >= sizeof(ScaledTextureEntryHeader)) {
+		ScaledTextureEntryHeader header;
+		memcpy(&header, data, sizeof(header));
+		// When prefetching, we don't know the size yet and take the header's word for it.
+		if (header.magic == ENTRY_MAGIC && (expectedPixels == 0 || header.pixels == expectedPixels)) {
+			size_t rawSize = header.pixels * sizeof(u32);
+			pixels->resize(header.pixels);
+			size_t decompressed = ZSTD_decompress(pixels->data(), rawSize, data + sizeof(header), fileSize - sizeof(header));
+			success = !ZSTD_isError(decompressed) && decompressed == rawSize;
+		}
+	}
+	delete[] data;
+
+	if (!success) {
+		// Truncated or otherwise bad, drop it so it gets scaled and written again.
+		WARN_LOG(G3D, "Scaled texture cache: dropping bad entry %016llx", key);
+		Forget(key);
+	}
+	return success;
+}
+
+void ScaledTextureDiskCacheState::Prefetch() {
+	// Whatever was used most recently last time is likely to be needed again soon.
+	std::vector<std::pair<u64, u64>> byAge;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		byAge.reserve(entries.size());
+		for (const auto &it : entries) {
+			byAge.push_back(std::make_pair(it.second.lastUse, it.first));
+		}
+	}
+	std::sort(byAge.begin(), byAge.end(), std::greater<std::pair<u64, u64>>());
+
+	for (const auto &candidate : byAge) {
+		u64 key = candidate.second;
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			if (readySize >= READY_BUDGET) {
+				break;
+			}
+			if (!entries.count(key) || ready.count(key) || !loading.insert(key).second) {
+				continue;
+			}
+		}
+
+		std::vector<u32> pixels;
+		bool success = ReadEntry(key, 0, &pixels);
+
+		std::lock_guard<std::mutex> guard(lock);
+		loading.erase(key);
+		if (!success || !entries.count(key)) {
+			continue;
+		}
+		// Don't push out what's already there, including entries a lookup loaded meanwhile.
+		if (readySize + pixels.size() * sizeof(u32) > READY_BUDGET) {
+			break;
+		}
+		AddReadyLocked(key, std::move(pixels));
+	}
+}
+
+class ScaledTextureIndexTask : public Task {
+public:
+	ScaledTextureIndexTask(std::shared_ptr<ScaledTextureDiskCacheState> state) : state_(state) {}
+
+	TaskType Type() const override { return TaskType::IO_BLOCKING; }
+	TaskPriority Priority() const override { return TaskPriority::LOW; }
+
+	void Run() override {
+		state_->LoadIndex();
+		state_->Prefetch();
+	}
+
+private:
+	std::shared_ptr<ScaledTextureDiskCacheState> state_;
+};
+
+class ScaledTextureStoreTask : public Task {
+public:
+	ScaledTextureStoreTask(std::shared_ptr<ScaledTextureDiskCacheState> state, u64 key, std::vector<u32> &&pixels)
+		: state_(state), key_(key), pixels_(std::move(pixels)) {}
+
+	// Compression is CPU heavy too, but the write must not end up behind parallel loops.
+	TaskType Type() const override { return TaskType::IO_BLOCKING; }
+	TaskPriority Priority() const override { return TaskPriority::LOW; }
+
+	void Run() override {
+		size_t rawSize = pixels_.size() * sizeof(u32);
+		std::vector<u8> compressed(sizeof(ScaledTextureEntryHeader) + ZSTD_compressBound(rawSize));
+		size_t compressedSize = ZSTD_compress(&compressed[sizeof(ScaledTextureEntryHeader)], compressed.size() - sizeof(ScaledTextureEntryHeader), pixels_.data(), rawSize, CACHE_COMPRESSION_LEVEL);
+
+		bool success = !ZSTD_isError(compressedSize);
+		size_t fileSize = sizeof(ScaledTextureEntryHeader) + compressedSize;
+		Path path = state_->EntryPath(key_);
+		if (success) {
+			ScaledTextureEntryHeader header{ ENTRY_MAGIC, (u32)pixels_.size() };
+			memcpy(&compressed[0], &header, sizeof(header));
+			FILE *f = File::OpenCFile(path, "wb");
+			success = f && fwrite(&compressed[0], 1, fileSize, f) == fileSize;
+			if (f) {
+				fclose(f);
+			}
+			if (!success) {
+				File::Delete(path);
+			}
+		}
+
+		std::lock_guard<std::mutex> guard(state_->lock);
+		state_->pending.erase(key_);
+		if (success) {
+			ScaledTextureDiskCacheState::Entry &entry = state_->entries[key_];
+			entry.size = fileSize;
+			entry.lastUse = ++state_->useCounter;
+			state_->totalSize += fileSize;
+			state_->EvictLocked();
+		} else {
+			WARN_LOG(G3D, "Scaled texture cache: failed to write %s", path.c_str());
+		}
+	}
+
+private:
+	std::shared_ptr<ScaledTextureDiskCacheState> state_;
+	u64 key_;
+	std::vector<u32> pixels_;
+};
+
+class ScaledTextureLoadTask : public Task {
+public:
+	ScaledTextureLoadTask(std::shared_ptr<ScaledTextureDiskCacheState> state, u64 key, size_t pixels)
+		: state_(state), key_(key), pixels_(pixels) {}
+
+	TaskType Type() const override { return TaskType::IO_BLOCKING; }
+	TaskPriority Priority() const override { return TaskPriority::LOW; }
+
+	void Run() override {
+		std::vector<u32> pixels;
+		bool success = state_->ReadEntry(key_, pixels_, &pixels);
+
+		std::lock_guard<std::mutex> guard(state_->lock);
+		state_->loading.erase(key_);
+		// It may have been evicted while we were reading it.
+		if (success && state_->entries.count(key_)) {
+			state_->AddReadyLocked(key_, std::move(pixels));
+		}
+	}
+
+private:
+	std::shared_ptr<ScaledTextureDiskCacheState> state_;
+	u64 key_;
+	size_t pixels_;
+};
+
+ScaledTextureDiskCache::ScaledTextureDiskCache() : state_(std::make_shared<ScaledTextureDiskCacheState>()) {
+	state_->dir = GetSysDirectory(DIRECTORY_CACHE) / "texscale";
+	state_->budget = (u64)std::max(g_Config.iTexScalingCacheSizeMB, 1) * 1024 * 1024;
+	g_threadManager.EnqueueTask(new ScaledTextureIndexTask(state_));
+}
+
+ScaledTextureDiskCache::~ScaledTextureDiskCache() {
+	state_->SaveIndex();
+}
+
+u64 ScaledTextureDiskCache::MakeKey(const u32 *src, int width, int height, int factor, int scalerType, bool deposterize) {
+	u64 seed = (u64)width | ((u64)height << 16) | ((u64)factor << 32) | ((u64)scalerType << 40) | ((u64)deposterize << 48) | (CACHE_VERSION << 56);
+	return XXH3_64bits_withSeed(src, width * height * sizeof(u32), seed);
+}
+
+bool ScaledTextureDiskCache::Lookup(u64 key, u32 *out, size_t pixels) {
+	{
+		std::lock_guard<std::mutex> guard(state_->lock);
+		if (!state_->loaded || !state_->entries.count(key)) {
+			return false;
+		}
+		state_->entries[key].lastUse = ++state_->useCounter;
+
+		auto it = state_->ready.find(key);
+		if (it != state_->ready.end()) {
+			if (it->second.pixels.size() != pixels) {
+				state_->DropReadyLocked(key);
+				return false;
+			}
+			memcpy(out, it->second.pixels.data(), pixels * sizeof(u32));
+			// Stays loaded for the next revisit, until the budget pushes it out.
+			state_->readyOrder.splice(state_->readyOrder.end(), state_->readyOrder, it->second.order);
+			return true;
+		}
+
+		if (!state_->loading.insert(key).second) {
+			return false;
+		}
+	}
+
+	g_threadManager.EnqueueTask(new ScaledTextureLoadTask(state_, key, pixels));
+	return false;
+}
+
+void ScaledTextureDiskCache::Store(u64 key, const u32 *data, size_t pixels) {
+	{
+		std::lock_guard<std::mutex> guard(state_->lock);
+		if (!state_->loaded || state_->entries.count(key) || !state_->pending.insert(key).second) {
+			return;
+		}
+	}
+
+	std::vector<u32> copy(data, data + pixels);
+	g_threadManager.EnqueueTask(new ScaledTextureStoreTask(state_, key, std::move(copy)));
+}
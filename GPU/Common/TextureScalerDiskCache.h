@@ -0,0 +1,51 @@
+// Copyright (c) 2012- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "Common/CommonTypes.h"
+
+struct ScaledTextureDiskCacheState;
+
+// Optional on-disk cache of CPU upscaled textures, so that revisits (also across sessions)
+// don't have to run xBRZ/hybrid again. Entries are zstd compressed, one file each, and
+// evicted least recently used first once the configured size budget is exceeded.
+// The index is loaded, and entries are read and written, on background tasks. The upload
+// thread never touches the disk: a lookup only hits once the entry has been loaded. The most
+// recently used entries are loaded right after the index, and loaded entries stay in memory
+// (within a budget) so revisits keep hitting.
+class ScaledTextureDiskCache {
+public:
+	ScaledTextureDiskCache();
+	~ScaledTextureDiskCache();
+
+	// Identifies the scaled output for a decoded source texture and the current scaler settings.
+	static u64 MakeKey(const u32 *src, int width, int height, int factor, int scalerType, bool deposterize);
+
+	// Returns false on a miss, including while the index is still loading. An entry that is
+	// on disk but not loaded yet also misses, and starts loading for the next time around.
+	bool Lookup(u64 key, u32 *out, size_t pixels);
+	// Copies data, compression and writing happen in the background.
+	void Store(u64 key, const u32 *data, size_t pixels);
+
+private:
+	// Shared with in-flight tasks, which may outlive the cache.
+	std::shared_ptr<ScaledTextureDiskCacheState> state_;
+};
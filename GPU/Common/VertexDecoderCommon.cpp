@@ -37,6 +37,18 @@
 #include "GPU/Math3D.h"
 #include "GPU/Common/VertexDecoderCommon.h"
 
+#ifdef _M_SSE
+#include <emmintrin.h>
+#endif
+
+#if PPSSPP_ARCH(ARM_NEON)
+#if defined(_MSC_VER) && PPSSPP_ARCH(ARM64)
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif
+
 static const u8 tcsize[4] = { 0, 2, 4, 8 }, tcalign[4] = { 0, 1, 2, 4 };
 static const u8 colsize[8] = { 0, 0, 0, 0, 2, 2, 2, 4 }, colalign[8] = { 0, 0, 0, 0, 2, 2, 2, 4 };
 static const u8 nrmsize[4] = { 0, 3, 6, 12 }, nrmalign[4] = { 0, 1, 2, 4 };
@@ -103,15 +115,95 @@ void DecVtxFormat::InitializeFromID(uint32_t id) {
 	stride = posoff + DecFmtSize(posfmt);
 }
 
+// Handles the bulk of the indices 16 bytes at a time, returns how many were processed.
+static int GetIndexBounds8SIMD(const u8 *ind8, int count, int &lowerBound, int &upperBound) {
+	int i = 0;
+#if defined(_M_SSE)
+	__m128i minv = _mm_set1_epi8((char)0xFF);
+	__m128i maxv = _mm_setzero_si128();
+	for (; i + 16 <= count; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(ind8 + i));
+		minv = _mm_min_epu8(minv, v);
+		maxv = _mm_max_epu8(maxv, v);
+	}
+	alignas(16) u8 mins[16];
+	alignas(16) u8 maxs[16];
+	_mm_store_si128((__m128i *)mins, minv);
+	_mm_store_si128((__m128i *)maxs, maxv);
+#elif PPSSPP_ARCH(ARM_NEON)
+	uint8x16_t minv = vdupq_n_u8(0xFF);
+	uint8x16_t maxv = vdupq_n_u8(0);
+	for (; i + 16 <= count; i += 16) {
+		uint8x16_t v = vld1q_u8(ind8 + i);
+		minv = vminq_u8(minv, v);
+		maxv = vmaxq_u8(maxv, v);
+	}
+	u8 mins[16];
+	u8 maxs[16];
+	vst1q_u8(mins, minv);
+	vst1q_u8(maxs, maxv);
+#else
+	const u8 mins[1]{ 0xFF };
+	const u8 maxs[1]{ 0 };
+#endif
+	if (i != 0) {
+		for (size_t j = 0; j < ARRAY_SIZE(mins); ++j) {
+			lowerBound = std::min(lowerBound, (int)mins[j]);
+			upperBound = std::max(upperBound, (int)maxs[j]);
+		}
+	}
+	return i;
+}
+
+static int GetIndexBounds16SIMD(const u16_le *ind16, int count, int &lowerBound, int &upperBound) {
+	int i = 0;
+#if defined(_M_SSE)
+	// SSE2 only has signed 16-bit min/max, so flip the sign bit to keep the order.
+	const __m128i bias = _mm_set1_epi16((short)0x8000);
+	__m128i minv = _mm_set1_epi16(0x7FFF);
+	__m128i maxv = _mm_set1_epi16((short)0x8000);
+	for (; i + 8 <= count; i += 8) {
+		__m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(ind16 + i)), bias);
+		minv = _mm_min_epi16(minv, v);
+		maxv = _mm_max_epi16(maxv, v);
+	}
+	alignas(16) u16 mins[8];
+	alignas(16) u16 maxs[8];
+	_mm_store_si128((__m128i *)mins, _mm_xor_si128(minv, bias));
+	_mm_store_si128((__m128i *)maxs, _mm_xor_si128(maxv, bias));
+#elif PPSSPP_ARCH(ARM_NEON)
+	uint16x8_t minv = vdupq_n_u16(0xFFFF);
+	uint16x8_t maxv = vdupq_n_u16(0);
+	for (; i + 8 <= count; i += 8) {
+		uint16x8_t v = vld1q_u16((const uint16_t *)(ind16 + i));
+		minv = vminq_u16(minv, v);
+		maxv = vmaxq_u16(maxv, v);
+	}
+	u16 mins[8];
+	u16 maxs[8];
+	vst1q_u16(mins, minv);
+	vst1q_u16(maxs, maxv);
+#else
+	const u16 mins[1]{ 0xFFFF };
+	const u16 maxs[1]{ 0 };
+#endif
+	if (i != 0) {
+		for (size_t j = 0; j < ARRAY_SIZE(mins); ++j) {
+			lowerBound = std::min(lowerBound, (int)mins[j]);
+			upperBound = std::max(upperBound, (int)maxs[j]);
+		}
+	}
+	return i;
+}
+
 void GetIndexBounds(const void *inds, int count, u32 vertType, u16 *indexLowerBound, u16 *indexUpperBound) {
 	// Find index bounds. Could cache this in display lists.
-	// Also, this could be greatly sped up with SSE2/NEON, although rarely a bottleneck.
 	int lowerBound = 0x7FFFFFFF;
 	int upperBound = 0;
 	u32 idx = vertType & GE_VTYPE_IDX_MASK;
 	if (idx == GE_VTYPE_IDX_8BIT) {
 		const u8 *ind8 = (const u8 *)inds;
-		for (int i = 0; i < count; i++) {
+		for (int i = GetIndexBounds8SIMD(ind8, count, lowerBound, upperBound); i < count; i++) {
 			u8 value = ind8[i];
 			if (value > upperBound)
 				upperBound = value;
@@ -120,7 +212,7 @@ void GetIndexBounds(const void *inds, int count, u32 vertType, u16 *indexLowerBo
 		}
 	} else if (idx == GE_VTYPE_IDX_16BIT) {
 		const u16_le *ind16 = (const u16_le *)inds;
-		for (int i = 0; i < count; i++) {
+		for (int i = GetIndexBounds16SIMD(ind16, count, lowerBound, upperBound); i < count; i++) {
 			u16 value = ind16[i];
 			if (value > upperBound)
 				upperBound = value;
@@ -1063,6 +1155,65 @@ static const StepFunction posstep_through[4] = {
 	&VertexDecoder::Step_PosFloatThrough,
 };
 
+template <StepFunction... steps>
+static void DecodeSpecialized(const VertexDecoder &dec, int count) {
+	const int size = dec.size;
+	const int stride = dec.decFmt.stride;
+	for (; count; count--) {
+		// The steps are known here, so unlike steps_ these calls can be inlined.
+		((dec.*steps)(), ...);
+		dec.ptr_ += size;
+		dec.decoded_ += stride;
+	}
+}
+
+struct SpecializedDecoderEntry {
+	StepFunction steps[3];
+	int numSteps;
+	SpecializedVertexDecoder func;
+};
+
+template <StepFunction... steps>
+static constexpr SpecializedDecoderEntry Specialize() {
+	return { { steps... }, (int)sizeof...(steps), &DecodeSpecialized<steps...> };
+}
+
+#define STEP(name) &VertexDecoder::Step_##name
+
+// The most common step lists, roughly: 3D models with u16 or float UVs, and 2D/UI in through mode.
+// Matched against the steps rather than the vtype, since options and gstate pick the steps too.
+static const SpecializedDecoderEntry specializedDecoders[] = {
+	Specialize<STEP(TcU16Prescale), STEP(NormalS16), STEP(PosS16)>(),
+	Specialize<STEP(TcU16Prescale), STEP(NormalS8), STEP(PosS16)>(),
+	Specialize<STEP(TcU16Prescale), STEP(NormalS8ToFloat), STEP(PosS16)>(),
+	Specialize<STEP(TcU16Prescale), STEP(NormalFloat), STEP(PosFloat)>(),
+	Specialize<STEP(TcU16Prescale), STEP(Color8888), STEP(PosS16)>(),
+	Specialize<STEP(TcU16Prescale), STEP(PosS16)>(),
+	Specialize<STEP(TcU8Prescale), STEP(NormalS8), STEP(PosS8)>(),
+	Specialize<STEP(TcFloatPrescale), STEP(NormalFloat), STEP(PosFloat)>(),
+	Specialize<STEP(TcFloatPrescale), STEP(Color8888), STEP(PosFloat)>(),
+	Specialize<STEP(TcFloatPrescale), STEP(PosFloat)>(),
+	Specialize<STEP(NormalS16), STEP(PosS16)>(),
+	Specialize<STEP(NormalFloat), STEP(PosFloat)>(),
+	Specialize<STEP(Color8888), STEP(PosS16)>(),
+	Specialize<STEP(Color8888), STEP(PosFloat)>(),
+	Specialize<STEP(PosS16)>(),
+	Specialize<STEP(PosFloat)>(),
+
+	Specialize<STEP(TcU16ThroughToFloat), STEP(Color8888), STEP(PosS16Through)>(),
+	Specialize<STEP(TcU16ThroughToFloat), STEP(Color4444), STEP(PosS16Through)>(),
+	Specialize<STEP(TcU16ThroughToFloat), STEP(Color5551), STEP(PosS16Through)>(),
+	Specialize<STEP(TcU16ThroughToFloat), STEP(PosS16Through)>(),
+	Specialize<STEP(TcFloatThrough), STEP(Color8888), STEP(PosFloatThrough)>(),
+	Specialize<STEP(TcFloatThrough), STEP(PosFloatThrough)>(),
+	Specialize<STEP(Color8888), STEP(PosS16Through)>(),
+	Specialize<STEP(Color8888), STEP(PosFloatThrough)>(),
+	Specialize<STEP(PosS16Through)>(),
+	Specialize<STEP(PosFloatThrough)>(),
+};
+
+#undef STEP
+
 void VertexDecoder::SetVertexType(u32 fmt, const VertexDecoderOptions &options, VertexDecoderJitCache *jitCache) {
 	fmt_ = fmt;
 	throughmode = (fmt & GE_VTYPE_THROUGH) != 0;
@@ -1272,6 +1423,14 @@ void VertexDecoder::SetVertexType(u32 fmt, const VertexDecoderOptions &options,
 	_assert_msg_(decFmt.posfmt == DEC_FLOAT_3, "Reader only supports float pos");
 	_assert_msg_(decFmt.uvfmt == DEC_FLOAT_2 || decFmt.uvfmt == DEC_NONE, "Reader only supports float UV");
 
+	specialized_ = nullptr;
+	for (const SpecializedDecoderEntry &entry : specializedDecoders) {
+		if (entry.numSteps == numSteps_ && std::equal(steps_, steps_ + numSteps_, entry.steps)) {
+			specialized_ = entry.func;
+			break;
+		}
+	}
+
 	// Attempt to JIT as well. But only do that if the main CPU JIT is enabled, in order to aid
 	// debugging attempts - if the main JIT doesn't work, this one won't do any better, probably.
 	if (jitCache) {
@@ -1301,6 +1460,8 @@ void VertexDecoder::DecodeVerts(u8 *decodedptr, const void *verts, int indexLowe
 	if (jitted_) {
 		// We've compiled the steps into optimized machine code, so just jump!
 		jitted_(ptr_, decoded_, count);
+	} else if (specialized_) {
+		specialized_(*this, count);
 	} else {
 		// Interpret the decode steps
 		for (; count; count--) {
@@ -321,6 +321,8 @@ struct JitLookup {
 int TranslateNumBones(int bones);
 
 typedef void(*JittedVertexDecoder)(const u8 *src, u8 *dst, int count);
+// Decode loop with the steps for one common vertex format compiled in, used when there's no jit.
+typedef void(*SpecializedVertexDecoder)(const VertexDecoder &dec, int count);
 
 struct VertexDecoderOptions {
 	bool expandAllWeightsToFloat;
@@ -438,6 +440,7 @@ class VertexDecoder {
 	mutable const u8 *ptr_ = nullptr;
 	JittedVertexDecoder jitted_ = 0;
 	int32_t jittedSize_ = 0;
+	SpecializedVertexDecoder specialized_ = nullptr;
 
 	// "Immutable" state, set at startup
 
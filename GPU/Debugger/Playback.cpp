@@ -25,6 +25,7 @@
 #include "Common/Profiler/Profiler.h"
 #include "Common/CommonTypes.h"
 #include "Common/Log.h"
+#include "Common/TimeUtil.h"
 #include "Core/Config.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
@@ -50,6 +51,8 @@ static uint32_t lastExecVersion;
 static std::vector<Command> lastExecCommands;
 static std::vector<u8> lastExecPushbuf;
 static std::mutex executeLock;
+static ReplayStats replayStats;
+static bool replayStatsActive = false;
 
 // This class maps pushbuffer (dump data) sections to PSP memory.
 // Dumps can be larger than available PSP memory, because they include generated data too.
@@ -657,6 +660,10 @@ bool DumpExecute::Run() {
 	if (gpu)
 		gpu->SetAddrTranslation(0x400);
 
+	// The GPU times each command as it runs the lists we submit.
+	replayStatsActive = coreCollectDebugStats;
+	double runStart = replayStatsActive ? time_now_d() : 0.0;
+
 	for (const Command &cmd : commands_) {
 		switch (cmd.type) {
 		case CommandType::INIT:
@@ -731,11 +738,18 @@ bool DumpExecute::Run() {
 
 		default:
 			ERROR_LOG(SYSTEM, "Unsupported GE dump command: %d", (int)cmd.type);
+			replayStatsActive = false;
 			return false;
 		}
 	}
 
 	SubmitListEnd();
+
+	if (replayStatsActive) {
+		replayStats.runs++;
+		replayStats.seconds += time_now_d() - runStart;
+		replayStatsActive = false;
+	}
 	return true;
 }
 
@@ -770,6 +784,18 @@ static void ReplayStop() {
 	lastExecVersion = 0;
 }
 
+const ReplayStats &GetReplayStats() {
+	return replayStats;
+}
+
+void ResetReplayStats() {
+	replayStats = {};
+}
+
+ReplayStats *GetActiveReplayStats() {
+	return replayStatsActive ? &replayStats : nullptr;
+}
+
 bool RunMountedReplay(const std::string &filename) {
 	_assert_msg_(!GPURecord::IsActivePending(), "Cannot run replay while recording.");
 
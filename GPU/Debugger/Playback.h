@@ -21,6 +21,25 @@
 
 namespace GPURecord {
 
+struct ReplayCommandStats {
+	int count;
+	double seconds;
+};
+
+// Only collected while coreCollectDebugStats is enabled.
+struct ReplayStats {
+	int runs;
+	double seconds;
+	// Indexed by GE command (op >> 24), as executed from the replayed display lists.
+	// Includes any flush of deferred draws the command triggered.
+	ReplayCommandStats commands[256];
+};
+
 bool RunMountedReplay(const std::string &filename);
 
+const ReplayStats &GetReplayStats();
+void ResetReplayStats();
+// Non-null while a replay is collecting stats, for the GPU to time each command it runs.
+ReplayStats *GetActiveReplayStats();
+
 };
@@ -103,6 +103,7 @@ struct GPUStatistics {
 		numReplacerTrackedTex = 0;
 		numCachedReplacedTextures = 0;
 		msProcessingDisplayLists = 0;
+		msRasterizing = 0;
 		vertexGPUCycles = 0;
 		otherGPUCycles = 0;
 	}
@@ -138,6 +139,8 @@ struct GPUStatistics {
 	int numReplacerTrackedTex;
 	int numCachedReplacedTextures;
 	double msProcessingDisplayLists;
+	// Software renderer only, time spent waiting for binned drawing to finish.
+	double msRasterizing;
 	int vertexGPUCycles;
 	int otherGPUCycles;
 
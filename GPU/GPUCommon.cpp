@@ -43,6 +43,7 @@
 #include "GPU/Common/FramebufferManagerCommon.h"
 #include "GPU/Common/TextureCacheCommon.h"
 #include "GPU/Debugger/Debugger.h"
+#include "GPU/Debugger/Playback.h"
 #include "GPU/Debugger/Record.h"
 
 void GPUCommon::Flush() {
@@ -723,7 +724,8 @@ bool GPUCommon::InterpretList(DisplayList &list) {
 
 	// To enable breakpoints, we don't do fast matrix loads while debugger active.
 	debugRecording_ = GPUDebug::IsActive() || GPURecord::IsActive();
-	const bool useFastRunLoop = !dumpThisFrame_ && !debugRecording_;
+	// Replay stats need each command timed.
+	const bool useFastRunLoop = !dumpThisFrame_ && !debugRecording_ && !GPURecord::GetActiveReplayStats();
 	while (gpuState == GPUSTATE_RUNNING) {
 		{
 			if (list.pc == list.stall) {
@@ -785,12 +787,14 @@ void GPUCommon::BeginFrame() {
 
 void GPUCommon::SlowRunLoop(DisplayList &list) {
 	const bool dumpThisFrame = dumpThisFrame_;
+	GPURecord::ReplayStats *replayStats = GPURecord::GetActiveReplayStats();
 	while (downcount > 0) {
 		bool process = GPUDebug::NotifyCommand(list.pc);
 		if (process) {
 			GPURecord::NotifyCommand(list.pc);
 			u32 op = Memory::ReadUnchecked_U32(list.pc);
 			u32 cmd = op >> 24;
+			double cmdStart = replayStats ? time_now_d() : 0.0;
 
 			u32 diff = op ^ gstate.cmdmem[cmd];
 			PreExecuteOp(op, diff);
@@ -808,6 +812,12 @@ void GPUCommon::SlowRunLoop(DisplayList &list) {
 			gstate.cmdmem[cmd] = op;
 
 			ExecuteOp(op, diff);
+
+			if (replayStats) {
+				GPURecord::ReplayCommandStats &stats = replayStats->commands[cmd];
+				stats.count++;
+				stats.seconds += time_now_d() - cmdStart;
+			}
 		}
 
 		list.pc += 4;
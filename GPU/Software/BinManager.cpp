@@ -22,6 +22,7 @@
 #include "Common/Thread/ThreadManager.h"
 #include "Common/TimeUtil.h"
 #include "Core/System.h"
+#include "GPU/GPU.h"
 #include "GPU/Common/TextureDecoder.h"
 #include "GPU/Software/BinManager.h"
 #include "GPU/Software/Rasterizer.h"
@@ -592,6 +593,7 @@ void BinManager::Flush(const char *reason) {
 	if (coreCollectDebugStats) {
 		double et = time_now_d();
 		flushReasonTimes_[reason] += et - st;
+		gpuStats.msRasterizing += et - st;
 		if (et - st > slowestFlushTime_) {
 			slowestFlushTime_ = et - st;
 			slowestFlushReason_ = reason;
@@ -94,6 +94,7 @@ GPU_Vulkan::GPU_Vulkan(GraphicsContext *gfxCtx, Draw::DrawContext *draw)
 	if (discID.size()) {
 		File::CreateFullPath(GetSysDirectory(DIRECTORY_APP_CACHE));
 		shaderCachePath_ = GetSysDirectory(DIRECTORY_APP_CACHE) / (discID + ".vkshadercache");
+		spirvCachePath_ = GetSysDirectory(DIRECTORY_APP_CACHE) / (discID + ".vkspirvcache");
 		shaderCacheLoaded_ = false;
 
 		std::thread th([&] {
@@ -121,6 +122,9 @@ void GPU_Vulkan::LoadCache(const Path &filename) {
 	}
 
 	PSP_SetLoading("Loading shader cache...");
+	// Load the SPIR-V first, so the shaders below mostly skip compiling.
+	shaderManagerVulkan_->LoadSpirvCache(spirvCachePath_);
+
 	// Actually precompiled by IsReady() since we're single-threaded.
 	FILE *f = File::OpenCFile(filename, "rb");
 	if (!f)
@@ -171,6 +175,9 @@ void GPU_Vulkan::SaveCache(const Path &filename) {
 		return;
 	}
 
+	if (!spirvCachePath_.empty())
+		shaderManagerVulkan_->SaveSpirvCache(spirvCachePath_);
+
 	FILE *f = File::OpenCFile(filename, "wb");
 	if (!f)
 		return;
@@ -85,5 +85,6 @@ class GPU_Vulkan : public GPUCommonHW {
 	PipelineManagerVulkan *pipelineManager_;
 
 	Path shaderCachePath_;
+	Path spirvCachePath_;
 	std::atomic<bool> shaderCacheLoaded_{};
 };
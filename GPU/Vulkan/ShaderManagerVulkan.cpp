@@ -47,14 +47,14 @@
 // Most drivers treat vkCreateShaderModule as pretty much a memcpy. What actually
 // takes time here, and makes this worthy of parallelization, is GLSLtoSPV.
 // Takes ownership over tag.
-static Promise<VkShaderModule> *CompileShaderModuleAsync(VulkanContext *vulkan, VkShaderStageFlagBits stage, const char *code, std::string *tag) {
+static Promise<VkShaderModule> *CompileShaderModuleAsync(VulkanContext *vulkan, SpirvCache *spirvCache, VkShaderStageFlagBits stage, const char *code, std::string *tag) {
 	auto compile = [=] {
 		PROFILE_THIS_SCOPE("shadercomp");
 
 		std::string errorMessage;
 		std::vector<uint32_t> spirv;
 
-		bool success = GLSLtoSPV(stage, code, GLSLVariant::VULKAN, spirv, &errorMessage);
+		bool success = spirvCache->Compile(stage, code, GLSLVariant::VULKAN, spirv, &errorMessage);
 
 		if (!errorMessage.empty()) {
 			if (success) {
@@ -110,10 +110,10 @@ static Promise<VkShaderModule> *CompileShaderModuleAsync(VulkanContext *vulkan,
 	}
 }
 
-VulkanFragmentShader::VulkanFragmentShader(VulkanContext *vulkan, FShaderID id, FragmentShaderFlags flags, const char *code)
+VulkanFragmentShader::VulkanFragmentShader(VulkanContext *vulkan, SpirvCache *spirvCache, FShaderID id, FragmentShaderFlags flags, const char *code)
 	: vulkan_(vulkan), id_(id), flags_(flags) {
 	source_ = code;
-	module_ = CompileShaderModuleAsync(vulkan, VK_SHADER_STAGE_FRAGMENT_BIT, source_.c_str(), new std::string(FragmentShaderDesc(id)));
+	module_ = CompileShaderModuleAsync(vulkan, spirvCache, VK_SHADER_STAGE_FRAGMENT_BIT, source_.c_str(), new std::string(FragmentShaderDesc(id)));
 	if (!module_) {
 		failed_ = true;
 	} else {
@@ -145,10 +145,10 @@ std::string VulkanFragmentShader::GetShaderString(DebugShaderStringType type) co
 	}
 }
 
-VulkanVertexShader::VulkanVertexShader(VulkanContext *vulkan, VShaderID id, VertexShaderFlags flags, const char *code, bool useHWTransform)
+VulkanVertexShader::VulkanVertexShader(VulkanContext *vulkan, SpirvCache *spirvCache, VShaderID id, VertexShaderFlags flags, const char *code, bool useHWTransform)
 	: vulkan_(vulkan), useHWTransform_(useHWTransform), flags_(flags), id_(id) {
 	source_ = code;
-	module_ = CompileShaderModuleAsync(vulkan, VK_SHADER_STAGE_VERTEX_BIT, source_.c_str(), new std::string(VertexShaderDesc(id)));
+	module_ = CompileShaderModuleAsync(vulkan, spirvCache, VK_SHADER_STAGE_VERTEX_BIT, source_.c_str(), new std::string(VertexShaderDesc(id)));
 	if (!module_) {
 		failed_ = true;
 	} else {
@@ -180,10 +180,10 @@ std::string VulkanVertexShader::GetShaderString(DebugShaderStringType type) cons
 	}
 }
 
-VulkanGeometryShader::VulkanGeometryShader(VulkanContext *vulkan, GShaderID id, const char *code)
+VulkanGeometryShader::VulkanGeometryShader(VulkanContext *vulkan, SpirvCache *spirvCache, GShaderID id, const char *code)
 	: vulkan_(vulkan), id_(id) {
 	source_ = code;
-	module_ = CompileShaderModuleAsync(vulkan, VK_SHADER_STAGE_GEOMETRY_BIT, source_.c_str(), new std::string(GeometryShaderDesc(id).c_str()));
+	module_ = CompileShaderModuleAsync(vulkan, spirvCache, VK_SHADER_STAGE_GEOMETRY_BIT, source_.c_str(), new std::string(GeometryShaderDesc(id).c_str()));
 	if (!module_) {
 		failed_ = true;
 	} else {
@@ -352,7 +352,7 @@ void ShaderManagerVulkan::GetShaders(int prim, VertexDecoder *decoder, VulkanVer
 		std::lock_guard<std::mutex> guard(cacheLock_);
 		vs = vsCache_.Get(VSID);
 		if (!vs) {
-			vs = new VulkanVertexShader(vulkan, VSID, flags, codeBuffer_, useHWTransform);
+			vs = new VulkanVertexShader(vulkan, &spirvCache_, VSID, flags, codeBuffer_, useHWTransform);
 			vsCache_.Insert(VSID, vs);
 		}
 	}
@@ -370,7 +370,7 @@ void ShaderManagerVulkan::GetShaders(int prim, VertexDecoder *decoder, VulkanVer
 		std::lock_guard<std::mutex> guard(cacheLock_);
 		fs = fsCache_.Get(FSID);
 		if (!fs) {
-			fs = new VulkanFragmentShader(vulkan, FSID, flags, codeBuffer_);
+			fs = new VulkanFragmentShader(vulkan, &spirvCache_, FSID, flags, codeBuffer_);
 			fsCache_.Insert(FSID, fs);
 		}
 	}
@@ -388,7 +388,7 @@ void ShaderManagerVulkan::GetShaders(int prim, VertexDecoder *decoder, VulkanVer
 			std::lock_guard<std::mutex> guard(cacheLock_);
 			gs = gsCache_.Get(GSID);
 			if (!gs) {
-				gs = new VulkanGeometryShader(vulkan, GSID, codeBuffer_);
+				gs = new VulkanGeometryShader(vulkan, &spirvCache_, GSID, codeBuffer_);
 				gsCache_.Insert(GSID, gs);
 			}
 		}
@@ -585,7 +585,7 @@ bool ShaderManagerVulkan::LoadCache(FILE *f) {
 			continue;
 		}
 		_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "VS length error: %d", (int)strlen(codeBuffer_));
-		VulkanVertexShader *vs = new VulkanVertexShader(vulkan, id, flags, codeBuffer_, useHWTransform);
+		VulkanVertexShader *vs = new VulkanVertexShader(vulkan, &spirvCache_, id, flags, codeBuffer_, useHWTransform);
 		// Remove first, just to be safe (we are loading on a background thread.)
 		std::lock_guard<std::mutex> guard(cacheLock_);
 		VulkanVertexShader *old = vsCache_.Get(id);
@@ -613,7 +613,7 @@ bool ShaderManagerVulkan::LoadCache(FILE *f) {
 			continue;
 		}
 		_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "FS length error: %d", (int)strlen(codeBuffer_));
-		VulkanFragmentShader *fs = new VulkanFragmentShader(vulkan, id, flags, codeBuffer_);
+		VulkanFragmentShader *fs = new VulkanFragmentShader(vulkan, &spirvCache_, id, flags, codeBuffer_);
 		std::lock_guard<std::mutex> guard(cacheLock_);
 		VulkanFragmentShader *old = fsCache_.Get(id);
 		if (old) {
@@ -637,7 +637,7 @@ bool ShaderManagerVulkan::LoadCache(FILE *f) {
 			continue;
 		}
 		_assert_msg_(strlen(codeBuffer_) < CODE_BUFFER_SIZE, "GS length error: %d", (int)strlen(codeBuffer_));
-		VulkanGeometryShader *gs = new VulkanGeometryShader(vulkan, id, codeBuffer_);
+		VulkanGeometryShader *gs = new VulkanGeometryShader(vulkan, &spirvCache_, id, codeBuffer_);
 		std::lock_guard<std::mutex> guard(cacheLock_);
 		VulkanGeometryShader *old = gsCache_.Get(id);
 		if (old) {
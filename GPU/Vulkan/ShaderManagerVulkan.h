@@ -28,6 +28,7 @@
 #include "GPU/Common/ShaderId.h"
 #include "GPU/Common/VertexShaderGenerator.h"
 #include "GPU/Common/FragmentShaderGenerator.h"
+#include "GPU/Vulkan/SpirvCache.h"
 #include "GPU/Vulkan/VulkanUtil.h"
 #include "Common/Math/lin/matrix4x4.h"
 #include "GPU/Common/ShaderUniforms.h"
@@ -38,7 +39,7 @@ class VulkanPushPool;
 
 class VulkanFragmentShader {
 public:
-	VulkanFragmentShader(VulkanContext *vulkan, FShaderID id, FragmentShaderFlags flags, const char *code);
+	VulkanFragmentShader(VulkanContext *vulkan, SpirvCache *spirvCache, FShaderID id, FragmentShaderFlags flags, const char *code);
 	~VulkanFragmentShader();
 
 	const std::string &source() const { return source_; }
@@ -63,7 +64,7 @@ class VulkanFragmentShader {
 
 class VulkanVertexShader {
 public:
-	VulkanVertexShader(VulkanContext *vulkan, VShaderID id, VertexShaderFlags flags, const char *code, bool useHWTransform);
+	VulkanVertexShader(VulkanContext *vulkan, SpirvCache *spirvCache, VShaderID id, VertexShaderFlags flags, const char *code, bool useHWTransform);
 	~VulkanVertexShader();
 
 	const std::string &source() const { return source_; }
@@ -89,7 +90,7 @@ class VulkanVertexShader {
 
 class VulkanGeometryShader {
 public:
-	VulkanGeometryShader(VulkanContext *vulkan, GShaderID id, const char *code);
+	VulkanGeometryShader(VulkanContext *vulkan, SpirvCache *spirvCache, GShaderID id, const char *code);
 	~VulkanGeometryShader();
 
 	const std::string &source() const { return source_; }
@@ -160,6 +161,10 @@ class ShaderManagerVulkan : public ShaderManagerCommon {
 	bool LoadCache(FILE *f);
 	void SaveCache(FILE *f, DrawEngineVulkan *drawEngine);
 
+	// Compiled SPIR-V, kept in its own file as it's not tied to the device.
+	bool LoadSpirvCache(const Path &filename) { return spirvCache_.Load(filename); }
+	bool SaveSpirvCache(const Path &filename) { return spirvCache_.Save(filename); }
+
 private:
 	void Clear();
 
@@ -176,6 +181,7 @@ class ShaderManagerVulkan : public ShaderManagerCommon {
 
 	char *codeBuffer_;
 	std::mutex cacheLock_;
+	SpirvCache spirvCache_;
 
 	uint64_t uboAlignment_;
 	// Uniform block scratchpad. These (the relevant ones) are copied to the current pushbuffer at draw time.
@@ -0,0 +1,210 @@
+// Copyright (c) 2015- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "ext/xxhash.h"
+#include "Common/File/FileUtil.h"
+#include "Common/File/Path.h"
+#include "Common/Log.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "GPU/Vulkan/SpirvCache.h"
+
+static const uint32_t SPIRV_CACHE_MAGIC = 0x56505350;  // PSPV
+static const uint32_t SPIRV_CACHE_VERSION = 1;
+
+struct SpirvCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t compilerHash;
+	uint32_t count;
+	uint32_t pad;
+};
+
+struct SpirvCacheEntryHeader {
+	uint64_t key;
+	// Of the words, so a damaged entry gets dropped rather than handed to the driver.
+	uint64_t hash;
+	uint32_t words;
+	uint32_t pad;
+};
+
+static uint64_t CompilerHash() {
+	static const uint64_t hash = [] {
+		std::string version = GLSLtoSPVVersion();
+		return XXH3_64bits(version.data(), version.size());
+	}();
+	return hash;
+}
+
+uint64_t SpirvCache::MakeKey(VkShaderStageFlagBits stage, GLSLVariant variant, const char *source) {
+	uint64_t seed = CompilerHash() ^ ((uint64_t)stage << 32) ^ (uint64_t)variant;
+	return XXH3_64bits_withSeed(source, strlen(source), seed);
+}
+
+bool SpirvCache::Compile(VkShaderStageFlagBits stage, const char *source, GLSLVariant variant, std::vector<uint32_t> &spirv, std::string *errorMessage) {
+	uint64_t key = MakeKey(stage, variant, source);
+	if (Lookup(key, &spirv)) {
+		return true;
+	}
+	if (!GLSLtoSPV(stage, source, variant, spirv, errorMessage)) {
+		return false;
+	}
+	Insert(key, spirv);
+	return true;
+}
+
+bool SpirvCache::Lookup(uint64_t key, std::vector<uint32_t> *spirv) {
+	std::lock_guard<std::mutex> guard(lock_);
+	auto it = blobs_.find(key);
+	if (it == blobs_.end()) {
+		return false;
+	}
+	*spirv = it->second;
+	return true;
+}
+
+void SpirvCache::Insert(uint64_t key, const std::vector<uint32_t> &spirv) {
+	std::lock_guard<std::mutex> guard(lock_);
+	if (blobs_.emplace(key, spirv).second) {
+		dirty_ = true;
+	}
+}
+
+bool SpirvCache::Load(const Path &filename) {
+	size_t fileSize = 0;
+	uint8_t *data = File::ReadLocalFile(filename, &fileSize);
+	if (!data) {
+		return false;
+	}
+
+	SpirvCacheHeader header{};
+	if (fileSize >= sizeof(header)) {
+		memcpy(&header, data, sizeof(header));
+	}
+	if (header.magic != SPIRV_CACHE_MAGIC || header.version != SPIRV_CACHE_VERSION || header.compilerHash != CompilerHash()) {
+		// Everything in it would miss anyway, it'll get rewritten on save.
+		WARN_LOG(G3D, "SPIR-V cache is from a different version, ignoring");
+		delete[] data;
+		return false;
+	}
+
+	// Finding the entries is cheap, copying and checking them is what's worth spreading out.
+	struct PendingEntry {
+		SpirvCacheEntryHeader header;
+		const uint8_t *words;
+	};
+	std::vector<PendingEntry> entries;
+	entries.reserve(std::min((size_t)header.count, fileSize / sizeof(SpirvCacheEntryHeader)));
+	size_t pos = sizeof(header);
+	for (uint32_t i = 0; i < header.count; ++i) {
+		PendingEntry entry;
+		if (fileSize - pos < sizeof(entry.header)) {
+			break;
+		}
+		memcpy(&entry.header, data + pos, sizeof(entry.header));
+		pos += sizeof(entry.header);
+		if ((fileSize - pos) / sizeof(uint32_t) < entry.header.words) {
+			break;
+		}
+		entry.words = data + pos;
+		pos += entry.header.words * sizeof(uint32_t);
+		entries.push_back(entry);
+	}
+
+	std::vector<std::vector<uint32_t>> blobs(entries.size());
+	ParallelRangeLoop(&g_threadManager, [&](int lower, int upper) {
+		for (int i = lower; i < upper; ++i) {
+			const PendingEntry &entry = entries[i];
+			size_t bytes = entry.header.words * sizeof(uint32_t);
+			if (entry.header.words == 0 || XXH3_64bits(entry.words, bytes) != entry.header.hash) {
+				continue;
+			}
+			blobs[i].resize(entry.header.words);
+			memcpy(blobs[i].data(), entry.words, bytes);
+		}
+	}, 0, (int)entries.size(), 32);
+	delete[] data;
+
+	int badCount = (int)(header.count - entries.size());
+	std::lock_guard<std::mutex> guard(lock_);
+	for (size_t i = 0; i < entries.size(); ++i) {
+		if (blobs[i].empty()) {
+			badCount++;
+			continue;
+		}
+		blobs_.emplace(entries[i].header.key, std::move(blobs[i]));
+	}
+	if (badCount != 0) {
+		// Write it out again without the bad ones.
+		WARN_LOG(G3D, "SPIR-V cache: dropped %d damaged entries", badCount);
+		dirty_ = true;
+	}
+	INFO_LOG(G3D, "SPIR-V cache: loaded %d shaders", (int)(entries.size() - badCount));
+	return true;
+}
+
+bool SpirvCache::Save(const Path &filename) {
+	std::lock_guard<std::mutex> guard(lock_);
+	if (!dirty_) {
+		return true;
+	}
+
+	FILE *f = File::OpenCFile(filename, "wb");
+	if (!f) {
+		return false;
+	}
+
+	SpirvCacheHeader header{};
+	header.magic = SPIRV_CACHE_MAGIC;
+	header.version = SPIRV_CACHE_VERSION;
+	header.compilerHash = CompilerHash();
+	header.count = (uint32_t)blobs_.size();
+	bool writeFailed = fwrite(&header, sizeof(header), 1, f) != 1;
+	for (const auto &it : blobs_) {
+		size_t bytes = it.second.size() * sizeof(uint32_t);
+		SpirvCacheEntryHeader entry{};
+		entry.key = it.first;
+		entry.hash = XXH3_64bits(it.second.data(), bytes);
+		entry.words = (uint32_t)it.second.size();
+		writeFailed = writeFailed || fwrite(&entry, sizeof(entry), 1, f) != 1;
+		writeFailed = writeFailed || fwrite(it.second.data(), bytes, 1, f) != 1;
+	}
+	fclose(f);
+
+	if (writeFailed) {
+		ERROR_LOG(G3D, "Failed to write SPIR-V cache, disk full?");
+		File::Delete(filename);
+		return false;
+	}
+	dirty_ = false;
+	NOTICE_LOG(G3D, "Saved %d shaders to the SPIR-V cache", (int)header.count);
+	return true;
+}
+
+void SpirvCache::Clear() {
+	std::lock_guard<std::mutex> guard(lock_);
+	blobs_.clear();
+	dirty_ = false;
+}
+
+size_t SpirvCache::size() {
+	std::lock_guard<std::mutex> guard(lock_);
+	return blobs_.size();
+}
@@ -0,0 +1,57 @@
+// Copyright (c) 2015- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/GPU/Vulkan/VulkanContext.h"
+
+class Path;
+
+// Content addressed cache of SPIR-V produced by GLSLtoSPV. The key is a hash of the GLSL source,
+// stage and variant, seeded with the compiler version, so entries can never go stale - at worst
+// they stop being looked up. The shader cache still only stores IDs and regenerates the GLSL on
+// startup, this just lets the glslang compile (by far the slowest part) be skipped.
+// Thread safe, shaders are compiled on worker threads.
+class SpirvCache {
+public:
+	static uint64_t MakeKey(VkShaderStageFlagBits stage, GLSLVariant variant, const char *source);
+
+	// Drop-in for GLSLtoSPV. On a hit, errorMessage is left alone, warnings were already shown.
+	bool Compile(VkShaderStageFlagBits stage, const char *source, GLSLVariant variant, std::vector<uint32_t> &spirv, std::string *errorMessage);
+
+	bool Lookup(uint64_t key, std::vector<uint32_t> *spirv);
+	void Insert(uint64_t key, const std::vector<uint32_t> &spirv);
+
+	// Adds the entries from the file to the cache. Entries are validated in parallel.
+	bool Load(const Path &filename);
+	// Does nothing if nothing was added since the last load or save.
+	bool Save(const Path &filename);
+
+	void Clear();
+	size_t size();
+
+private:
+	std::mutex lock_;
+	std::unordered_map<uint64_t, std::vector<uint32_t>> blobs_;
+	bool dirty_ = false;
+};
@@ -556,6 +556,11 @@ void GameSettingsScreen::CreateGraphicsSettings(UI::ViewGroup *graphicsSettings)
 		return !g_Config.bSoftwareRendering && !UsingHardwareTextureScaling();
 	});
 
+	CheckBox *texScalingDiskCache = graphicsSettings->Add(new CheckBox(&g_Config.bTexScalingDiskCache, gr->T("Cache upscaled textures on disk")));
+	texScalingDiskCache->SetEnabledFunc([]() {
+		return !g_Config.bSoftwareRendering && !UsingHardwareTextureScaling() && g_Config.iTexScalingLevel != 1;
+	});
+
 	ChoiceWithValueDisplay *textureShaderChoice = graphicsSettings->Add(new ChoiceWithValueDisplay(&g_Config.sTextureShaderName, gr->T("Texture Shader"), &TextureTranslateName));
 	textureShaderChoice->OnClick.Handle(this, &GameSettingsScreen::OnTextureShader);
 	textureShaderChoice->SetEnabledFunc([]() {
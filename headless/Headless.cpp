@@ -5,9 +5,16 @@
 // > --root pspautotests/tests/../ --compare --timeout=5 --graphics=software pspautotests/tests/cpu/cpu_alu/cpu_alu.prx
 
 #include "ppsspp_config.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <limits>
+#include <map>
+#include <mutex>
+#include <thread>
 #if PPSSPP_PLATFORM(ANDROID)
 #include <jni.h>
 #endif
@@ -21,12 +28,21 @@
 #include <timeapi.h>
 #else
 #include <csignal>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
 #endif
 #include "Common/CPUDetect.h"
+#include "Common/Data/Encoding/Utf8.h"
+#include "Common/Data/Format/JSONWriter.h"
 #include "Common/File/VFS/VFS.h"
 #include "Common/File/VFS/ZipFileReader.h"
 #include "Common/File/VFS/DirectoryReader.h"
 #include "Common/File/FileUtil.h"
+#include "Common/StringUtils.h"
 #include "Common/GraphicsContext.h"
 #include "Common/TimeUtil.h"
 #include "Common/Thread/ThreadManager.h"
@@ -36,10 +52,20 @@
 #include "Core/CoreTiming.h"
 #include "Core/System.h"
 #include "Core/WebServer.h"
+#include "Core/HLE/HLE.h"
+#include "Core/HLE/sceDisplay.h"
+#include "Core/HLE/sceKernel.h"
 #include "Core/HLE/sceUtility.h"
+#include "Core/MIPS/JitCommon/JitBlockCache.h"
+#include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/Host.h"
 #include "Core/SaveState.h"
 #include "GPU/Common/FramebufferManagerCommon.h"
+#include "GPU/GPU.h"
+#include "GPU/GPUState.h"
+#include "GPU/Debugger/GECommandTable.h"
+#include "GPU/Debugger/Playback.h"
+#include "ext/xxhash.h"
 #include "Log.h"
 #include "LogManager.h"
 
@@ -143,6 +169,10 @@ int printUsage(const char *progname, const char *reason)
 	fprintf(stderr, "  -j                    use jit (default)\n");
 	fprintf(stderr, "  -c, --compare         compare with output in file.expected\n");
 	fprintf(stderr, "  --bench               run multiple times and output speed\n");
+	fprintf(stderr, "  --bench-runs=N        number of times to run each test with --bench (default 100)\n");
+	fprintf(stderr, "  --jobs=N              run tests in N separate worker processes\n");
+	fprintf(stderr, "                        workers are killed after --timeout + 10 seconds (default 60)\n");
+	fprintf(stderr, "  --json=FILE           write a summary of test results (or --bench timings) to FILE\n");
 	fprintf(stderr, "\nSee headless.txt for details.\n");
 
 	return 1;
@@ -168,9 +198,144 @@ struct AutoTestOptions {
 	bool compare : 1;
 	bool verbose : 1;
 	bool bench : 1;
+	int benchRuns;
 };
 
-bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, const AutoTestOptions &opt) {
+// Totals across all --bench runs of a test. Times are in seconds.
+struct BenchStats {
+	int runs = 0;
+	double seconds = 0.0;
+	double jitCompileSeconds = 0.0;
+	int jitCompiledBlocks = 0;
+	double syscallSeconds = 0.0;
+	double displayListSeconds = 0.0;
+	double rasterizeSeconds = 0.0;
+	double audioMixSeconds = 0.0;
+	std::map<std::string, double> syscalls;
+
+	// Block cache state at the end of the last run.
+	int jitBlocks = 0;
+	float jitAvgBloat = 0.0f;
+	float jitMaxBloat = 0.0f;
+
+	// Only for GE dumps.
+	GPURecord::ReplayStats replay{};
+	uint64_t frameHash = 0;
+	bool frameHashStable = true;
+
+	// Must be called before PSP_Shutdown().
+	void Collect() {
+		runs++;
+		jitCompileSeconds += MIPSComp::compileStats.seconds;
+		jitCompiledBlocks += MIPSComp::compileStats.blocks;
+		syscallSeconds += kernelStats.msInSyscalls;
+		displayListSeconds += gpuStats.msProcessingDisplayLists;
+		rasterizeSeconds += gpuStats.msRasterizing;
+		audioMixSeconds += kernelStats.msMixingAudio;
+		for (const auto &it : kernelStats.summedMsInSyscalls)
+			syscalls[GetFuncName(it.first.first, it.first.second)] += it.second;
+
+		const GPURecord::ReplayStats &replayRun = GPURecord::GetReplayStats();
+		if (replayRun.runs != 0) {
+			replay.runs += replayRun.runs;
+			replay.seconds += replayRun.seconds;
+			for (size_t i = 0; i < ARRAY_SIZE(replay.commands); ++i) {
+				replay.commands[i].count += replayRun.commands[i].count;
+				replay.commands[i].seconds += replayRun.commands[i].seconds;
+			}
+
+			// Hash the displayed frame, so speedups can be checked for correctness too.
+			uint64_t hash = HashDisplayedFrame();
+			if (runs > 1 && hash != frameHash)
+				frameHashStable = false;
+			frameHash = hash;
+		}
+
+		std::lock_guard<std::recursive_mutex> guard(MIPSComp::jitLock);
+		JitBlockCacheDebugInterface *blockCache = MIPSComp::jit ? MIPSComp::jit->GetBlockCacheDebugInterface() : nullptr;
+		if (blockCache) {
+			BlockCacheStats bcStats{};
+			blockCache->ComputeStats(bcStats);
+			jitBlocks = bcStats.numBlocks;
+			jitAvgBloat = bcStats.numBlocks > 0 ? bcStats.avgBloat : 0.0f;
+			jitMaxBloat = bcStats.maxBloat;
+		}
+	}
+
+	static uint64_t HashDisplayedFrame() {
+		PSPPointer<u8> topaddr;
+		u32 linesize = 512;
+		u32 pixelFormat = GE_FORMAT_8888;
+		if (!__DisplayGetFramebuf(&topaddr, &linesize, &pixelFormat, 0) || !Memory::IsValidAddress(topaddr.ptr))
+			return 0;
+
+		u32 bpp = pixelFormat == GE_FORMAT_8888 ? 4 : 2;
+		u32 rowBytes = 480 * bpp;
+		if (!Memory::IsValidRange(topaddr.ptr, linesize * bpp * 271 + rowBytes))
+			return 0;
+
+		XXH3_state_t *state = XXH3_createState();
+		XXH3_64bits_reset(state);
+		for (int y = 0; y < 272; ++y)
+			XXH3_64bits_update(state, Memory::GetPointerUnchecked(topaddr.ptr + y * linesize * bpp), rowBytes);
+		uint64_t hash = XXH3_64bits_digest(state);
+		XXH3_freeState(state);
+		return hash;
+	}
+
+	void Write(json::JsonWriter &writer, const std::string &name) const {
+		double div = runs > 0 ? (double)runs : 1.0;
+		writer.pushDict();
+		writer.writeString("name", name);
+		writer.writeInt("runs", runs);
+		writer.writeFloat("seconds", seconds / div);
+		// Whatever isn't accounted for below is (mostly) emulated CPU execution.
+		// Display lists usually run inside syscalls, so they're not subtracted separately.
+		double accounted = jitCompileSeconds + syscallSeconds + audioMixSeconds;
+		writer.writeFloat("cpuExecuteSeconds", std::max(0.0, seconds - accounted) / div);
+		writer.writeFloat("jitCompileSeconds", jitCompileSeconds / div);
+		writer.writeInt("jitCompiledBlocks", (int)(jitCompiledBlocks / div));
+		writer.writeFloat("syscallSeconds", syscallSeconds / div);
+		writer.writeFloat("displayListSeconds", displayListSeconds / div);
+		writer.writeFloat("rasterizeSeconds", rasterizeSeconds / div);
+		writer.writeFloat("audioMixSeconds", audioMixSeconds / div);
+		writer.pushDict("blockCache");
+		writer.writeInt("blocks", jitBlocks);
+		writer.writeFloat("avgBloat", jitAvgBloat);
+		writer.writeFloat("maxBloat", jitMaxBloat);
+		writer.pop();
+		writer.pushDict("syscalls");
+		for (const auto &it : syscalls)
+			writer.writeFloat(it.first, it.second / div);
+		writer.pop();
+
+		if (replay.runs != 0) {
+			double replayDiv = (double)replay.runs;
+			writer.pushDict("replay");
+			writer.writeInt("runs", replay.runs);
+			writer.writeFloat("seconds", replay.seconds / replayDiv);
+			writer.writeString("frameHash", StringFromFormat("%016llx", (unsigned long long)frameHash));
+			writer.writeBool("frameHashStable", frameHashStable);
+
+			// Keyed by GE command name.
+			writer.pushDict("commands");
+			for (size_t i = 0; i < ARRAY_SIZE(replay.commands); ++i) {
+				const GPURecord::ReplayCommandStats &stats = replay.commands[i];
+				if (stats.count == 0)
+					continue;
+				writer.pushDict(GECmdInfoByCmd((GECommand)i).name);
+				writer.writeInt("count", (int)(stats.count / replayDiv));
+				writer.writeFloat("seconds", stats.seconds / replayDiv);
+				writer.pop();
+			}
+			writer.pop();
+			writer.pop();
+		}
+		writer.pop();
+	}
+};
+
+bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, const AutoTestOptions &opt, BenchStats *benchStats = nullptr) {
 	// Kinda ugly, trying to guesstimate the test name from filename...
 	currentTestName = GetTestName(coreParameter.fileToStart);
 
@@ -203,7 +368,7 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, const
 
 	host->BootDone();
 
-	Core_UpdateDebugStats(g_Config.bShowDebugStats || g_Config.bLogFrameDrops);
+	Core_UpdateDebugStats(g_Config.bShowDebugStats || g_Config.bLogFrameDrops || benchStats != nullptr);
 
 	PSP_BeginHostFrame();
 	Draw::DrawContext *draw = coreParameter.graphicsContext ? coreParameter.graphicsContext->GetDrawContext() : nullptr;
@@ -251,6 +416,9 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, const
 		draw->EndFrame();
 	}
 
+	if (benchStats)
+		benchStats->Collect();
+
 	PSP_Shutdown();
 
 	if (!opt.bench)
@@ -286,6 +454,263 @@ std::vector<std::string> ReadFromListFile(const std::string &listFilename) {
 	return testFilenames;
 }
 
+struct TestResult {
+	std::string filename;
+	std::string name;
+	bool passed = false;
+	bool timedOut = false;
+	int exitCode = 0;
+	double seconds = 0.0;
+};
+
+// Used when --timeout isn't given, a worker could otherwise stall the whole run.
+static const double DEFAULT_WORKER_TIMEOUT = 60.0;
+// Extra time on top of --timeout for the worker to start up and shut down.
+static const double WORKER_TIMEOUT_GRACE = 10.0;
+
+#if PPSSPP_PLATFORM(WINDOWS)
+static std::string QuoteArgument(const std::string &arg) {
+	std::string quoted = "\"";
+	for (char c : arg) {
+		if (c == '"')
+			quoted += '\\';
+		quoted += c;
+	}
+	quoted += "\"";
+	return quoted;
+}
+#endif
+
+// Runs a single test in a separate process, so a crash only affects that test.
+// A worker still running after timeout seconds is killed and the test fails.
+static TestResult RunTestInWorker(const std::string &exe, const std::vector<std::string> &workerArgs, const std::string &filename, double timeout, std::string *output) {
+	TestResult result;
+	result.filename = filename;
+	result.name = GetTestName(Path(filename));
+	result.exitCode = -1;
+
+	double st = time_now_d();
+#if PPSSPP_PLATFORM(WINDOWS)
+	std::string cmdline = QuoteArgument(exe);
+	for (const std::string &arg : workerArgs)
+		cmdline += " " + QuoteArgument(arg);
+	cmdline += " " + QuoteArgument(filename);
+
+	SECURITY_ATTRIBUTES sa{ sizeof(sa), nullptr, TRUE };
+	HANDLE readPipe, writePipe;
+	if (!CreatePipe(&readPipe, &writePipe, &sa, 0)) {
+		*output = StringFromFormat("Unable to start worker for %s\n", filename.c_str());
+		return result;
+	}
+	SetHandleInformation(readPipe, HANDLE_FLAG_INHERIT, 0);
+
+	STARTUPINFOW si{ sizeof(si) };
+	si.dwFlags = STARTF_USESTDHANDLES;
+	si.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+	si.hStdOutput = writePipe;
+	si.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+	PROCESS_INFORMATION pi{};
+	std::wstring wcmdline = ConvertUTF8ToWString(cmdline);
+	bool started = CreateProcessW(nullptr, &wcmdline[0], nullptr, nullptr, TRUE, 0, nullptr, nullptr, &si, &pi) != 0;
+	CloseHandle(writePipe);
+	if (!started) {
+		CloseHandle(readPipe);
+		*output = StringFromFormat("Unable to start worker for %s\n", filename.c_str());
+		return result;
+	}
+
+	// Read on a separate thread so a silent hang can still be timed out.
+	std::thread reader([&] {
+		char buf[4096];
+		DWORD bytes;
+		while (ReadFile(readPipe, buf, sizeof(buf), &bytes, nullptr) && bytes > 0)
+			output->append(buf, bytes);
+	});
+
+	DWORD waitMs = std::isinf(timeout) ? INFINITE : (DWORD)(timeout * 1000.0);
+	if (WaitForSingleObject(pi.hProcess, waitMs) == WAIT_TIMEOUT) {
+		result.timedOut = true;
+		TerminateProcess(pi.hProcess, 1);
+		WaitForSingleObject(pi.hProcess, INFINITE);
+	}
+	DWORD exitCode = 1;
+	GetExitCodeProcess(pi.hProcess, &exitCode);
+	result.exitCode = (int)exitCode;
+	CloseHandle(pi.hThread);
+	CloseHandle(pi.hProcess);
+	reader.join();
+	CloseHandle(readPipe);
+#else
+	std::vector<char *> argv;
+	argv.push_back(const_cast<char *>(exe.c_str()));
+	for (const std::string &arg : workerArgs)
+		argv.push_back(const_cast<char *>(arg.c_str()));
+	argv.push_back(const_cast<char *>(filename.c_str()));
+	argv.push_back(nullptr);
+
+	// Other workers spawn at the same time, and mustn't inherit this pipe or they'd hold it open.
+	int fds[2];
+	pid_t pid = -1;
+	bool piped;
+#if defined(__APPLE__)
+	static std::mutex pipeLock;
+	std::unique_lock<std::mutex> pipeGuard(pipeLock);
+	piped = pipe(fds) == 0;
+	if (piped) {
+		fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+		fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+	}
+#else
+	piped = pipe2(fds, O_CLOEXEC) == 0;
+#endif
+	if (piped) {
+		// The dup2'd stdout doesn't keep the close-on-exec flag.
+		posix_spawn_file_actions_t actions;
+		posix_spawn_file_actions_init(&actions);
+		posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+		if (posix_spawnp(&pid, argv[0], &actions, nullptr, &argv[0], environ) != 0)
+			pid = -1;
+		posix_spawn_file_actions_destroy(&actions);
+		close(fds[1]);
+		if (pid < 0)
+			close(fds[0]);
+	}
+#if defined(__APPLE__)
+	pipeGuard.unlock();
+#endif
+	if (pid < 0) {
+		*output = StringFromFormat("Unable to start worker for %s\n", filename.c_str());
+		return result;
+	}
+
+	// Read on a separate thread so a silent hang can still be timed out.
+	std::thread reader([&] {
+		char buf[4096];
+		ssize_t bytes;
+		while ((bytes = read(fds[0], buf, sizeof(buf))) != 0) {
+			if (bytes < 0 && errno == EINTR)
+				continue;
+			if (bytes < 0)
+				break;
+			output->append(buf, bytes);
+		}
+	});
+
+	double deadline = st + timeout;
+	int status = 0;
+	pid_t waited;
+	while ((waited = waitpid(pid, &status, WNOHANG)) == 0) {
+		if (time_now_d() > deadline) {
+			result.timedOut = true;
+			kill(pid, SIGKILL);
+			waited = waitpid(pid, &status, 0);
+			break;
+		}
+		sleep_ms(10);
+	}
+	reader.join();
+	close(fds[0]);
+
+	if (waited == pid && WIFEXITED(status))
+		result.exitCode = WEXITSTATUS(status);
+	else if (waited == pid && WIFSIGNALED(status))
+		result.exitCode = 128 + WTERMSIG(status);
+#endif
+	result.seconds = time_now_d() - st;
+	result.passed = result.exitCode == 0 && !result.timedOut;
+	if (result.timedOut)
+		*output += StringFromFormat("Worker for %s timed out after %.0f seconds\n", filename.c_str(), timeout);
+	return result;
+}
+
+static bool WriteJsonSummary(const std::string &filename, const std::vector<TestResult> &results, int jobs, double seconds) {
+	int passed = 0;
+	for (const TestResult &result : results) {
+		if (result.passed)
+			passed++;
+	}
+
+	json::JsonWriter writer(json::JsonWriter::PRETTY);
+	writer.begin();
+	writer.writeInt("jobs", jobs);
+	writer.writeFloat("seconds", seconds);
+	writer.writeInt("passed", passed);
+	writer.writeInt("failed", (int)results.size() - passed);
+	writer.pushArray("tests");
+	for (const TestResult &result : results) {
+		writer.pushDict();
+		writer.writeString("name", result.name);
+		writer.writeString("file", result.filename);
+		writer.writeBool("passed", result.passed);
+		writer.writeInt("exitCode", result.exitCode);
+		writer.writeBool("timedOut", result.timedOut);
+		writer.writeFloat("seconds", result.seconds);
+		writer.pop();
+	}
+	writer.pop();
+	writer.end();
+
+	FILE *fp = File::OpenCFile(Path(filename), "wb");
+	if (!fp) {
+		fprintf(stderr, "Unable to write results to '%s'\n", filename.c_str());
+		return false;
+	}
+	std::string json = writer.str();
+	fwrite(json.data(), 1, json.size(), fp);
+	fclose(fp);
+	return true;
+}
+
+static int RunParallelTests(const char *exe, const std::vector<std::string> &workerArgs, const std::vector<std::string> &testFilenames, int jobs, const AutoTestOptions &opt, const char *jsonFilename) {
+	std::vector<TestResult> results(testFilenames.size());
+	std::atomic<size_t> nextTest(0);
+	std::mutex outputLock;
+	double timeout = std::isinf(opt.timeout) ? DEFAULT_WORKER_TIMEOUT : opt.timeout + WORKER_TIMEOUT_GRACE;
+
+	double st = time_now_d();
+	auto worker = [&]() {
+		size_t i;
+		while ((i = nextTest++) < testFilenames.size()) {
+			std::string output;
+			results[i] = RunTestInWorker(exe, workerArgs, testFilenames[i], timeout, &output);
+
+			// Keep each test's output together, and only show details on failure unless verbose.
+			std::lock_guard<std::mutex> guard(outputLock);
+			if (!results[i].passed || opt.verbose || !opt.compare)
+				printf("%s", output.c_str());
+			if (opt.compare || !results[i].passed)
+				printf("  %s - %s (%.2f seconds)\n", results[i].name.c_str(), results[i].passed ? "passed!" : "failed", results[i].seconds);
+			fflush(stdout);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (int i = 0; i < jobs; ++i)
+		threads.emplace_back(worker);
+	for (auto &thread : threads)
+		thread.join();
+	double seconds = time_now_d() - st;
+
+	std::vector<std::string> failedTests;
+	for (const TestResult &result : results) {
+		if (!result.passed)
+			failedTests.push_back(result.name);
+	}
+
+	printf("%d tests passed, %d tests failed.\n", (int)(results.size() - failedTests.size()), (int)failedTests.size());
+	if (!failedTests.empty()) {
+		printf("Failed tests:\n");
+		for (const std::string &name : failedTests)
+			printf("  %s\n", name.c_str());
+	}
+
+	if (jsonFilename && !WriteJsonSummary(jsonFilename, results, jobs, seconds))
+		return 1;
+	if (!failedTests.empty() && !teamCityMode)
+		return 1;
+	return 0;
+}
+
 int main(int argc, const char* argv[])
 {
 	PROFILE_INIT();
@@ -304,6 +729,7 @@ int main(int argc, const char* argv[])
 
 	AutoTestOptions testOptions{};
 	testOptions.timeout = std::numeric_limits<double>::infinity();
+	testOptions.benchRuns = 100;
 	bool fullLog = false;
 	const char *stateToLoad = 0;
 	GPUCore gpuCore = GPUCORE_SOFTWARE;
@@ -314,10 +740,33 @@ int main(int argc, const char* argv[])
 	const char *mountIso = nullptr;
 	const char *mountRoot = nullptr;
 	const char *screenshotFilename = nullptr;
+	const char *jsonFilename = nullptr;
+	int jobs = 1;
+	// Set for the processes started by --jobs, the parent reports the results.
+	bool workerMode = false;
+	// Options forwarded as-is to worker processes when using --jobs.
+	std::vector<std::string> workerArgs = { "--worker" };
 
 	for (int i = 1; i < argc; i++)
 	{
-		if (!strcmp(argv[i], "-m") || !strcmp(argv[i], "--mount"))
+		int argStart = i;
+		bool forwardArg = true;
+		if (!strncmp(argv[i], "--jobs=", strlen("--jobs=")) && strlen(argv[i]) > strlen("--jobs="))
+		{
+			jobs = std::max(1, (int)strtol(argv[i] + strlen("--jobs="), nullptr, 10));
+			forwardArg = false;
+		}
+		else if (!strcmp(argv[i], "--worker"))
+		{
+			workerMode = true;
+			forwardArg = false;
+		}
+		else if (!strncmp(argv[i], "--json=", strlen("--json=")) && strlen(argv[i]) > strlen("--json="))
+		{
+			jsonFilename = argv[i] + strlen("--json=");
+			forwardArg = false;
+		}
+		else if (!strcmp(argv[i], "-m") || !strcmp(argv[i], "--mount"))
 		{
 			if (++i >= argc)
 				return printUsage(argv[0], "Missing argument after -m");
@@ -341,6 +790,8 @@ int main(int argc, const char* argv[])
 			testOptions.compare = true;
 		else if (!strcmp(argv[i], "--bench"))
 			testOptions.bench = true;
+		else if (!strncmp(argv[i], "--bench-runs=", strlen("--bench-runs=")) && strlen(argv[i]) > strlen("--bench-runs="))
+			testOptions.benchRuns = std::max(1, (int)strtol(argv[i] + strlen("--bench-runs="), nullptr, 10));
 		else if (!strcmp(argv[i], "-v") || !strcmp(argv[i], "--verbose"))
 			testOptions.verbose = true;
 		else if (!strncmp(argv[i], "--graphics=", strlen("--graphics=")) && strlen(argv[i]) > strlen("--graphics="))
@@ -376,13 +827,25 @@ int main(int argc, const char* argv[])
 		else if (!strncmp(argv[i], "--debugger=", strlen("--debugger=")) && strlen(argv[i]) > strlen("--debugger="))
 			debuggerPort = (int)strtoul(argv[i] + strlen("--debugger="), NULL, 10);
 		else if (!strcmp(argv[i], "--teamcity"))
+		{
+			// Workers must still fail on failed tests, the parent reports them.
 			teamCityMode = true;
+			forwardArg = false;
+		}
 		else if (!strncmp(argv[i], "--state=", strlen("--state=")) && strlen(argv[i]) > strlen("--state="))
 			stateToLoad = argv[i] + strlen("--state=");
 		else if (!strcmp(argv[i], "--help") || !strcmp(argv[i], "-h"))
 			return printUsage(argv[0], NULL);
 		else
+		{
 			testFilenames.push_back(argv[i]);
+			forwardArg = false;
+		}
+
+		if (forwardArg) {
+			for (int j = argStart; j <= i; ++j)
+				workerArgs.push_back(argv[j]);
+		}
 	}
 
 	if (testFilenames.size() == 1 && testFilenames[0][0] == '@')
@@ -391,6 +854,12 @@ int main(int argc, const char* argv[])
 	if (testFilenames.empty())
 		return printUsage(argv[0], argc <= 1 ? NULL : "No executables specified");
 
+	if (jobs > 1 || (jsonFilename && !testOptions.bench)) {
+		if (testOptions.bench || debuggerPort > 0)
+			return printUsage(argv[0], "--jobs can't be used with --bench or --debugger");
+		return RunParallelTests(argv[0], workerArgs, testFilenames, std::min(jobs, (int)testFilenames.size()), testOptions, jsonFilename);
+	}
+
 	LogManager::Init(&g_Config.bEnableLogging);
 	LogManager *logman = LogManager::GetInstance();
 
@@ -528,6 +997,11 @@ int main(int argc, const char* argv[])
 
 	std::vector<std::string> failedTests;
 	std::vector<std::string> passedTests;
+	json::JsonWriter benchWriter(json::JsonWriter::PRETTY);
+	if (testOptions.bench) {
+		benchWriter.begin();
+		benchWriter.pushArray("tests");
+	}
 	for (size_t i = 0; i < testFilenames.size(); ++i)
 	{
 		coreParameter.fileToStart = Path(testFilenames[i]);
@@ -535,33 +1009,35 @@ int main(int argc, const char* argv[])
 			printf("%s:\n", coreParameter.fileToStart.c_str());
 		bool passed = RunAutoTest(headlessHost, coreParameter, testOptions);
 		if (testOptions.bench) {
+			BenchStats stats;
 			double st = time_now_d();
 			double deadline = st + testOptions.timeout;
-			double runs = 0.0;
-			for (int i = 0; i < 100; ++i) {
-				RunAutoTest(headlessHost, coreParameter, testOptions);
-				runs++;
+			for (int i = 0; i < testOptions.benchRuns; ++i) {
+				double runStart = time_now_d();
+				RunAutoTest(headlessHost, coreParameter, testOptions, &stats);
+				stats.seconds += time_now_d() - runStart;
 
 				if (time_now_d() > deadline)
 					break;
 			}
-			double et = time_now_d();
 
 			std::string testName = GetTestName(coreParameter.fileToStart);
-			printf("  %s - %f seconds average\n", testName.c_str(), (et - st) / runs);
+			printf("  %s - %f seconds average\n", testName.c_str(), stats.seconds / stats.runs);
+			stats.Write(benchWriter, testName);
 		}
 		if (testOptions.compare) {
 			std::string testName = GetTestName(coreParameter.fileToStart);
 			if (passed) {
 				passedTests.push_back(testName);
-				printf("  %s - passed!\n", testName.c_str());
+				if (!workerMode)
+					printf("  %s - passed!\n", testName.c_str());
 			}
 			else
 				failedTests.push_back(testName);
 		}
 	}
 
-	if (testOptions.compare) {
+	if (testOptions.compare && !workerMode) {
 		printf("%d tests passed, %d tests failed.\n", (int)passedTests.size(), (int)failedTests.size());
 		if (!failedTests.empty())
 		{
@@ -572,6 +1048,20 @@ int main(int argc, const char* argv[])
 		}
 	}
 
+	if (testOptions.bench && jsonFilename) {
+		benchWriter.pop();
+		benchWriter.end();
+
+		FILE *fp = File::OpenCFile(Path(std::string(jsonFilename)), "wb");
+		if (fp) {
+			std::string json = benchWriter.str();
+			fwrite(json.data(), 1, json.size(), fp);
+			fclose(fp);
+		} else {
+			fprintf(stderr, "Unable to write benchmark results to '%s'\n", jsonFilename);
+		}
+	}
+
 	if (debuggerPort > 0) {
 		ShutdownWebServer();
 	}
@@ -0,0 +1,236 @@
+#include <cstdio>
+#include <vector>
+
+#include "Common/Common.h"
+#include "Common/CommonTypes.h"
+#include "Common/Data/Random/Rng.h"
+#include "Core/Util/BlockAllocator.h"
+
+#include "UnitTest.h"
+
+// Straight linear first fit over an address ordered list, like BlockAllocator used to be.
+// The indexed allocator must pick exactly the same blocks.
+class ReferenceAllocator {
+public:
+	ReferenceAllocator(u32 grain) : grain_(grain) {}
+
+	void Init(u32 rangeStart, u32 rangeSize) {
+		rangeSize_ = rangeSize;
+		blocks_.clear();
+		blocks_.push_back({ rangeStart, rangeSize, false });
+	}
+
+	u32 AllocAligned(u32 &size, u32 sizeGrain, u32 grain, bool fromTop) {
+		if (size == 0 || size > rangeSize_)
+			return -1;
+		if (grain < grain_)
+			grain = grain_;
+		if (sizeGrain < grain_)
+			sizeGrain = grain_;
+		size = (size + sizeGrain - 1) & ~(sizeGrain - 1);
+
+		for (size_t n = 0; n < blocks_.size(); ++n) {
+			size_t i = fromTop ? blocks_.size() - 1 - n : n;
+			const Block &b = blocks_[i];
+			u32 offset;
+			if (fromTop) {
+				offset = (b.start + b.size - size) % grain;
+			} else {
+				offset = b.start % grain;
+				if (offset != 0)
+					offset = grain - offset;
+			}
+			u32 needed = offset + size;
+			if (b.taken || b.size < needed)
+				continue;
+
+			if (!fromTop) {
+				if (b.size != needed)
+					i = SplitAfter(i, b.size - needed);
+				if (offset >= grain_)
+					i = SplitBefore(i, offset);
+			} else {
+				if (b.size != needed)
+					i = SplitBefore(i, b.size - needed);
+				if (offset >= grain_)
+					i = SplitAfter(i, offset);
+			}
+			blocks_[i].taken = true;
+			return blocks_[i].start;
+		}
+		return -1;
+	}
+
+	u32 AllocAt(u32 position, u32 size) {
+		if (size > rangeSize_)
+			return -1;
+		u32 alignedPosition = position & ~(grain_ - 1);
+		u32 alignedSize = size + (position - alignedPosition);
+		alignedSize = (alignedSize + grain_ - 1) & ~(grain_ - 1);
+
+		int i = Find(alignedPosition);
+		if (i < 0 || blocks_[i].taken || blocks_[i].start + blocks_[i].size < alignedPosition + alignedSize)
+			return -1;
+		if (blocks_[i].start != alignedPosition)
+			i = SplitBefore(i, alignedPosition - blocks_[i].start);
+		if (blocks_[i].size != alignedSize)
+			i = SplitAfter(i, blocks_[i].size - alignedSize);
+		blocks_[i].taken = true;
+		return position;
+	}
+
+	bool Free(u32 position, bool exact) {
+		int i = Find(position);
+		if (i < 0 || !blocks_[i].taken || (exact && blocks_[i].start != position))
+			return false;
+		blocks_[i].taken = false;
+		while (i > 0 && !blocks_[i - 1].taken) {
+			blocks_[i - 1].size += blocks_[i].size;
+			blocks_.erase(blocks_.begin() + i);
+			--i;
+		}
+		while (i + 1 < (int)blocks_.size() && !blocks_[i + 1].taken) {
+			blocks_[i].size += blocks_[i + 1].size;
+			blocks_.erase(blocks_.begin() + i + 1);
+		}
+		return true;
+	}
+
+	u32 GetBlockStartFromAddress(u32 addr) const {
+		int i = Find(addr);
+		return i < 0 ? -1 : blocks_[i].start;
+	}
+
+	u32 GetBlockSizeFromAddress(u32 addr) const {
+		int i = Find(addr);
+		return i < 0 ? -1 : blocks_[i].size;
+	}
+
+	bool IsBlockFree(u32 addr) const {
+		int i = Find(addr);
+		return i >= 0 && !blocks_[i].taken;
+	}
+
+	u32 GetLargestFreeBlockSize() const {
+		u32 largest = 0;
+		for (const Block &b : blocks_) {
+			if (!b.taken && b.size > largest)
+				largest = b.size;
+		}
+		return largest;
+	}
+
+	u32 GetTotalFreeBytes() const {
+		u32 sum = 0;
+		for (const Block &b : blocks_) {
+			if (!b.taken)
+				sum += b.size;
+		}
+		return sum;
+	}
+
+	// Start of a random taken block, or -1.
+	u32 RandomTaken(GMRng &rng) const {
+		std::vector<u32> taken;
+		for (const Block &b : blocks_) {
+			if (b.taken)
+				taken.push_back(b.start);
+		}
+		return taken.empty() ? -1 : taken[rng.R32() % taken.size()];
+	}
+
+private:
+	struct Block {
+		u32 start;
+		u32 size;
+		bool taken;
+	};
+
+	int Find(u32 addr) const {
+		for (size_t i = 0; i < blocks_.size(); ++i) {
+			if (blocks_[i].start <= addr && blocks_[i].start + blocks_[i].size > addr)
+				return (int)i;
+		}
+		return -1;
+	}
+
+	// Both return the new index of the block that was split.
+	size_t SplitBefore(size_t i, u32 size) {
+		Block inserted{ blocks_[i].start, size, false };
+		blocks_[i].start += size;
+		blocks_[i].size -= size;
+		blocks_.insert(blocks_.begin() + i, inserted);
+		return i + 1;
+	}
+
+	size_t SplitAfter(size_t i, u32 size) {
+		Block inserted{ blocks_[i].start + blocks_[i].size - size, size, false };
+		blocks_[i].size -= size;
+		blocks_.insert(blocks_.begin() + i + 1, inserted);
+		return i;
+	}
+
+	std::vector<Block> blocks_;
+	u32 rangeSize_ = 0;
+	u32 grain_;
+};
+
+bool TestBlockAllocator() {
+	static const u32 rangeStart = 0x08800000;
+	static const u32 rangeSize = 0x01800000;
+	static const u32 grain = 256;
+	static const u32 alignments[] = { 0, 0x100, 0x1000, 0x10000, 0x300, 0x12345 };
+
+	GMRng rng;
+	for (int round = 0; round < 8; ++round) {
+		BlockAllocator alloc(grain);
+		ReferenceAllocator ref(grain);
+		alloc.Init(rangeStart, rangeSize, false);
+		ref.Init(rangeStart, rangeSize);
+
+		for (int step = 0; step < 4000; ++step) {
+			u32 op = rng.R32() % 8;
+			if (op < 4) {
+				// Mostly small allocations, some large ones to exhaust the range.
+				u32 size = (rng.R32() & 7) == 0 ? rng.R32() % (rangeSize / 4) : rng.R32() % 0x8000 + 1;
+				u32 sizeGrain = alignments[rng.R32() % ARRAY_SIZE(alignments)];
+				u32 align = alignments[rng.R32() % ARRAY_SIZE(alignments)];
+				bool fromTop = (rng.R32() & 1) != 0;
+				u32 size1 = size;
+				u32 size2 = size;
+				// The EXPECT macros evaluate their arguments again on failure, so no calls inside.
+				u32 result = alloc.AllocAligned(size1, sizeGrain, align, fromTop);
+				u32 expected = ref.AllocAligned(size2, sizeGrain, align, fromTop);
+				EXPECT_EQ_HEX(result, expected);
+				EXPECT_EQ_HEX(size1, size2);
+			} else if (op == 4) {
+				u32 position = rangeStart + rng.R32() % rangeSize;
+				u32 size = rng.R32() % 0x4000;
+				u32 result = alloc.AllocAt(position, size);
+				u32 expected = ref.AllocAt(position, size);
+				EXPECT_EQ_HEX(result, expected);
+			} else {
+				u32 position = ref.RandomTaken(rng);
+				// Sometimes free from the middle of a block, or somewhere that isn't taken.
+				if ((rng.R32() & 3) == 0)
+					position = rangeStart + rng.R32() % rangeSize;
+				else if (position != (u32)-1 && (rng.R32() & 3) == 0)
+					position += alloc.GetBlockSizeFromAddress(position) / 2;
+				bool exact = (rng.R32() & 1) != 0;
+				bool freed = exact ? alloc.FreeExact(position) : alloc.Free(position);
+				bool expected = ref.Free(position, exact);
+				EXPECT_EQ_INT(freed, expected);
+			}
+
+			for (int probe = 0; probe < 4; ++probe) {
+				u32 addr = rangeStart - 0x100 + rng.R32() % (rangeSize + 0x200);
+				EXPECT_EQ_HEX(alloc.GetBlockStartFromAddress(addr), ref.GetBlockStartFromAddress(addr));
+				EXPECT_EQ_HEX(alloc.GetBlockSizeFromAddress(addr), ref.GetBlockSizeFromAddress(addr));
+				EXPECT_EQ_INT(alloc.IsBlockFree(addr), ref.IsBlockFree(addr));
+			}
+			EXPECT_EQ_HEX(alloc.GetLargestFreeBlockSize(), ref.GetLargestFreeBlockSize());
+			EXPECT_EQ_HEX(alloc.GetTotalFreeBytes(), ref.GetTotalFreeBytes());
+		}
+	}
+	return true;
+}
@@ -166,6 +166,65 @@ static const IRVerification tests[] = {
 		},
 		{ &PropagateConstants },
 	},
+	{
+		"DeadFPUStores",
+		{
+			{ IROp::FAdd, { 0 }, 1, 2 },
+			{ IROp::Mult, { 0 }, MIPS_REG_A0, MIPS_REG_A1 },
+			{ IROp::FMul, { 0 }, 3, 4 },
+			{ IROp::MtLo, { 0 }, MIPS_REG_A2 },
+			{ IROp::MtHi, { 0 }, MIPS_REG_A3 },
+		},
+		{
+			{ IROp::FMul, { 0 }, 3, 4 },
+			{ IROp::MtLo, { 0 }, MIPS_REG_A2 },
+			{ IROp::MtHi, { 0 }, MIPS_REG_A3 },
+		},
+		{ &RemoveDeadStores },
+	},
+	{
+		"DeadStoresKeepLive",
+		{
+			// Read by the exit.
+			{ IROp::FMov, { 0 }, 1 },
+			{ IROp::ExitToConstIfEq, { 0 }, MIPS_REG_A0, MIPS_REG_A1, 0 },
+			{ IROp::FMov, { 0 }, 2 },
+			// Only partly overwritten.
+			{ IROp::Vec4Mov, { 32 }, 36 },
+			{ IROp::FMov, { 33 }, 0 },
+			// Accumulates.
+			{ IROp::Mult, { 0 }, MIPS_REG_A0, MIPS_REG_A1 },
+			{ IROp::Madd, { 0 }, MIPS_REG_A2, MIPS_REG_A3 },
+		},
+		{
+			{ IROp::FMov, { 0 }, 1 },
+			{ IROp::ExitToConstIfEq, { 0 }, MIPS_REG_A0, MIPS_REG_A1, 0 },
+			{ IROp::FMov, { 0 }, 2 },
+			{ IROp::Vec4Mov, { 32 }, 36 },
+			{ IROp::FMov, { 33 }, 0 },
+			{ IROp::Mult, { 0 }, MIPS_REG_A0, MIPS_REG_A1 },
+			{ IROp::Madd, { 0 }, MIPS_REG_A2, MIPS_REG_A3 },
+		},
+		{ &RemoveDeadStores },
+	},
+	{
+		"DeadStoresPackOneWord",
+		{
+			// The 16-bit packs only write their first dest word.
+			{ IROp::FMov, { 40 }, 1 },
+			{ IROp::FMov, { 41 }, 2 },
+			{ IROp::Vec2Pack32To16, { 40 }, 32 },
+			{ IROp::FMov, { 43 }, 3 },
+			{ IROp::Vec2Pack31To16, { 42 }, 36 },
+		},
+		{
+			{ IROp::FMov, { 41 }, 2 },
+			{ IROp::Vec2Pack32To16, { 40 }, 32 },
+			{ IROp::FMov, { 43 }, 3 },
+			{ IROp::Vec2Pack31To16, { 42 }, 36 },
+		},
+		{ &RemoveDeadStores },
+	},
 };
 
 bool TestIRPassSimplify() {
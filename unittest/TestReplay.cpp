@@ -0,0 +1,82 @@
+#include <cstdint>
+#include <cstring>
+
+#include "Common/File/FileUtil.h"
+#include "Common/File/Path.h"
+#include "Core/Replay.h"
+
+#include "UnitTest.h"
+
+static uint32_t ApplyButtons(uint64_t t) {
+	uint32_t buttons = 0;
+	uint8_t analog[2][2]{};
+	ReplayApplyCtrl(buttons, analog, t);
+	return buttons;
+}
+
+static void RecordButtons(uint32_t buttons, uint64_t t) {
+	uint8_t analog[2][2]{};
+	ReplayApplyCtrl(buttons, analog, t);
+}
+
+bool TestReplay() {
+	// Failed checks return early, this still cleans up after them.
+	struct Cleanup {
+		Path path;
+		uint8_t *data = nullptr;
+		~Cleanup() {
+			ReplayAbort();
+			delete[] data;
+			File::Delete(path);
+		}
+	} cleanup{ File::GetTempDir() / "ppsspp_replay_test.ppr" };
+	const Path &path = cleanup.path;
+
+	// Two plain chunks with a keyframe between them at t=350.
+	ReplayAbort();
+	EXPECT_TRUE(ReplayBeginSave());
+	RecordButtons(1, 100);
+	RecordButtons(2, 200);
+	EXPECT_TRUE(ReplayFlushFile(path));
+	RecordButtons(4, 300);
+	EXPECT_TRUE(ReplayFlushFileKeyframe(path, Path("keyframe.ppst"), 350));
+	RecordButtons(8, 400);
+	EXPECT_TRUE(ReplayFlushFile(path));
+	ReplayAbort();
+
+	Path keyframeState;
+	EXPECT_FALSE(ReplaySeek(0, &keyframeState));
+	EXPECT_TRUE(ReplayExecuteFile(path));
+	EXPECT_EQ_INT(ApplyButtons(250), 2);
+
+	// Forward to the keyframe, ctrl state comes from the keyframe until the next event.
+	EXPECT_TRUE(ReplaySeek(360, &keyframeState));
+	EXPECT_TRUE(keyframeState == Path("keyframe.ppst"));
+	EXPECT_EQ_INT(ApplyButtons(360), 4);
+	EXPECT_TRUE(ReplayHasMoreEvents());
+	EXPECT_EQ_INT(ApplyButtons(400), 8);
+	EXPECT_FALSE(ReplayHasMoreEvents());
+
+	// Back before the keyframe starts over.
+	EXPECT_TRUE(ReplaySeek(260, &keyframeState));
+	EXPECT_TRUE(keyframeState.empty());
+	EXPECT_TRUE(ReplayHasMoreEvents());
+	EXPECT_EQ_INT(ApplyButtons(150), 1);
+	ReplayAbort();
+
+	// Give the second item of the first chunk oversized side data, so only one item decodes.
+	// File header is 32 bytes, plain chunk header 36, item header 17.
+	const size_t corruptAction = 32 + 36 + 17;
+	size_t fileSize = 0;
+	cleanup.data = File::ReadLocalFile(path, &fileSize);
+	EXPECT_TRUE(cleanup.data != nullptr && fileSize > corruptAction);
+	EXPECT_EQ_INT(cleanup.data[corruptAction], 0x00);
+	cleanup.data[corruptAction] = 0xC2;
+	EXPECT_TRUE(File::WriteDataToFile(false, cleanup.data, (unsigned int)fileSize, path));
+
+	EXPECT_TRUE(ReplayExecuteFile(path));
+	EXPECT_TRUE(ReplayHasMoreEvents());
+	EXPECT_EQ_INT(ApplyButtons(1000), 1);
+	EXPECT_FALSE(ReplayHasMoreEvents());
+	return true;
+}
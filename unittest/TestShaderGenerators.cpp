@@ -1,6 +1,8 @@
 #include "ppsspp_config.h"
 #include <algorithm>
 
+#include "Common/File/FileUtil.h"
+#include "Common/File/Path.h"
 #include "Common/StringUtils.h"
 
 #include "GPU/Common/ShaderId.h"
@@ -16,6 +18,7 @@
 #include "GPU/Common/ReinterpretFramebuffer.h"
 #include "GPU/Common/StencilCommon.h"
 #include "GPU/Common/DepalettizeShaderCommon.h"
+#include "GPU/Vulkan/SpirvCache.h"
 
 #if PPSSPP_PLATFORM(WINDOWS)
 #include "GPU/D3D11/D3D11Util.h"
@@ -25,6 +28,8 @@
 #include "GPU/D3D9/D3D9ShaderCompiler.h"
 #endif
 
+#include "UnitTest.h"
+
 static constexpr size_t CODE_BUFFER_SIZE = 32768;
 
 bool GenerateFShader(FShaderID id, char *buffer, ShaderLanguage lang, Draw::Bugs bugs, std::string *errorString) {
@@ -617,6 +622,81 @@ bool TestGeometryShaders() {
 	return true;
 }
 
+// Cached SPIR-V must be exactly what glslang produces, also after a save and load.
+bool TestSpirvCache() {
+	char *buffer = new char[65536];
+	GMRng rng;
+	Draw::Bugs bugs;
+
+	std::vector<std::string> sources;
+	std::vector<std::vector<uint32_t>> expected;
+	for (int i = 0; i < 100 && sources.size() < 10; i++) {
+		FShaderID id;
+		id.d[0] = rng.R32();
+		id.d[1] = rng.R32();
+		id.SetBit(FS_BIT_NO_DEPTH_CANNOT_DISCARD_STENCIL, false);
+
+		std::string errorString;
+		std::vector<uint32_t> spirv;
+		if (!GenerateFShader(id, buffer, ShaderLanguage::GLSL_VULKAN, bugs, &errorString))
+			continue;
+		if (!GLSLtoSPV(VK_SHADER_STAGE_FRAGMENT_BIT, buffer, GLSLVariant::VULKAN, spirv, &errorString))
+			continue;
+		sources.push_back(buffer);
+		expected.push_back(spirv);
+	}
+	delete[] buffer;
+	EXPECT_FALSE(sources.empty());
+
+	const char *src = sources[0].c_str();
+	EXPECT_TRUE(SpirvCache::MakeKey(VK_SHADER_STAGE_FRAGMENT_BIT, GLSLVariant::VULKAN, src) != SpirvCache::MakeKey(VK_SHADER_STAGE_VERTEX_BIT, GLSLVariant::VULKAN, src));
+	EXPECT_TRUE(SpirvCache::MakeKey(VK_SHADER_STAGE_FRAGMENT_BIT, GLSLVariant::VULKAN, src) != SpirvCache::MakeKey(VK_SHADER_STAGE_FRAGMENT_BIT, GLSLVariant::GLES300, src));
+
+	SpirvCache cache;
+	for (size_t i = 0; i < sources.size(); i++) {
+		std::vector<uint32_t> spirv;
+		std::string errorMessage;
+		// Second time around is a hit.
+		for (int pass = 0; pass < 2; pass++) {
+			EXPECT_TRUE(cache.Compile(VK_SHADER_STAGE_FRAGMENT_BIT, sources[i].c_str(), GLSLVariant::VULKAN, spirv, &errorMessage));
+			EXPECT_TRUE(spirv == expected[i]);
+		}
+	}
+	size_t count = cache.size();
+	EXPECT_TRUE(count != 0 && count <= sources.size());
+
+	// Failed checks return early, this still cleans up after them.
+	struct Cleanup {
+		Path path;
+		uint8_t *data = nullptr;
+		~Cleanup() {
+			delete[] data;
+			File::Delete(path);
+		}
+	} cleanup{ File::GetTempDir() / "ppsspp_spirvcache_test.bin" };
+	const Path &path = cleanup.path;
+	EXPECT_TRUE(cache.Save(path));
+	SpirvCache loaded;
+	EXPECT_TRUE(loaded.Load(path));
+	EXPECT_EQ_INT((int)loaded.size(), (int)count);
+	for (size_t i = 0; i < sources.size(); i++) {
+		std::vector<uint32_t> spirv;
+		EXPECT_TRUE(loaded.Lookup(SpirvCache::MakeKey(VK_SHADER_STAGE_FRAGMENT_BIT, GLSLVariant::VULKAN, sources[i].c_str()), &spirv));
+		EXPECT_TRUE(spirv == expected[i]);
+	}
+
+	// Damage the last entry, only it should be dropped.
+	size_t fileSize = 0;
+	cleanup.data = File::ReadLocalFile(path, &fileSize);
+	EXPECT_TRUE(cleanup.data != nullptr);
+	cleanup.data[fileSize - 1] ^= 0xFF;
+	EXPECT_TRUE(File::WriteDataToFile(false, cleanup.data, (unsigned int)fileSize, path));
+	SpirvCache damaged;
+	EXPECT_TRUE(damaged.Load(path));
+	EXPECT_EQ_INT((int)damaged.size(), (int)count - 1);
+	return true;
+}
+
 
 bool TestShaderGenerators() {
 #if PPSSPP_PLATFORM(WINDOWS)
@@ -651,5 +731,9 @@ bool TestShaderGenerators() {
 		return false;
 	}
 
+	if (!TestSpirvCache()) {
+		return false;
+	}
+
 	return true;
 } 
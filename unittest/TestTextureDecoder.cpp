@@ -0,0 +1,144 @@
+#include <cstdio>
+#include <cstring>
+
+#include "ppsspp_config.h"
+#include "Common/Common.h"
+#include "Common/CommonTypes.h"
+#include "Common/CPUDetect.h"
+#include "Common/Data/Random/Rng.h"
+#include "GPU/GPUState.h"
+#include "GPU/Common/TextureDecoder.h"
+
+#include "UnitTest.h"
+
+// Straightforward per-texel versions, the SIMD paths must match these exactly.
+template <typename ClutT>
+static void DeIndexTexture4Reference(ClutT *dest, const u8 *indexed, int length, const ClutT *clut, u32 *outAlphaSum) {
+	ClutT alphaSum = (ClutT)-1;
+	for (int i = 0; i < length; ++i) {
+		ClutT color = clut[(indexed[i / 2] >> ((i & 1) * 4)) & 0xF];
+		dest[i] = color;
+		alphaSum &= color;
+	}
+	*outAlphaSum &= (u32)alphaSum;
+}
+
+template <typename ClutT>
+static bool TestDeIndexTexture4(GMRng &rng, bool opaque) {
+	u8 indexed[512];
+	ClutT clut[16];
+	ClutT dest[1024 + 1];
+	ClutT expected[1024 + 1];
+	const ClutT opaqueMask = sizeof(ClutT) == 4 ? (ClutT)0xFF000000 : (ClutT)0xF000;
+
+	for (u8 &b : indexed)
+		b = (u8)rng.R32();
+	for (ClutT &c : clut)
+		c = (ClutT)rng.R32() | (opaque ? opaqueMask : 0);
+
+	// Odd lengths and offsets exercise the scalar tail and unaligned loads.
+	int length = rng.R32() % 1024 + 1;
+	int offset = rng.R32() & 1;
+	// Guard value, to catch writes past the end.
+	dest[offset + length] = 0x1234;
+	u32 alphaSum = 0xFFFFFFFF;
+	u32 expectedAlphaSum = 0xFFFFFFFF;
+	DeIndexTexture4(dest + offset, indexed + offset, length, clut, &alphaSum);
+	DeIndexTexture4Reference(expected + offset, indexed + offset, length, clut, &expectedAlphaSum);
+
+	for (int i = 0; i < length; ++i) {
+		if (dest[offset + i] != expected[offset + i]) {
+			printf("DeIndexTexture4<%d>: texel %d of %d: %08x vs %08x\n", (int)sizeof(ClutT), i, length, (u32)dest[offset + i], (u32)expected[offset + i]);
+			return false;
+		}
+	}
+	EXPECT_EQ_HEX(dest[offset + length], (ClutT)0x1234);
+	EXPECT_EQ_HEX(alphaSum, expectedAlphaSum);
+	return true;
+}
+
+static void RandomDXT1Block(GMRng &rng, DXT1Block *block) {
+	for (u8 &line : block->lines)
+		line = (u8)rng.R32();
+	block->color1 = (u16)rng.R32();
+	block->color2 = (u16)rng.R32();
+	// Cover both the 4 color and the 3 color + transparent modes.
+	if ((rng.R32() & 3) == 0)
+		block->color2 = block->color1;
+}
+
+static bool TestDXTBlocks(GMRng &rng) {
+	// Decode into a wider buffer than the block, so a wrong pitch shows.
+	static const int pitch = 8;
+	u32 out[4 * pitch];
+
+	DXT1Block dxt1;
+	RandomDXT1Block(rng, &dxt1);
+	int w = (rng.R32() & 3) == 0 ? rng.R32() % 4 + 1 : 4;
+	int h = (rng.R32() & 3) == 0 ? rng.R32() % 4 + 1 : 4;
+	u32 alpha = 1;
+	u32 expectedAlpha = 1;
+	DecodeDXT1Block(out, &dxt1, pitch, w, h, &alpha);
+	for (int y = 0; y < h; ++y) {
+		for (int x = 0; x < w; ++x) {
+			u32 texel = GetDXT1Texel(&dxt1, x, y);
+			EXPECT_EQ_HEX(out[y * pitch + x], texel);
+			if ((texel >> 24) != 0xFF)
+				expectedAlpha = 0;
+		}
+	}
+	EXPECT_EQ_HEX(alpha, expectedAlpha);
+
+	DXT3Block dxt3;
+	RandomDXT1Block(rng, &dxt3.color);
+	for (u16_le &line : dxt3.alphaLines)
+		line = (u16)rng.R32();
+	DecodeDXT3Block(out, &dxt3, pitch, w, h);
+	for (int y = 0; y < h; ++y) {
+		for (int x = 0; x < w; ++x)
+			EXPECT_EQ_HEX(out[y * pitch + x], GetDXT3Texel(&dxt3, x, y));
+	}
+
+	DXT5Block dxt5;
+	RandomDXT1Block(rng, &dxt5.color);
+	dxt5.alphadata2 = rng.R32();
+	dxt5.alphadata1 = (u16)rng.R32();
+	dxt5.alpha1 = (u8)rng.R32();
+	dxt5.alpha2 = (u8)rng.R32();
+	DecodeDXT5Block(out, &dxt5, pitch, w, h);
+	for (int y = 0; y < h; ++y) {
+		for (int x = 0; x < w; ++x)
+			EXPECT_EQ_HEX(out[y * pitch + x], GetDXT5Texel(&dxt5, x, y));
+	}
+	return true;
+}
+
+static bool TestTextureDecoderRandom() {
+	GMRng rng;
+	for (int i = 0; i < 2000; ++i) {
+		bool opaque = (i & 1) != 0;
+		RET(TestDeIndexTexture4<u32>(rng, opaque));
+		RET(TestDeIndexTexture4<u16>(rng, opaque));
+		RET(TestDXTBlocks(rng));
+	}
+	return true;
+}
+
+bool TestTextureDecoder() {
+	// The SIMD CLUT4 path is only used for simple clut indexing.
+	u32 oldClutFormat = gstate.clutformat;
+	gstate.clutformat = 0xC500FF00;
+
+	bool success = TestTextureDecoderRandom();
+#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+	// Also check the scalar fallbacks used without SSSE3.
+	if (success && cpu_info.bSSSE3) {
+		cpu_info.bSSSE3 = false;
+		success = TestTextureDecoderRandom();
+		cpu_info.bSSSE3 = true;
+	}
+#endif
+
+	gstate.clutformat = oldClutFormat;
+	return success;
+}
@@ -15,9 +15,13 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
+#include <cstring>
 #include <math.h>
+#include <vector>
 
 #include "Common/CommonTypes.h"
+#include "Common/Data/Random/Rng.h"
 #include "Common/TimeUtil.h"
 #include "Core/Config.h"
 #include "Core/ConfigValues.h"
@@ -27,6 +31,14 @@
 #include "unittest/TestVertexJit.h"
 #include "unittest/UnitTest.h"
 
+enum DecodePath {
+	DECODE_STEPS,
+	DECODE_SPECIALIZED,
+	DECODE_JIT,
+
+	DECODE_PATH_COUNT,
+};
+
 class VertexDecoderTestHarness {
 	static const int BUFFER_SIZE = 64 * 65536;
 	static const int ROUNDS = 200;
@@ -75,14 +87,14 @@ class VertexDecoderTestHarness {
 		indexLowerBound_ = lower;
 	}
 
-	void Execute(int vtype, int indexUpperBound, bool useJit) {
-		SetupExecute(vtype, useJit);
+	void Execute(int vtype, int indexUpperBound, DecodePath path) {
+		SetupExecute(vtype, path);
 
 		dec_->DecodeVerts(dst_, src_, indexLowerBound_, indexUpperBound);
 	}
 
-	double ExecuteTimed(int vtype, int indexUpperBound, bool useJit) {
-		SetupExecute(vtype, useJit);
+	double ExecuteTimed(int vtype, int indexUpperBound, DecodePath path) {
+		SetupExecute(vtype, path);
 
 		int total = 0;
 		double st = time_now_d();
@@ -266,13 +278,20 @@ class VertexDecoderTestHarness {
 		return assertFailed_;
 	}
 
+	bool IsSpecialized() const {
+		return dec_ && dec_->specialized_ != nullptr;
+	}
+
 private:
-	void SetupExecute(int vtype, bool useJit) {
+	void SetupExecute(int vtype, DecodePath path) {
 		if (dec_ != nullptr) {
 			delete dec_;
 		}
 		dec_ = new VertexDecoder();
-		dec_->SetVertexType(vtype, options_, useJit ? cache_ : nullptr);
+		dec_->SetVertexType(vtype, options_, path == DECODE_JIT ? cache_ : nullptr);
+		if (path == DECODE_STEPS) {
+			dec_->specialized_ = nullptr;
+		}
 		dstPos_ = 0;
 
 		needsReset_ = true;
@@ -299,8 +318,8 @@ static bool TestVertex8() {
 	dec.Add8(127, 0, 128);
 	dec.Add8(127, 0, 128);
 
-	for (int jit = 0; jit <= 1; ++jit) {
-		dec.Execute(vtype, 0, jit == 1);
+	for (int path = 0; path < DECODE_PATH_COUNT; ++path) {
+		dec.Execute(vtype, 0, (DecodePath)path);
 		dec.AssertFloat("TestVertex8-TC", 127.0f / 128.0f, 1.0f);
 		dec.Assert8("TestVertex8-Nrm", 127, 0, 128);
 		dec.Skip(1);
@@ -318,8 +337,8 @@ static bool TestVertex16() {
 	dec.Add16(32767, 0, 32768);
 	dec.Add16(32767, 0, 32768);
 
-	for (int jit = 0; jit <= 1; ++jit) {
-		dec.Execute(vtype, 0, jit == 1);
+	for (int path = 0; path < DECODE_PATH_COUNT; ++path) {
+		dec.Execute(vtype, 0, (DecodePath)path);
 		dec.AssertFloat("TestVertex16-TC", 32767.0f / 32768.0f, 1.0f);
 		dec.Assert16("TestVertex16-Nrm", 32767, 0, 32768);
 		dec.Skip(2);
@@ -337,8 +356,8 @@ static bool TestVertexFloat() {
 	dec.AddFloat(1.0f, 0.5f, -1.0f);
 	dec.AddFloat(1.0f, 0.5f, -1.0f);
 
-	for (int jit = 0; jit <= 1; ++jit) {
-		dec.Execute(vtype, 0, jit == 1);
+	for (int path = 0; path < DECODE_PATH_COUNT; ++path) {
+		dec.Execute(vtype, 0, (DecodePath)path);
 		dec.AssertFloat("TestVertexFloat-TC", 1.0f, -1.0f);
 		dec.AssertFloat("TestVertexFloat-Nrm", 1.0f, 0.5f, -1.0f);
 		dec.AssertFloat("TestVertexFloat-Pos", 1.0f, 0.5f, -1.0f);
@@ -355,8 +374,8 @@ static bool TestVertex8Through() {
 	dec.Add8(127, 0, 128);
 	dec.Add8(127, 0, 128);
 
-	for (int jit = 0; jit <= 1; ++jit) {
-		dec.Execute(vtype, 0, jit == 1);
+	for (int path = 0; path < DECODE_PATH_COUNT; ++path) {
+		dec.Execute(vtype, 0, (DecodePath)path);
 		// Note: this is correct, even in through.
 		dec.AssertFloat("TestVertex8Through-TC", 127.0f / 128.0f, 1.0f);
 		dec.Assert8("TestVertex8Through-Nrm", 127, 0, 128);
@@ -374,8 +393,8 @@ static bool TestVertex16Through() {
 	dec.Add16(32767, 0, 32768);
 	dec.Add16(32767, 0, 32768);
 
-	for (int jit = 0; jit <= 1; ++jit) {
-		dec.Execute(vtype, 0, jit == 1);
+	for (int path = 0; path < DECODE_PATH_COUNT; ++path) {
+		dec.Execute(vtype, 0, (DecodePath)path);
 		dec.AssertFloat("TestVertex16Through-TC", 32767.0f, 32768.0f);
 		dec.Assert16("TestVertex16Through-Nrm", 32767, 0, 32768);
 		dec.Skip(2);
@@ -393,8 +412,8 @@ static bool TestVertexFloatThrough() {
 	dec.AddFloat(1.0f, 0.5f, -1.0f);
 	dec.AddFloat(1.0f, 0.5f, -1.0f);
 
-	for (int jit = 0; jit <= 1; ++jit) {
-		dec.Execute(vtype, 0, jit == 1);
+	for (int path = 0; path < DECODE_PATH_COUNT; ++path) {
+		dec.Execute(vtype, 0, (DecodePath)path);
 		dec.AssertFloat("TestVertexFloatThrough-TC", 1.0f, -1.0f);
 		dec.AssertFloat("TestVertexFloatThrough-Nrm", 1.0f, 0.5f, -1.0f);
 		dec.AssertFloat("TestVertexFloatThrough-Pos", 1.0f, 0.5f, 0.0f);
@@ -411,9 +430,9 @@ static bool TestVertexColor8888() {
 	dec.Add8(1, 2, 3, 4);
 	dec.AddFloat(1.0f, 0.5f, -1.0f);
 
-	for (int jit = 0; jit <= 1; ++jit) {
+	for (int path = 0; path < DECODE_PATH_COUNT; ++path) {
 		gstate_c.vertexFullAlpha = true;
-		dec.Execute(vtype, 0, jit == 1);
+		dec.Execute(vtype, 0, (DecodePath)path);
 		dec.Assert8("TestVertexColor8888-Col", 1, 2, 3, 4);
 		dec.AssertFloat("TestVertexColor8888-Pos", 1.0f, 0.5f, -1.0f);
 
@@ -426,9 +445,9 @@ static bool TestVertexColor8888() {
 	dec.Add8(255, 255, 255, 255);
 	dec.AddFloat(1.0f, 0.5f, -1.0f);
 
-	for (int jit = 0; jit <= 1; ++jit) {
+	for (int path = 0; path < DECODE_PATH_COUNT; ++path) {
 		gstate_c.vertexFullAlpha = true;
-		dec.Execute(vtype, 0, jit == 1);
+		dec.Execute(vtype, 0, (DecodePath)path);
 		dec.Assert8("TestVertexColor8888-Col", 255, 255, 255, 255);
 		dec.AssertFloat("TestVertexColor8888-Pos", 1.0f, 0.5f, -1.0f);
 
@@ -449,9 +468,9 @@ static bool TestVertexColor4444() {
 	dec.Add16(0x1234, 0);
 	dec.AddFloat(1.0f, 0.5f, -1.0f);
 
-	for (int jit = 0; jit <= 1; ++jit) {
+	for (int path = 0; path < DECODE_PATH_COUNT; ++path) {
 		gstate_c.vertexFullAlpha = true;
-		dec.Execute(vtype, 0, jit == 1);
+		dec.Execute(vtype, 0, (DecodePath)path);
 		dec.Assert8("TestVertexColor4444-Col", 0x44, 0x33, 0x22, 0x11);
 		dec.AssertFloat("TestVertexColor4444-Pos", 1.0f, 0.5f, -1.0f);
 
@@ -464,9 +483,9 @@ static bool TestVertexColor4444() {
 	dec.Add16(0xFFFF, 0);
 	dec.AddFloat(1.0f, 0.5f, -1.0f);
 
-	for (int jit = 0; jit <= 1; ++jit) {
+	for (int path = 0; path < DECODE_PATH_COUNT; ++path) {
 		gstate_c.vertexFullAlpha = true;
-		dec.Execute(vtype, 0, jit == 1);
+		dec.Execute(vtype, 0, (DecodePath)path);
 		dec.Assert8("TestVertexColor4444-Col", 255, 255, 255, 255);
 		dec.AssertFloat("TestVertexColor4444-Pos", 1.0f, 0.5f, -1.0f);
 
@@ -487,9 +506,9 @@ static bool TestVertexColor5551() {
 	dec.Add16((0 << 15) | (1 << 10) | (2 << 5) | 3, 0);
 	dec.AddFloat(1.0f, 0.5f, -1.0f);
 
-	for (int jit = 0; jit <= 1; ++jit) {
+	for (int path = 0; path < DECODE_PATH_COUNT; ++path) {
 		gstate_c.vertexFullAlpha = true;
-		dec.Execute(vtype, 0, jit == 1);
+		dec.Execute(vtype, 0, (DecodePath)path);
 		dec.Assert8("TestVertexColor5551-Col", 0x18, 0x10, 0x8, 0x0);
 		dec.AssertFloat("TestVertexColor5551-Pos", 1.0f, 0.5f, -1.0f);
 
@@ -502,9 +521,9 @@ static bool TestVertexColor5551() {
 	dec.Add16(0xFFFF, 0);
 	dec.AddFloat(1.0f, 0.5f, -1.0f);
 
-	for (int jit = 0; jit <= 1; ++jit) {
+	for (int path = 0; path < DECODE_PATH_COUNT; ++path) {
 		gstate_c.vertexFullAlpha = true;
-		dec.Execute(vtype, 0, jit == 1);
+		dec.Execute(vtype, 0, (DecodePath)path);
 		dec.Assert8("TestVertexColor5551-Col", 255, 255, 255, 255);
 		dec.AssertFloat("TestVertexColor5551-Pos", 1.0f, 0.5f, -1.0f);
 
@@ -525,9 +544,9 @@ static bool TestVertexColor565() {
 	dec.Add16((1 << 11) | (2 << 5) | 3, 0);
 	dec.AddFloat(1.0f, 0.5f, -1.0f);
 
-	for (int jit = 0; jit <= 1; ++jit) {
+	for (int path = 0; path < DECODE_PATH_COUNT; ++path) {
 		gstate_c.vertexFullAlpha = true;
-		dec.Execute(vtype, 0, jit == 1);
+		dec.Execute(vtype, 0, (DecodePath)path);
 		dec.Assert8("TestVertexColor565-Col", 0x18, 0x8, 0x8, 255);
 		dec.AssertFloat("TestVertexColor565-Pos", 1.0f, 0.5f, -1.0f);
 
@@ -563,8 +582,8 @@ static bool TestVertex8Skin() {
 	dec.Add8(127, 0, 128);
 	dec.Add8(127, 0, 128);
 
-	for (int jit = 0; jit <= 1; ++jit) {
-		dec.Execute(vtype, 0, jit == 1);
+	for (int path = 0; path < DECODE_PATH_COUNT; ++path) {
+		dec.Execute(vtype, 0, (DecodePath)path);
 		dec.AssertFloat("TestVertex8Skin-Nrm", (2.0f * 1.5f + 1.0f * 0.5f) * 127.0f / 128.0f, 0.0f, 2.0f * 5.0f * -1.0f);
 		dec.AssertFloat("TestVertex8Skin-Pos", (2.0f * 1.5f + 1.0f * 0.5f) * 127.0f / 128.0f, 0.0f, 2.0f * 5.0f * -1.0f);
 	}
@@ -595,8 +614,8 @@ static bool TestVertex16Skin() {
 	dec.Add16(32767, 0, 32768);
 	dec.Add16(32767, 0, 32768);
 
-	for (int jit = 0; jit <= 1; ++jit) {
-		dec.Execute(vtype, 0, jit == 1);
+	for (int path = 0; path < DECODE_PATH_COUNT; ++path) {
+		dec.Execute(vtype, 0, (DecodePath)path);
 		dec.AssertFloat("TestVertex16Skin-Nrm", (2.0f * 1.5f + 1.0f * 0.5f) * 32767.0f / 32768.0f, 0.0f, 2.0f * 5.0f * -1.0f);
 		dec.AssertFloat("TestVertex16Skin-Pos", (2.0f * 1.5f + 1.0f * 0.5f) * 32767.0f / 32768.0f, 0.0f, 2.0f * 5.0f * -1.0f);
 	}
@@ -627,8 +646,8 @@ static bool TestVertexFloatSkin() {
 	dec.AddFloat(1.0f, 0, -1.0f);
 	dec.AddFloat(1.0f, 0, -1.0f);
 
-	for (int jit = 0; jit <= 1; ++jit) {
-		dec.Execute(vtype, 0, jit == 1);
+	for (int path = 0; path < DECODE_PATH_COUNT; ++path) {
+		dec.Execute(vtype, 0, (DecodePath)path);
 		dec.AssertFloat("TestVertexFloatSkin-Nrm", (2.0f * 1.5f + 1.0f * 0.5f) * 1.0f, 0.0f, 2.0f * 5.0f * -1.0f);
 		dec.AssertFloat("TestVertexFloatSkin-Pos", (2.0f * 1.5f + 1.0f * 0.5f) * 1.0f, 0.0f, 2.0f * 5.0f * -1.0f);
 	}
@@ -638,6 +657,121 @@ static bool TestVertexFloatSkin() {
 
 // TODO: Morph (col, pos, nrm), weights (no skin), morph + weights?
 
+template <typename T>
+static bool TestIndexBoundsType(GMRng &rng, u32 vtype, u32 maxIndex) {
+	// Room for an unaligned start and a tail after the SIMD part.
+	T buffer[128 + 16];
+	for (int iter = 0; iter < 500; ++iter) {
+		int offset = rng.R32() % 16;
+		int count = rng.R32() % 128;
+		if ((iter & 3) == 0)
+			count |= 1;
+		T *inds = buffer + offset;
+
+		// Sometimes a narrow range, so the extremes are more likely to be only in the tail.
+		u32 base = rng.R32() % (maxIndex + 1);
+		u32 range = (iter & 1) ? maxIndex + 1 : 8;
+		for (int i = 0; i < count; ++i)
+			inds[i] = (T)std::min(maxIndex, base + rng.R32() % range);
+		if (count != 0 && (iter & 7) == 0)
+			inds[count - 1] = (T)((iter & 8) ? maxIndex : 0);
+
+		int expectedLower = 0x7FFFFFFF;
+		int expectedUpper = 0;
+		for (int i = 0; i < count; ++i) {
+			expectedLower = std::min(expectedLower, (int)inds[i]);
+			expectedUpper = std::max(expectedUpper, (int)inds[i]);
+		}
+
+		u16 lower, upper;
+		GetIndexBounds(inds, count, vtype, &lower, &upper);
+		if (lower != (u16)expectedLower || upper != (u16)expectedUpper) {
+			printf("GetIndexBounds (%d bytes): count %d offset %d: %d-%d, expected %d-%d\n", (int)sizeof(T), count, offset, lower, upper, (u16)expectedLower, (u16)expectedUpper);
+			return false;
+		}
+	}
+	return true;
+}
+
+struct SpecializedDecoderCase {
+	const char *name;
+	u32 vtype;
+	bool expand8BitNormalsToFloat;
+};
+
+// One per entry in specializedDecoders, in the same order.
+static const SpecializedDecoderCase specializedDecoderCases[] = {
+	{ "TC16/NRM16/POS16", GE_VTYPE_TC_16BIT | GE_VTYPE_NRM_16BIT | GE_VTYPE_POS_16BIT },
+	{ "TC16/NRM8/POS16", GE_VTYPE_TC_16BIT | GE_VTYPE_NRM_8BIT | GE_VTYPE_POS_16BIT },
+	{ "TC16/NRM8ToFloat/POS16", GE_VTYPE_TC_16BIT | GE_VTYPE_NRM_8BIT | GE_VTYPE_POS_16BIT, true },
+	{ "TC16/NRMF/POSF", GE_VTYPE_TC_16BIT | GE_VTYPE_NRM_FLOAT | GE_VTYPE_POS_FLOAT },
+	{ "TC16/COL8888/POS16", GE_VTYPE_TC_16BIT | GE_VTYPE_COL_8888 | GE_VTYPE_POS_16BIT },
+	{ "TC16/POS16", GE_VTYPE_TC_16BIT | GE_VTYPE_POS_16BIT },
+	{ "TC8/NRM8/POS8", GE_VTYPE_TC_8BIT | GE_VTYPE_NRM_8BIT | GE_VTYPE_POS_8BIT },
+	{ "TCF/NRMF/POSF", GE_VTYPE_TC_FLOAT | GE_VTYPE_NRM_FLOAT | GE_VTYPE_POS_FLOAT },
+	{ "TCF/COL8888/POSF", GE_VTYPE_TC_FLOAT | GE_VTYPE_COL_8888 | GE_VTYPE_POS_FLOAT },
+	{ "TCF/POSF", GE_VTYPE_TC_FLOAT | GE_VTYPE_POS_FLOAT },
+	{ "NRM16/POS16", GE_VTYPE_NRM_16BIT | GE_VTYPE_POS_16BIT },
+	{ "NRMF/POSF", GE_VTYPE_NRM_FLOAT | GE_VTYPE_POS_FLOAT },
+	{ "COL8888/POS16", GE_VTYPE_COL_8888 | GE_VTYPE_POS_16BIT },
+	{ "COL8888/POSF", GE_VTYPE_COL_8888 | GE_VTYPE_POS_FLOAT },
+	{ "POS16", GE_VTYPE_POS_16BIT },
+	{ "POSF", GE_VTYPE_POS_FLOAT },
+
+	{ "TC16/COL8888/POS16 through", GE_VTYPE_TC_16BIT | GE_VTYPE_COL_8888 | GE_VTYPE_POS_16BIT | GE_VTYPE_THROUGH },
+	{ "TC16/COL4444/POS16 through", GE_VTYPE_TC_16BIT | GE_VTYPE_COL_4444 | GE_VTYPE_POS_16BIT | GE_VTYPE_THROUGH },
+	{ "TC16/COL5551/POS16 through", GE_VTYPE_TC_16BIT | GE_VTYPE_COL_5551 | GE_VTYPE_POS_16BIT | GE_VTYPE_THROUGH },
+	{ "TC16/POS16 through", GE_VTYPE_TC_16BIT | GE_VTYPE_POS_16BIT | GE_VTYPE_THROUGH },
+	{ "TCF/COL8888/POSF through", GE_VTYPE_TC_FLOAT | GE_VTYPE_COL_8888 | GE_VTYPE_POS_FLOAT | GE_VTYPE_THROUGH },
+	{ "TCF/POSF through", GE_VTYPE_TC_FLOAT | GE_VTYPE_POS_FLOAT | GE_VTYPE_THROUGH },
+	{ "COL8888/POS16 through", GE_VTYPE_COL_8888 | GE_VTYPE_POS_16BIT | GE_VTYPE_THROUGH },
+	{ "COL8888/POSF through", GE_VTYPE_COL_8888 | GE_VTYPE_POS_FLOAT | GE_VTYPE_THROUGH },
+	{ "POS16 through", GE_VTYPE_POS_16BIT | GE_VTYPE_THROUGH },
+	{ "POSF through", GE_VTYPE_POS_FLOAT | GE_VTYPE_THROUGH },
+};
+
+// Each must pick a specialized decoder, and match the steps exactly.
+static bool TestSpecializedDecoders() {
+	static const int COUNT = 64;
+	VertexDecoderTestHarness dec;
+	GMRng rng;
+	bool pass = true;
+	for (const SpecializedDecoderCase &test : specializedDecoderCases) {
+		VertexDecoderOptions opts{};
+		opts.expand8BitNormalsToFloat = test.expand8BitNormalsToFloat;
+		dec.SetOptions(opts);
+		// Clearing bit 6 of each byte keeps any float finite.
+		for (int i = 0; i < COUNT * 64; ++i)
+			dec.Add8((u8)(rng.R32() & 0xBF));
+
+		dec.Execute(test.vtype, COUNT - 1, DECODE_STEPS);
+		size_t bytes = dec.GetDstStride() * COUNT;
+		std::vector<u8> expected((const u8 *)dec.GetData(), (const u8 *)dec.GetData() + bytes);
+
+		dec.Execute(test.vtype, COUNT - 1, DECODE_SPECIALIZED);
+		if (!dec.IsSpecialized()) {
+			printf("%s: No specialized decoder\n", test.name);
+			pass = false;
+		} else if (memcmp(dec.GetData(), expected.data(), bytes) != 0) {
+			printf("%s: Specialized decoder doesn't match steps\n", test.name);
+			pass = false;
+		}
+	}
+	return pass;
+}
+
+// The SIMD part must agree with a plain scalar scan.
+static bool TestIndexBounds() {
+	GMRng rng;
+	if (!TestIndexBoundsType<u8>(rng, GE_VTYPE_IDX_8BIT, 0xFF))
+		return false;
+	if (!TestIndexBoundsType<u16>(rng, GE_VTYPE_IDX_16BIT, 0xFFFF))
+		return false;
+	if (!TestIndexBoundsType<u32>(rng, GE_VTYPE_IDX_32BIT, 0xFFFF))
+		return false;
+	return true;
+}
+
 typedef bool (*VertexTestFunc)();
 
 static VertexTestFunc vertdecTestFuncs[] = {
@@ -657,8 +791,18 @@ static VertexTestFunc vertdecTestFuncs[] = {
 	&TestVertex8Skin,
 	&TestVertex16Skin,
 	&TestVertexFloatSkin,
+
+	&TestSpecializedDecoders,
+	&TestIndexBounds,
 };
 
+static void BenchmarkVertexDecoder(VertexDecoderTestHarness &dec, const char *name, int vtype, int count) {
+	double steps = dec.ExecuteTimed(vtype, count, DECODE_STEPS);
+	double specialized = dec.ExecuteTimed(vtype, count, DECODE_SPECIALIZED);
+	double jit = dec.ExecuteTimed(vtype, count, DECODE_JIT);
+	printf("%s: specialized was %fx and jit %fx faster than steps.\n", name, specialized / steps, jit / steps);
+}
+
 bool TestVertexJit() {
 	VertexDecoderTestHarness dec;
 	/*for (int i = 0; i < 100; ++i) {
@@ -673,14 +817,30 @@ bool TestVertexJit() {
 		dec.Add8(127, 0, 128);
 	}
 	int vtype = GE_VTYPE_POS_8BIT;
-	double yesJit = dec.ExecuteTimed(vtype, 100, true);
-	double noJit = dec.ExecuteTimed(vtype, 100, false);
+	double yesJit = dec.ExecuteTimed(vtype, 100, DECODE_JIT);
+	double noJit = dec.ExecuteTimed(vtype, 100, DECODE_STEPS);
 
 	float x = dec.GetFloat();
 	float y = dec.GetFloat();
 	float z = dec.GetFloat();
 	printf("Result: %f, %f, %f\n", x, y, z);
-	printf("Jit was %fx faster than steps.\n\n", yesJit / noJit);
+	printf("Jit was %fx faster than steps.\n", yesJit / noJit);
+
+	// Typical 3D model and 2D sprite formats, both with specialized decoders.
+	for (int i = 0; i < 100; ++i) {
+		dec.Add16(32767, 32768);
+		dec.Add16(32767, 0, 32768);
+		dec.Add16(32767, 0, 32768);
+	}
+	BenchmarkVertexDecoder(dec, "TC16/NRM16/POS16", GE_VTYPE_TC_16BIT | GE_VTYPE_NRM_16BIT | GE_VTYPE_POS_16BIT, 100);
+	for (int i = 0; i < 100; ++i) {
+		dec.Add16(32767, 32768);
+		dec.Add8(1, 2, 3, 4);
+		dec.Add16(32767, 0, 32768);
+		dec.Add16(0);
+	}
+	BenchmarkVertexDecoder(dec, "TC16/COL8888/POS16 through", GE_VTYPE_TC_16BIT | GE_VTYPE_COL_8888 | GE_VTYPE_POS_16BIT | GE_VTYPE_THROUGH, 100);
+	printf("\n");
 
 	bool pass = true;
 	for (size_t i = 0; i < ARRAY_SIZE(vertdecTestFuncs); ++i) {